@@ -5,12 +5,13 @@
 #define ALIST_HPP
 
 #include <cstddef>
-#include <memory>
 #include <utility>
+#include <vector>
 
 #include "scic/codegen/anode.hpp"
 #include "scic/codegen/list.hpp"
 #include "scic/codegen/listing.hpp"
+#include "scic/codegen/node_arena.hpp"
 #include "scic/codegen/output.hpp"
 
 namespace codegen {
@@ -20,11 +21,7 @@ class AList {
  public:
   // AList (assembly list) is a list of ANodes (assembly nodes).
 
-  size_t length() const {
-    size_t s = 0;
-    for (auto it = iter(); it; ++it) s++;
-    return s;
-  }
+  size_t length() const { return length_; }
 
   TList<T>::iterator iter() { return list_.begin(); }
   TList<T>::const_iterator iter() const { return list_.begin(); }
@@ -40,50 +37,80 @@ class AList {
     return list_.findIter(node);
   }
 
-  T* addFront(std::unique_ptr<T> node) {
-    return list_.addFront(std::move(node));
-  }
+  // The arena that new nodes are allocated from. Lists of nodes created by
+  // newNode() share their parent list's arena.
+  NodeArena* arena() const { return list_.arena(); }
+  void setArena(NodeArena* arena) { list_.setArena(arena); }
+
+  // The composite node whose children are in the list, if any. New nodes
+  // become its children.
+  void setOwner(ANode* owner) { owner_ = owner; }
 
   template <class U, class... Args>
     requires std::convertible_to<U*, T*>
   U* newNode(Args&&... args) {
-    auto node = std::make_unique<U>(std::forward<Args>(args)...);
-    auto* node_ptr = node.get();
-    list_.addBack(std::move(node));
-    return node_ptr;
+    auto* node = list_.arena()->template New<U>(std::forward<Args>(args)...);
+    if constexpr (requires { node->getList()->setArena(list_.arena()); }) {
+      node->getList()->setArena(list_.arena());
+    }
+    list_.addBack(node);
+    ++length_;
+    node->parent = owner_;
+    node->invalidateLayout();
+    return node;
   }
 
  private:
   TList<T> list_;
+  size_t length_ = 0;
+  ANode* owner_ = nullptr;
 };
 
 using ANodeList = AList<ANode>;
-using AOpList = AList<ANOpCode>;
 
 template <class T>
 struct ANComposite : ANode {
  public:
+  // A composite caches the size of its children as of the last time they
+  // were laid out.  Children that change size mark it, and every composite
+  // above it, as dirty.  A clean composite laid out again at the same offset
+  // keeps its children where they are.
+  ANComposite() { list_.setOwner(this); }
+
   size_t size() const override {
+    if (!dirty_) {
+      return size_;
+    }
     size_t s = 0;
     for (auto const& node : list_) s += node.size();
     return s;
   }
 
   size_t setOffset(size_t ofs) override {
+    if (!dirty_ && offset == ofs) {
+      return ofs + size_;
+    }
+
     offset = ofs;
     for (auto& node : list_) {
       ofs = node.setOffset(ofs);
     }
 
+    size_ = ofs - *offset;
+    dirty_ = false;
     return ofs;
   }
 
-  bool tryShrink() override {
-    bool changed = false;
+  bool markLayoutDirty() override {
+    bool was_clean = !dirty_;
+    dirty_ = true;
+    return was_clean;
+  }
+
+  void collectCode(std::vector<CodeBuffer*>* buffers) override {
     for (auto& node : list_) {
-      changed |= node.tryShrink();
+      node.collectCode(buffers);
     }
-    return changed;
   }
 
   void list(ListingFile* listFile) const override {
@@ -104,12 +131,11 @@ struct ANComposite : ANode {
     }
   }
 
-  bool contains(ANode const* node) const override {
-    if (ANode::contains(node)) return true;
+  void collectNodes(ANodeSet* nodes) const override {
+    ANode::collectNodes(nodes);
     for (auto const& entry : list_) {
-      if (entry.contains(node)) return true;
+      entry.collectNodes(nodes);
     }
-    return false;
   }
 
   bool optimize() override {
@@ -124,6 +150,8 @@ struct ANComposite : ANode {
 
  private:
   AList<T> list_;
+  size_t size_ = 0;
+  bool dirty_ = true;
 };
 
 }  // namespace codegen
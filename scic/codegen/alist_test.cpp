@@ -0,0 +1,74 @@
+#include "scic/codegen/alist.hpp"
+
+#include <cstddef>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/anode.hpp"
+#include "scic/codegen/node_arena.hpp"
+
+namespace codegen {
+namespace {
+
+// A node of a given size, which counts how often it is laid out.
+struct SizedNode : ANode {
+  explicit SizedNode(std::size_t size) : size_(size) {}
+
+  size_t size() const override { return size_; }
+  size_t setOffset(size_t ofs) override {
+    ++num_layouts;
+    return ANode::setOffset(ofs);
+  }
+
+  void resize(std::size_t size) {
+    size_ = size;
+    invalidateLayout();
+  }
+
+  std::size_t size_;
+  int num_layouts = 0;
+};
+
+TEST(ANCompositeTest, SkipsUnchangedSubtrees) {
+  NodeArena arena;
+  auto* root = arena.New<ANComposite<ANode>>();
+  root->getList()->setArena(&arena);
+  auto* first = root->getList()->newNode<ANComposite<ANode>>();
+  auto* a = first->getList()->newNode<SizedNode>(3);
+  auto* second = root->getList()->newNode<ANComposite<ANode>>();
+  auto* b = second->getList()->newNode<SizedNode>(4);
+  auto* c = second->getList()->newNode<SizedNode>(5);
+
+  EXPECT_EQ(root->setOffset(0), 12);
+  EXPECT_EQ(root->size(), 12);
+  EXPECT_EQ(*c->offset, 7);
+
+  // Laying out again at the same offset touches nothing.
+  EXPECT_EQ(root->setOffset(0), 12);
+  EXPECT_EQ(a->num_layouts, 1);
+  EXPECT_EQ(b->num_layouts, 1);
+
+  // Resizing a node only lays out the subtrees that contain it.
+  b->resize(2);
+  EXPECT_EQ(root->size(), 10);
+  EXPECT_EQ(root->setOffset(0), 10);
+  EXPECT_EQ(*c->offset, 5);
+  EXPECT_EQ(a->num_layouts, 1);
+  EXPECT_EQ(b->num_layouts, 2);
+  EXPECT_EQ(c->num_layouts, 2);
+}
+
+TEST(ANCompositeTest, AddingANodeInvalidatesLayout) {
+  NodeArena arena;
+  auto* root = arena.New<ANComposite<ANode>>();
+  root->getList()->setArena(&arena);
+  auto* inner = root->getList()->newNode<ANComposite<ANode>>();
+  inner->getList()->newNode<SizedNode>(2);
+
+  EXPECT_EQ(root->setOffset(0), 2);
+  inner->getList()->newNode<SizedNode>(6);
+  EXPECT_EQ(root->setOffset(0), 8);
+  EXPECT_EQ(inner->getList()->length(), 2);
+}
+
+}  // namespace
+}  // namespace codegen
@@ -1,7 +1,7 @@
 #include "anode.hpp"
 
 #include <cstddef>
-#include <cstdint>
+#include <vector>
 
 #include "scic/codegen/listing.hpp"
 #include "scic/codegen/output.hpp"
@@ -19,7 +19,7 @@ size_t ANode::setOffset(size_t ofs) {
   return ofs + size();
 }
 
-bool ANode::tryShrink() { return false; };
+void ANode::collectCode(std::vector<CodeBuffer*>*) {}
 
 void ANode::collectFixups(FixupContext*) const {}
 
@@ -27,22 +27,16 @@ void ANode::emit(OutputWriter*) const {}
 
 void ANode::list(ListingFile* listFile) const {}
 
-bool ANode::contains(ANode const* node) const { return this == node; }
+void ANode::collectNodes(ANodeSet* nodes) const { nodes->insert(this); }
 
 bool ANode::optimize() { return false; }
 
-///////////////////////////////////////////////////
-// Class ANOpCode
-///////////////////////////////////////////////////
-
-ANOpCode::ANOpCode(std::uint32_t o) : op(o) {}
-
-size_t ANOpCode::size() const { return 1; }
-
-void ANOpCode::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
+void ANode::invalidateLayout() {
+  for (auto* node = parent; node && node->markLayoutDirty();
+       node = node->parent) {
+  }
 }
 
-void ANOpCode::emit(OutputWriter* out) const { out->WriteOp(op); }
+bool ANode::markLayoutDirty() { return true; }
 
 }  // namespace codegen
@@ -2,9 +2,10 @@
 #define ANODE_HPP
 
 #include <cstddef>
-#include <cstdint>
 #include <optional>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "scic/codegen/list.hpp"
 #include "scic/codegen/listing.hpp"
 #include "scic/codegen/output.hpp"
@@ -12,6 +13,9 @@
 namespace codegen {
 
 struct ANode;
+class CodeBuffer;
+
+using ANodeSet = absl::flat_hash_set<ANode const*>;
 
 class FixupContext {
  public:
@@ -40,9 +44,9 @@ struct ANode : TNode {
   // passed, and (using size()) returns the offset of the
   // byte following the node.
 
-  // Try to shrink the node to a smaller size.  Returns true if
-  // the node was shrunk, false if it was not.
-  virtual bool tryShrink();
+  // Adds the instruction buffer of this node, and of every node it
+  // contains, to buffers.
+  virtual void collectCode(std::vector<CodeBuffer*>* buffers);
 
   virtual void list(ListingFile* listFile) const;
   // Writes a representation of the node to the listing file.
@@ -53,29 +57,25 @@ struct ANode : TNode {
   virtual void emit(OutputWriter*) const;
   // Emits the object code for the node to the output file.
 
-  virtual bool contains(ANode const* node) const;
+  // Adds this node, and every node it contains, to the set.
+  virtual void collectNodes(ANodeSet* nodes) const;
 
   virtual bool optimize();
   // Applies some optimizations to the node.  This is not
   // really implemented for each node type yet -- most
   // optimization is done in OptimizeProc() in optimize.cpp.
 
-  std::optional<size_t> offset;  // offset of node in file
-};
+  // Tells the composites containing the node that its size has changed, so
+  // they have to lay out their children again.  A node whose size changes
+  // after it has been laid out must call this.
+  void invalidateLayout();
 
-struct ANOpCode : ANode
-// This is the generic class for an opcode taking no parameters.  Opcodes
-// requiring parameters are subclassed from this.  The property 'op' contains
-// the opcode.
-{
-  ANOpCode() = default;
-  ANOpCode(uint32_t o);
+  // Marks a cached layout as out of date.  Returns false if it already was,
+  // in which case the containing composites already know.
+  virtual bool markLayoutDirty();
 
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  uint32_t op;  // type of operator
+  std::optional<size_t> offset;  // offset of node in file
+  ANode* parent = nullptr;       // composite the node belongs to, if any
 };
 
 }  // namespace codegen
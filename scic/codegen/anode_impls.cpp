@@ -3,41 +3,25 @@
 
 #include "scic/codegen/anode_impls.hpp"
 
-#include <algorithm>
 #include <cstdint>
-#include <cstdlib>
-#include <cstring>
 #include <optional>
-#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
-#include "absl/strings/str_format.h"
 #include "scic/codegen/alist.hpp"
 #include "scic/codegen/anode.hpp"
+#include "scic/codegen/code_buffer.hpp"
 #include "scic/codegen/common.hpp"
 #include "scic/codegen/listing.hpp"
-#include "scic/codegen/opcodes.hpp"
+#include "scic/codegen/name_table.hpp"
 #include "scic/codegen/optimize.hpp"
 #include "scic/codegen/output.hpp"
 #include "scic/codegen/target.hpp"
 
 namespace codegen {
 
-#define OPTIMIZE_TRANSFERS
-
-static bool canOptimizeTransfer(size_t a, size_t b) {
-  size_t larger = std::max(a, b);
-  size_t smaller = std::min(a, b);
-
-  return (larger - smaller) < 128;
-}
-
-// In SCI 1.1 and earlier, Calls and Sends wrote the number of args as
-// one byte.  In SCI 2, it's two bytes.  These functions abstract those
-// architecture differences out.
-
 ///////////////////////////////////////////////////
 // Class ANDispatch
 ///////////////////////////////////////////////////
@@ -129,11 +113,35 @@ void ANObject::list(ListingFile* listFile) const {
 // Class ANCodeBlk
 ///////////////////////////////////////////////////
 
-ANCodeBlk::ANCodeBlk(std::string name) : name(std::move(name)) {
-  ANLabel::reset();
+ANCodeBlk::ANCodeBlk(SciTargetStrategy const* sci_target, NameTable* names,
+                     std::string name)
+    : name(std::move(name)), code(sci_target, names, this) {}
+
+size_t ANCodeBlk::size() const { return code.byteSize(); }
+
+size_t ANCodeBlk::setOffset(size_t ofs) {
+  offset = ofs;
+  return code.setOffset(ofs);
+}
+
+void ANCodeBlk::collectCode(std::vector<CodeBuffer*>* buffers) {
+  buffers->push_back(&code);
+}
+
+void ANCodeBlk::list(ListingFile* listFile) const { code.list(listFile); }
+
+void ANCodeBlk::collectFixups(FixupContext* fixup_ctxt) const {
+  code.collectFixups(fixup_ctxt, this, *offset);
 }
 
-bool ANCodeBlk::optimize() { return OptimizeProc(getList()); }
+void ANCodeBlk::emit(OutputWriter* out) const { code.emit(out); }
+
+bool ANCodeBlk::optimize() {
+  auto nOptimizations = OptimizeProc(&code);
+  nOptimizations += ThreadJumps(&code);
+  nOptimizations += RemoveDeadCode(&code);
+  return nOptimizations != 0;
+}
 
 ///////////////////////////////////////////////////
 // Class ANProcCode
@@ -148,8 +156,10 @@ void ANProcCode::list(ListingFile* listFile) const {
 // Class ANMethCode
 ///////////////////////////////////////////////////
 
-ANMethCode::ANMethCode(std::string name, std::string obj_name)
-    : ANCodeBlk(std::move(name)), obj_name(std::move(obj_name)) {}
+ANMethCode::ANMethCode(SciTargetStrategy const* sci_target, NameTable* names,
+                       std::string name, std::string obj_name)
+    : ANCodeBlk(sci_target, names, std::move(name)),
+      obj_name(std::move(obj_name)) {}
 
 void ANMethCode::list(ListingFile* listFile) const {
   listFile->Listing("\n\nMethod: (%s %s)\n", obj_name, name);
@@ -189,432 +199,4 @@ std::string_view ANMethod::desc() const { return "local"; }
 
 uint32_t ANMethod::value() const { return *method->offset; }
 
-///////////////////////////////////////////////////
-// Class ANLabel
-///////////////////////////////////////////////////
-
-uint32_t ANLabel::nextLabel = 0;
-
-ANLabel::ANLabel() : ANOpCode(OP_LABEL), number(nextLabel++) {}
-
-size_t ANLabel::size() const { return 0; }
-
-void ANLabel::list(ListingFile* listFile) const {
-  listFile->Listing(".%d", number);
-}
-
-void ANLabel::emit(OutputWriter*) const {}
-
-///////////////////////////////////////////////////
-// Class ANOpUnsign
-///////////////////////////////////////////////////
-
-ANOpUnsign::ANOpUnsign(uint32_t o, uint32_t v) {
-  value = v;
-#if defined(OPTIMIZE_TRANSFERS)
-  op = o | (value < 256 ? OP_BYTE : 0);
-#else
-  if (o == op_link || o == op_class)
-    op = o | (value < 256 ? OP_BYTE : 0);
-  else
-    op = o | (value < 128 ? OP_BYTE : 0);
-#endif
-  name = std::nullopt;
-}
-
-size_t ANOpUnsign::size() const { return op & OP_BYTE ? 2 : 3; }
-
-void ANOpUnsign::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  if (!name)
-    listFile->ListArg("$%-4x", (SCIUWord)value);
-  else
-    listFile->ListArg("$%-4x\t(%s)", (SCIUWord)value, *name);
-}
-
-void ANOpUnsign::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  if (op & OP_BYTE)
-    out->WriteByte(value);
-  else
-    out->WriteWord(value);
-}
-
-///////////////////////////////////////////////////
-// Class ANOpSign
-///////////////////////////////////////////////////
-
-ANOpSign::ANOpSign(uint32_t o, int v) {
-  value = v;
-  op = o | ((uint32_t)abs(value) < 128 ? OP_BYTE : 0);
-}
-
-size_t ANOpSign::size() const { return op & OP_BYTE ? 2 : 3; }
-
-void ANOpSign::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  if (!name)
-    listFile->ListArg("$%-4x", (SCIUWord)value);
-  else
-    listFile->ListArg("$%-4x\t(%s)", (SCIUWord)value, *name);
-}
-
-void ANOpSign::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  if (op & OP_BYTE)
-    out->WriteByte(value);
-  else
-    out->WriteWord(value);
-}
-
-///////////////////////////////////////////////////
-// Class ANOpExtern
-///////////////////////////////////////////////////
-
-uint8_t GetExternOp(int32_t module, uint32_t entry) {
-  if (module == -1) {
-    return op_callk | (entry < 256 ? OP_BYTE : 0);
-  }
-
-  if (module == 0) {
-    return op_callb | (entry < 256 ? OP_BYTE : 0);
-  }
-
-  if (module < 0) {
-    throw std::runtime_error("Invalid module number");
-  }
-
-  return op_calle | (module < 256 && entry < 256 ? OP_BYTE : 0);
-}
-
-ANOpExtern::ANOpExtern(std::string name, SciTargetStrategy const* sci_target,
-                       int32_t m, uint32_t e)
-    : sci_target(sci_target), module(m), entry(e), name(std::move(name)) {
-  op = GetExternOp(module, entry);
-}
-
-size_t ANOpExtern::size() const {
-  int arg_size = sci_target->NumArgsSize();
-
-  switch (op & ~OP_BYTE) {
-    case op_callk:
-    case op_callb:
-      return (op & OP_BYTE ? 2 : 3) + arg_size;
-    case op_calle:
-      return (op & OP_BYTE ? 3 : 5) + arg_size;
-    default:
-      return 0;
-  }
-}
-
-void ANOpExtern::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  switch (op & ~OP_BYTE) {
-    case op_callk:
-    case op_callb:
-      listFile->ListArg("$%-4x\t(%s)", (SCIUWord)entry, name);
-      break;
-    case op_calle:
-      listFile->ListArg("$%x/%x\t(%s)", (SCIUWord)module, (SCIUWord)entry,
-                        name);
-  }
-  sci_target->ListNumArgs(listFile, *offset + 1, numArgs);
-}
-
-void ANOpExtern::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  if ((op & ~OP_BYTE) == op_calle) {
-    if (op & OP_BYTE)
-      out->WriteByte(module);
-    else
-      out->WriteWord(module);
-  }
-
-  if (op & OP_BYTE)
-    out->WriteByte(entry);
-  else
-    out->WriteWord(entry);
-  sci_target->WriteNumArgs(out, numArgs);
-}
-
-///////////////////////////////////////////////////
-// Class ANCall
-///////////////////////////////////////////////////
-
-ANCall::ANCall(std::string name, SciTargetStrategy const* sci_target)
-    : ANOpCode(op_call),
-      sci_target(sci_target),
-      name(std::move(name)),
-      target(nullptr) {}
-
-size_t ANCall::size() const {
-  int arg_size = sci_target->NumArgsSize();
-
-  return (op & OP_BYTE ? 2 : 3) + arg_size;
-}
-
-bool ANCall::tryShrink() {
-  auto initial_size = size();
-
-  if (!target || !target->offset.has_value()) {
-    return false;
-  }
-
-#if defined(OPTIMIZE_TRANSFERS)
-  if (canOptimizeTransfer(*target->offset, *offset + 5)) {
-    op |= OP_BYTE;
-  } else
-#endif
-  {
-    op &= ~OP_BYTE;
-  }
-
-  return size() < initial_size;
-}
-
-void ANCall::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op_call);
-  listFile->ListArg("$%-4x\t(%s)",
-                    SCIUWord(*target->offset - (*offset + size())), name);
-  sci_target->ListNumArgs(listFile, *offset + 1, numArgs);
-}
-
-void ANCall::emit(OutputWriter* out) const {
-  if (!target || !target->offset.has_value()) {
-    throw std::runtime_error(absl::StrFormat("Undefined procedure: %s", name));
-    return;
-  }
-
-  int n = *target->offset - (*offset + size());
-  out->WriteOp(op);
-  if (op & OP_BYTE)
-    out->WriteByte(n);
-  else
-    out->WriteWord(n);
-  sci_target->WriteNumArgs(out, numArgs);
-}
-
-///////////////////////////////////////////////////
-// Class ANBranch
-///////////////////////////////////////////////////
-
-ANBranch::ANBranch(uint32_t o) : target(nullptr) { op = o; }
-
-size_t ANBranch::size() const { return op & OP_BYTE ? 2 : 3; }
-
-bool ANBranch::tryShrink() {
-  auto initial_size = size();
-  if (!target || !target->offset.has_value()) {
-    return false;
-  }
-#if defined(OPTIMIZE_TRANSFERS)
-
-  if (canOptimizeTransfer(*target->offset, *offset + 4)) {
-    op |= OP_BYTE;
-  } else
-#endif
-  {
-    op &= ~OP_BYTE;
-  }
-  return size() < initial_size;
-}
-
-void ANBranch::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  listFile->ListArg("$%-4x\t(.%d)",
-                    SCIUWord(*target->offset - (*offset + size())),
-                    ((ANLabel*)target)->number);
-}
-
-void ANBranch::emit(OutputWriter* out) const {
-  int n = *target->offset - (*offset + size());
-
-  out->WriteOp(op);
-  if (op & OP_BYTE)
-    out->WriteByte(n);
-  else
-    out->WriteWord(n);
-}
-
-///////////////////////////////////////////////////
-// Class ANVarAccess
-///////////////////////////////////////////////////
-
-ANVarAccess::ANVarAccess(uint32_t o, uint32_t a) : addr(a) {
-  op = addr < 256 ? o | OP_BYTE : o;
-}
-
-size_t ANVarAccess::size() const { return op & OP_BYTE ? 2 : 3; }
-
-void ANVarAccess::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  if (name)
-    listFile->ListArg("$%-4x\t(%s)", addr, *name);
-  else
-    listFile->ListArg("$%-4x", addr);
-}
-
-void ANVarAccess::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  if (op & OP_BYTE)
-    out->WriteByte(addr);
-  else
-    out->WriteWord(addr);
-}
-
-///////////////////////////////////////////////////
-// Class ANOpOfs
-///////////////////////////////////////////////////
-
-ANOpOfs::ANOpOfs(ANText* text) : ANOpCode(op_lofsa), text(text) {}
-
-size_t ANOpOfs::size() const { return WORDSIZE; }
-
-void ANOpOfs::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  listFile->ListArg("$%-4x", *text->offset);
-}
-
-void ANOpOfs::collectFixups(FixupContext* fixup_ctxt) const {
-  fixup_ctxt->AddRelFixup(this, 1);
-}
-
-void ANOpOfs::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  out->WriteWord(*text->offset);
-}
-
-///////////////////////////////////////////////////
-// Class ANObjID
-///////////////////////////////////////////////////
-
-ANObjID::ANObjID(std::optional<std::string> name)
-    : ANOpCode(op_lofsa), name(std::move(name)) {}
-
-size_t ANObjID::size() const { return WORDSIZE; }
-
-void ANObjID::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  if (name) {
-    listFile->ListArg("$%-4x\t(%s)", *target->offset, *name);
-  } else {
-    listFile->ListArg("$%-4x", *target->offset);
-  }
-}
-
-void ANObjID::collectFixups(FixupContext* fixup_ctxt) const {
-  fixup_ctxt->AddRelFixup(this, 1);
-}
-void ANObjID::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  out->WriteWord(*target->offset);
-}
-
-///////////////////////////////////////////////////
-// Class ANEffctAddr
-///////////////////////////////////////////////////
-
-ANEffctAddr::ANEffctAddr(uint32_t o, uint32_t a, uint32_t t)
-    : ANVarAccess(o, a), eaType(t) {}
-
-size_t ANEffctAddr::size() const { return op & OP_BYTE ? 3 : 5; }
-
-void ANEffctAddr::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  listFile->ListArg("$%-4x\t(%s)", addr, *name);
-}
-
-void ANEffctAddr::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  if (op & OP_BYTE) {
-    out->WriteByte(eaType);
-    out->WriteByte(addr);
-
-  } else {
-    out->WriteWord(eaType);
-    out->WriteWord(addr);
-  }
-}
-
-///////////////////////////////////////////////////
-// Class ANSend
-///////////////////////////////////////////////////
-
-ANSend::ANSend(SciTargetStrategy const* sci_target, uint32_t o)
-    : ANOpCode(o), sci_target(sci_target) {}
-
-size_t ANSend::size() const { return 1 + sci_target->NumArgsSize(); }
-
-void ANSend::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  sci_target->ListNumArgs(listFile, *offset + 1, numArgs);
-}
-
-void ANSend::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  sci_target->WriteNumArgs(out, numArgs);
-}
-
-///////////////////////////////////////////////////
-// Class ANSuper
-///////////////////////////////////////////////////
-
-ANSuper::ANSuper(SciTargetStrategy const* sci_target, std::string name,
-                 uint32_t c)
-    : ANSend(sci_target, op_super), classNum(c), name(std::move(name)) {
-  if (classNum < 256) op |= OP_BYTE;
-}
-
-size_t ANSuper::size() const {
-  return (op & OP_BYTE ? 2 : 3) + sci_target->NumArgsSize();
-}
-
-void ANSuper::list(ListingFile* listFile) const {
-  listFile->ListOp(*offset, op);
-  listFile->ListArg("$%-4x\t(%s)", classNum, name);
-  sci_target->ListNumArgs(listFile, *offset + 1, numArgs);
-}
-
-void ANSuper::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  if (op & OP_BYTE)
-    out->WriteByte(classNum);
-  else
-    out->WriteWord(classNum);
-  sci_target->WriteNumArgs(out, numArgs);
-}
-
-//////////////////////////////////////////////////////////////////////////////
-
-ANFileName::ANFileName(std::string name) : ANOpCode(op_fileName), name(name) {}
-
-void ANFileName::list(ListingFile* listFile) const {
-  listFile->ListOffset(*offset);
-  listFile->Listing("file");
-}
-
-void ANFileName::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  out->WriteNullTerminatedString(name);
-}
-
-size_t ANFileName::size() const { return 1 + name.length() + 1; }
-
-////////////////////////////////////////////////////////////////////////////
-
-ANLineNum::ANLineNum(std::size_t num) : ANOpCode(op_lineNum), num(num) {}
-
-void ANLineNum::list(ListingFile* listFile) const {
-  // FIXME: We want to be able to report the source line here. Perhaps
-  // we can take text ranges and store them in the ANLineNum node?
-  // listFile->ListSourceLine(num);
-}
-
-void ANLineNum::emit(OutputWriter* out) const {
-  out->WriteOp(op);
-  out->WriteWord(num);
-}
-
-size_t ANLineNum::size() const { return 1 + sizeof(SCIWord); }
-
 }  // namespace codegen
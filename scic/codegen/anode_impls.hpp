@@ -10,19 +10,17 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "scic/codegen/alist.hpp"
 #include "scic/codegen/anode.hpp"
+#include "scic/codegen/code_buffer.hpp"
 #include "scic/codegen/common.hpp"
 #include "scic/codegen/listing.hpp"
+#include "scic/codegen/name_table.hpp"
 #include "scic/codegen/output.hpp"
 #include "scic/codegen/target.hpp"
 
-// Sizes of parameters
-#define OPSIZE 1
-#define BYTESIZE 2
-#define WORDSIZE 3
-
 namespace codegen {
 
 class ANComputedWord : public ANode {
@@ -137,25 +135,31 @@ struct ANObject : ANode
   std::string name;  // name of object
 };
 
-struct ANCodeBlk : ANComposite<ANOpCode>
-// The ANCodeBlk class represents the code of a procedure or method.
-// Like ANTable, it changes the list to which ANodes are added to its
-// own internal list.  Therefore the finish() method must be called to
-// reset the current list back to its original value when the code is
-// complete.
+struct ANCodeBlk : ANode
+// The ANCodeBlk class represents the code of a procedure or method.  The
+// instructions are kept in a CodeBuffer rather than as nodes of their own.
 {
-  ANCodeBlk(std::string name);
+  ANCodeBlk(SciTargetStrategy const* sci_target, NameTable* names,
+            std::string name);
 
+  size_t size() const override;
+  size_t setOffset(size_t ofs) override;
+  void collectCode(std::vector<CodeBuffer*>* buffers) override;
+  void list(ListingFile* listFile) const override;
+  void collectFixups(FixupContext* fixup_ctxt) const override;
+  void emit(OutputWriter* out) const override;
   bool optimize() override;
 
   std::string name;  // name of procedure or method
+  CodeBuffer code;
 };
 
 struct ANMethCode : ANCodeBlk
 // ANMethCode is just a listing-specific subclass of ANCodeBlk, which
 // generates "Method" rather than "Procedure" in the listing.
 {
-  ANMethCode(std::string name, std::string obj_name);
+  ANMethCode(SciTargetStrategy const* sci_target, NameTable* names,
+             std::string name, std::string obj_name);
 
   void list(ListingFile* listFile) const override;
 
@@ -166,7 +170,9 @@ struct ANProcCode : ANCodeBlk
 // ANProcCode is just a listing-specific subclass of ANCodeBlk, which
 // generates "Procedure" rather than "Method" in the listing.
 {
-  ANProcCode(std::string name) : ANCodeBlk(std::move(name)) {}
+  ANProcCode(SciTargetStrategy const* sci_target, NameTable* names,
+             std::string name)
+      : ANCodeBlk(sci_target, names, std::move(name)) {}
 
   void list(ListingFile* listFile) const override;
 };
@@ -223,220 +229,6 @@ struct ANMethod : ANProp
   ANCodeBlk* method;
 };
 
-class ANLabel : public ANOpCode
-// The ANLabel class is not really an opcode (since it generates no object
-// code), but is the target of branches.  It is subclassed from ANOpCode for
-// reasons of polymorphism (so that we can walk down lists of ANOpCodes
-// including ANLabels).
-// The property 'number' is the number of the label.  It is used in the
-// listing so that branches can be mapped to targets.
-// The property 'nextLabel' keeps track of the number of the next label
-// to be generated by 'new'.  This is reset to zero with the 'reset()'
-// method at the start of each procedure and method.
-{
- public:
-  ANLabel();
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  uint32_t number;  // label number
-
-  static void reset() { nextLabel = 0; }
-
- private:
-  static uint32_t nextLabel;  // label number of next label
-};
-
-struct ANOpUnsign : ANOpCode
-// The ANOpUnsign class is an ANOpcode which takes an unsigned integer
-// as the argument to the opcode.
-{
-  ANOpUnsign(uint32_t o, uint32_t v);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  uint32_t value;
-  std::optional<std::string> name;
-};
-
-struct ANOpSign : ANOpCode
-// The ANOpSign class is an ANOpcode which takes a signed integer as the
-// argument to the opcode.
-{
-  ANOpSign(uint32_t o, int v);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  int value;
-  std::optional<std::string> name;
-};
-
-struct ANOpExtern : ANOpCode
-// The ANOpExtern class describes a call to an external proceedure.
-{
-  ANOpExtern(std::string name, SciTargetStrategy const* sci_target, int32_t m,
-             uint32_t e);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  SciTargetStrategy const* sci_target;
-  int32_t module;    // module # of destination
-  uint32_t entry;    // entry # of destination
-  uint32_t numArgs;  // number of arguments
-  std::string name;
-};
-
-// The ANCall class describes a call to a procedure in the current module.
-struct ANCall : ANOpCode {
-  ANCall(std::string name, SciTargetStrategy const* sci_target);
-
-  size_t size() const override;
-  bool tryShrink() override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  SciTargetStrategy const* sci_target;
-  uint32_t numArgs;     // number of arguments
-  std::string name;     // symbol of procedure being called
-  ANode const* target;  // target of call
-};
-
-struct ANBranch : ANOpCode
-// The ANBranch class represents a branch opcode.  The 'target' property
-// is the ANode (actually the ANLabel) to which to branch.
-{
-  ANBranch(uint32_t o);
-
-  size_t size() const override;
-  bool tryShrink() override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  ANLabel const* target;
-};
-
-struct ANVarAccess : ANOpCode
-// The ANVarAccess class represents access to variables.  The 'op' property
-// (inherited from ANOpCode) contains the type of access (load or store),
-// the 'addr' property the offset of the variable in the appropriate
-// variable block (global, local, or temporary).
-{
-  ANVarAccess(uint32_t o, uint32_t a);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  uint32_t addr;                    // variable address
-  std::optional<std::string> name;  //  variable name
-};
-
-struct ANOpOfs : ANOpCode
-// The ANOpOfs class gives the offset of a text string in
-// its block of the object code.
-{
-  ANOpOfs(ANText* text);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void collectFixups(FixupContext*) const override;
-  void emit(OutputWriter*) const override;
-
-  ANText* text;  // the offset
-};
-
-struct ANObjID : ANOpCode
-// The ANObjID class represents a reference to an object.  In the object
-// code, it is just the offset of the object within the code segment.
-// In the interpreter this gets fixed up at load time so that the opcode
-// generates the address of the object in the heap.
-{
-  ANObjID(std::optional<std::string> name);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void collectFixups(FixupContext*) const override;
-  void emit(OutputWriter*) const override;
-
-  std::optional<std::string> name;
-  ANode const* target;
-};
-
-struct ANEffctAddr : ANVarAccess
-// The ANEffctAddr class loads the accumulator with the address of
-// a variable.  The type of variable is determined by the value of
-// the property 'eaType'.
-{
-  ANEffctAddr(uint32_t o, uint32_t a, uint32_t t);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  uint32_t eaType;  // type of access
-};
-
-struct ANSend : ANOpCode
-// The ANSend class represents a send to an object.
-{
-  ANSend(SciTargetStrategy const* sci_target, uint32_t o);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  SciTargetStrategy const* sci_target;
-  uint32_t numArgs;
-};
-
-struct ANSuper : ANSend
-// The ANSuper class represents a send to the superclass whose number is
-// 'classNum'.
-{
-  ANSuper(SciTargetStrategy const* sci_target, std::string name, uint32_t c);
-
-  size_t size() const override;
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-
-  uint32_t classNum;
-  std::string name;
-};
-
-struct ANFileName : ANOpCode {
-  //	contains the name of this script's source file for debugging
-
-  ANFileName(std::string name);
-
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-  size_t size() const override;
-
- protected:
-  std::string name;
-};
-
-struct ANLineNum : ANOpCode {
-  //	contains the current line number
-
-  ANLineNum(std::size_t num);
-
-  void list(ListingFile* listFile) const override;
-  void emit(OutputWriter*) const override;
-  size_t size() const override;
-
- protected:
-  std::size_t num;
-};
-
 }  // namespace codegen
 
 #endif
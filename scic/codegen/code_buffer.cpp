@@ -0,0 +1,715 @@
+//	code_buffer.cpp
+// 	lay out, list and emit the instructions of a procedure or method
+
+#include "scic/codegen/code_buffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "scic/codegen/anode.hpp"
+#include "scic/codegen/common.hpp"
+#include "scic/codegen/listing.hpp"
+#include "scic/codegen/opcodes.hpp"
+#include "scic/codegen/output.hpp"
+#include "scic/codegen/target.hpp"
+
+namespace codegen {
+namespace {
+
+#define OPTIMIZE_TRANSFERS
+
+bool canOptimizeTransfer(size_t a, size_t b) {
+  size_t larger = std::max(a, b);
+  size_t smaller = std::min(a, b);
+
+  return (larger - smaller) < 128;
+}
+
+// The encodings an instruction can have, which decide how its operands are
+// sized, listed and written.
+enum class Form {
+  LABEL,
+  PLAIN,
+  SIGNED,
+  UNSIGNED,
+  VAR_ACCESS,
+  EFFCT_ADDR,
+  LOAD_OFFSET,
+  CALL,
+  EXTERN,
+  BRANCH,
+  SEND,
+  SUPER,
+  LINE_NUM,
+};
+
+Form FormOf(std::uint32_t op) {
+  if (op == OP_LABEL) {
+    return Form::LABEL;
+  }
+
+  if (op & OP_LDST) {
+    return Form::VAR_ACCESS;
+  }
+
+  switch (op & ~OP_BYTE) {
+    case op_pushi:
+    case op_loadi:
+      return Form::SIGNED;
+
+    case op_link:
+    case op_class:
+    case op_rest:
+      return Form::UNSIGNED;
+
+    case op_pToa:
+    case op_aTop:
+    case op_pTos:
+    case op_sTop:
+    case op_ipToa:
+    case op_dpToa:
+    case op_ipTos:
+    case op_dpTos:
+      return Form::VAR_ACCESS;
+
+    case op_lea:
+      return Form::EFFCT_ADDR;
+
+    case op_lofsa:
+    case op_lofss:
+      return Form::LOAD_OFFSET;
+
+    case op_call:
+      return Form::CALL;
+
+    case op_callk:
+    case op_callb:
+    case op_calle:
+      return Form::EXTERN;
+
+    case op_bt:
+    case op_bnt:
+    case op_jmp:
+      return Form::BRANCH;
+
+    case op_send:
+    case op_self:
+      return Form::SEND;
+
+    case op_super:
+      return Form::SUPER;
+
+    case op_lineNum:
+      return Form::LINE_NUM;
+
+    default:
+      return Form::PLAIN;
+  }
+}
+
+uint8_t GetExternOp(int32_t module, uint32_t entry) {
+  if (module == -1) {
+    return op_callk | (entry < 256 ? OP_BYTE : 0);
+  }
+
+  if (module == 0) {
+    return op_callb | (entry < 256 ? OP_BYTE : 0);
+  }
+
+  if (module < 0) {
+    throw std::runtime_error("Invalid module number");
+  }
+
+  return op_calle | (module < 256 && entry < 256 ? OP_BYTE : 0);
+}
+
+void WriteOperand(OutputWriter* out, std::uint32_t op, std::int32_t value) {
+  if (op & OP_BYTE)
+    out->WriteByte(value);
+  else
+    out->WriteWord(value);
+}
+
+}  // namespace
+
+CodeBuffer::CodeBuffer(SciTargetStrategy const* sci_target, NameTable* names,
+                       ANode* owner)
+    : sci_target_(sci_target), name_table_(names), owner_(owner) {}
+
+std::size_t CodeBuffer::append(std::uint32_t op) {
+  ops_.push_back(op);
+  values_.push_back(0);
+  extras_.push_back(0);
+  num_args_.push_back(0);
+  targets_.push_back(kNone);
+  names_.push_back(NameTable::kNone);
+  sizes_.push_back(0);
+  offsets_.push_back(0);
+  return ops_.size() - 1;
+}
+
+NameTable::Id CodeBuffer::addName(std::optional<std::string_view> name) {
+  if (!name) {
+    return NameTable::kNone;
+  }
+  return name_table_->Intern(*name);
+}
+
+std::size_t CodeBuffer::addOp(std::uint32_t op) {
+  auto i = append(op);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addSigned(std::uint32_t op, int value) {
+  auto i = append(op | ((uint32_t)abs(value) < 128 ? OP_BYTE : 0));
+  values_[i] = value;
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addUnsigned(std::uint32_t op, std::uint32_t value,
+                                    std::optional<std::string_view> name) {
+#if defined(OPTIMIZE_TRANSFERS)
+  op |= value < 256 ? OP_BYTE : 0;
+#else
+  if (op == op_link || op == op_class)
+    op |= value < 256 ? OP_BYTE : 0;
+  else
+    op |= value < 128 ? OP_BYTE : 0;
+#endif
+  auto i = append(op);
+  values_[i] = value;
+  names_[i] = addName(name);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addVarAccess(std::uint32_t op, std::uint32_t addr,
+                                     std::optional<std::string_view> name) {
+  auto i = append(addr < 256 ? op | OP_BYTE : op);
+  values_[i] = addr;
+  names_[i] = addName(name);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addEffctAddr(std::uint32_t addr, std::uint32_t ea_type,
+                                     std::optional<std::string_view> name) {
+  auto i = addVarAccess(op_lea, addr, name);
+  extras_[i] = ea_type;
+  return i;
+}
+
+std::size_t CodeBuffer::addLoadOffset(std::size_t ref,
+                                      std::optional<std::string_view> name) {
+  auto i = append(op_lofsa);
+  targets_[i] = ref;
+  names_[i] = addName(name);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addCall(std::size_t ref, std::string_view name,
+                                std::uint32_t num_args) {
+  auto i = append(op_call);
+  num_args_[i] = num_args;
+  targets_[i] = ref;
+  names_[i] = addName(name);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addExtern(std::string_view name, std::int32_t module,
+                                  std::uint32_t entry, std::uint32_t num_args) {
+  auto i = append(GetExternOp(module, entry));
+  values_[i] = entry;
+  extras_[i] = module;
+  num_args_[i] = num_args;
+  names_[i] = addName(name);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addBranch(std::uint32_t op) { return addOp(op); }
+
+std::size_t CodeBuffer::addSend(std::uint32_t op, std::uint32_t num_args) {
+  auto i = append(op);
+  num_args_[i] = num_args;
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addSuper(std::string_view name, std::uint32_t class_num,
+                                 std::uint32_t num_args) {
+  auto i = append(class_num < 256 ? op_super | OP_BYTE : op_super);
+  values_[i] = class_num;
+  num_args_[i] = num_args;
+  names_[i] = addName(name);
+  updateSize(i);
+  return i;
+}
+
+std::size_t CodeBuffer::addLineNum(std::size_t num) {
+  auto i = append(op_lineNum);
+  values_[i] = num;
+  updateSize(i);
+  return i;
+}
+
+std::uint32_t CodeBuffer::addLabel() {
+  auto i = append(OP_LABEL);
+  std::uint32_t label = labels_.size();
+  values_[i] = label;
+  labels_.push_back(i);
+  return label;
+}
+
+std::size_t CodeBuffer::addRef(ANode const* node) {
+  refs_.push_back(node);
+  return refs_.size() - 1;
+}
+
+void CodeBuffer::setOp(std::size_t i, std::uint32_t op) {
+  ops_[i] = op;
+  updateSize(i);
+}
+
+void CodeBuffer::replaceWithOp(std::size_t i, std::uint32_t op) {
+  ops_[i] = op;
+  values_[i] = 0;
+  extras_[i] = 0;
+  num_args_[i] = 0;
+  targets_[i] = kNone;
+  names_[i] = NameTable::kNone;
+  updateSize(i);
+}
+
+void CodeBuffer::replaceWithSend(std::size_t i, std::uint32_t op,
+                                 std::uint32_t num_args) {
+  replaceWithOp(i, op);
+  num_args_[i] = num_args;
+  updateSize(i);
+}
+
+void CodeBuffer::remove(std::size_t i) {
+  ops_[i] = kRemovedOp;
+  updateSize(i);
+}
+
+std::size_t CodeBuffer::next(std::size_t i) const {
+  for (++i; i < ops_.size(); ++i) {
+    if (!isRemoved(i)) {
+      return i;
+    }
+  }
+  return npos;
+}
+
+std::size_t CodeBuffer::prev(std::size_t i) const {
+  while (i-- > 0) {
+    if (!isRemoved(i)) {
+      return i;
+    }
+  }
+  return npos;
+}
+
+void CodeBuffer::compact() {
+  std::size_t out = 0;
+  for (std::size_t i = 0; i < ops_.size(); ++i) {
+    if (isRemoved(i)) {
+      continue;
+    }
+    if (ops_[i] == OP_LABEL) {
+      labels_[values_[i]] = out;
+    }
+    ops_[out] = ops_[i];
+    values_[out] = values_[i];
+    extras_[out] = extras_[i];
+    num_args_[out] = num_args_[i];
+    targets_[out] = targets_[i];
+    names_[out] = names_[i];
+    sizes_[out] = sizes_[i];
+    offsets_[out] = offsets_[i];
+    ++out;
+  }
+  ops_.resize(out);
+  values_.resize(out);
+  extras_.resize(out);
+  num_args_.resize(out);
+  targets_.resize(out);
+  names_.resize(out);
+  sizes_.resize(out);
+  offsets_.resize(out);
+}
+
+std::size_t CodeBuffer::setOffset(std::size_t ofs) {
+  for (std::size_t i = 0; i < ops_.size(); ++i) {
+    offsets_[i] = ofs;
+    ofs += sizes_[i];
+  }
+  return ofs;
+}
+
+void CodeBuffer::RelaxTransfers(std::vector<CodeBuffer*> const& buffers) {
+#if defined(OPTIMIZE_TRANSFERS)
+  // A call or branch that still uses a word offset.
+  struct Transfer {
+    CodeBuffer* code;
+    std::size_t index;
+    std::size_t offset;
+    std::size_t target;
+  };
+
+  std::vector<Transfer> transfers;
+  std::vector<std::ptrdiff_t> excess;
+  std::vector<std::size_t> worklist;
+  for (auto* code : buffers) {
+    for (std::size_t i = 0; i < code->ops_.size(); ++i) {
+      std::size_t slack;
+      switch (FormOf(code->ops_[i])) {
+        case Form::CALL:
+          slack = 5;
+          break;
+        case Form::BRANCH:
+          slack = 4;
+          break;
+        default:
+          continue;
+      }
+
+      auto target_offset = code->targetOffset(i);
+      if (!target_offset || (code->ops_[i] & OP_BYTE)) {
+        continue;
+      }
+
+      auto from = code->offsets_[i] + slack;
+      if (canOptimizeTransfer(*target_offset, from)) {
+        worklist.push_back(transfers.size());
+      }
+      excess.push_back(std::ptrdiff_t(std::max(*target_offset, from) -
+                                      std::min(*target_offset, from)) -
+                       127);
+      transfers.push_back({code, i, code->offsets_[i], *target_offset});
+    }
+  }
+
+  // The transfers that lie between each transfer and its target. Those are
+  // the ones whose shrinking brings the target closer.
+  std::vector<std::vector<std::size_t>> dependents(transfers.size());
+  for (std::size_t j = 0; j < transfers.size(); ++j) {
+    if (excess[j] <= 0) {
+      continue;
+    }
+
+    auto const& transfer = transfers[j];
+    auto at_target = std::size_t(
+        std::ranges::lower_bound(transfers, transfer.target, {},
+                                 &Transfer::offset) -
+        transfers.begin());
+    std::size_t lo, hi;
+    if (transfer.target > transfer.offset) {
+      lo = j + 1;
+      hi = at_target;
+    } else {
+      lo = at_target;
+      hi = j;
+    }
+
+    // Each transfer in the span can only lose a byte, so if there aren't
+    // enough of them this one can never fit.
+    if (std::ptrdiff_t(hi - lo) < excess[j]) {
+      continue;
+    }
+    for (auto k = lo; k < hi; ++k) {
+      dependents[k].push_back(j);
+    }
+  }
+
+  while (!worklist.empty()) {
+    auto k = worklist.back();
+    worklist.pop_back();
+
+    auto* code = transfers[k].code;
+    auto i = transfers[k].index;
+    auto initial_size = code->sizes_[i];
+    code->ops_[i] |= OP_BYTE;
+    code->updateSize(i);
+    std::ptrdiff_t shrunk = initial_size - code->sizes_[i];
+
+    for (auto j : dependents[k]) {
+      bool fit = excess[j] <= 0;
+      excess[j] -= shrunk;
+      if (!fit && excess[j] <= 0) {
+        worklist.push_back(j);
+      }
+    }
+  }
+#endif
+}
+
+std::size_t CodeBuffer::byteSize() const {
+  std::size_t total = 0;
+  for (auto size : sizes_) {
+    total += size;
+  }
+  return total;
+}
+
+void CodeBuffer::updateSize(std::size_t i) {
+  auto size = computeSize(i);
+  if (size == sizes_[i]) {
+    return;
+  }
+  sizes_[i] = size;
+  if (owner_) {
+    owner_->invalidateLayout();
+  }
+}
+
+std::size_t CodeBuffer::computeSize(std::size_t i) const {
+  if (isRemoved(i)) {
+    return 0;
+  }
+
+  std::uint32_t op = ops_[i];
+  bool byte = op & OP_BYTE;
+  int arg_size = sci_target_->NumArgsSize();
+
+  switch (FormOf(op)) {
+    case Form::LABEL:
+      return 0;
+    case Form::PLAIN:
+      return 1;
+    case Form::SIGNED:
+    case Form::UNSIGNED:
+    case Form::VAR_ACCESS:
+    case Form::BRANCH:
+      return byte ? 2 : 3;
+    case Form::EFFCT_ADDR:
+      return byte ? 3 : 5;
+    case Form::LOAD_OFFSET:
+    case Form::LINE_NUM:
+      return 3;
+    case Form::CALL:
+    case Form::SUPER:
+      return (byte ? 2 : 3) + arg_size;
+    case Form::EXTERN:
+      if ((op & ~OP_BYTE) == op_calle) {
+        return (byte ? 3 : 5) + arg_size;
+      }
+      return (byte ? 2 : 3) + arg_size;
+    case Form::SEND:
+      return 1 + arg_size;
+  }
+  return 0;
+}
+
+std::optional<std::size_t> CodeBuffer::targetOffset(std::size_t i) const {
+  if (targets_[i] == kNone) {
+    return std::nullopt;
+  }
+
+  if (FormOf(ops_[i]) == Form::BRANCH) {
+    return offsets_[labels_[targets_[i]]];
+  }
+
+  auto const* node = refs_[targets_[i]];
+  if (!node) {
+    return std::nullopt;
+  }
+  return node->offset;
+}
+
+std::optional<std::string_view> CodeBuffer::name(std::size_t i) const {
+  if (names_[i] == NameTable::kNone) {
+    return std::nullopt;
+  }
+  return name_table_->Get(names_[i]);
+}
+
+void CodeBuffer::collectFixups(FixupContext* fixup_ctxt, ANode const* base,
+                               std::size_t base_offset) const {
+  for (std::size_t i = 0; i < ops_.size(); ++i) {
+    if (FormOf(ops_[i]) == Form::LOAD_OFFSET) {
+      fixup_ctxt->AddRelFixup(base, offsets_[i] - base_offset + 1);
+    }
+  }
+}
+
+void CodeBuffer::list(ListingFile* listFile) const {
+  for (std::size_t i = 0; i < ops_.size(); ++i) {
+    std::uint32_t op = ops_[i];
+    std::size_t offset = offsets_[i];
+    auto sym = name(i);
+
+    switch (FormOf(op)) {
+      case Form::LABEL:
+        listFile->Listing(".%d", values_[i]);
+        break;
+
+      case Form::PLAIN:
+        listFile->ListOp(offset, op);
+        break;
+
+      case Form::SIGNED:
+      case Form::UNSIGNED:
+        listFile->ListOp(offset, op);
+        if (!sym)
+          listFile->ListArg("$%-4x", (SCIUWord)values_[i]);
+        else
+          listFile->ListArg("$%-4x\t(%s)", (SCIUWord)values_[i], *sym);
+        break;
+
+      case Form::VAR_ACCESS:
+      case Form::EFFCT_ADDR:
+        listFile->ListOp(offset, op);
+        if (sym)
+          listFile->ListArg("$%-4x\t(%s)", std::uint32_t(values_[i]), *sym);
+        else
+          listFile->ListArg("$%-4x", std::uint32_t(values_[i]));
+        break;
+
+      case Form::LOAD_OFFSET: {
+        listFile->ListOp(offset, op);
+        auto target_offset = targetOffset(i).value();
+        if (sym) {
+          listFile->ListArg("$%-4x\t(%s)", target_offset, *sym);
+        } else {
+          listFile->ListArg("$%-4x", target_offset);
+        }
+        break;
+      }
+
+      case Form::CALL:
+        listFile->ListOp(offset, op_call);
+        listFile->ListArg(
+            "$%-4x\t(%s)",
+            SCIUWord(targetOffset(i).value() - (offset + sizes_[i])), *sym);
+        sci_target_->ListNumArgs(listFile, offset + 1, num_args_[i]);
+        break;
+
+      case Form::EXTERN:
+        listFile->ListOp(offset, op);
+        if ((op & ~OP_BYTE) == op_calle) {
+          listFile->ListArg("$%x/%x\t(%s)", (SCIUWord)extras_[i],
+                            (SCIUWord)values_[i], *sym);
+        } else {
+          listFile->ListArg("$%-4x\t(%s)", (SCIUWord)values_[i], *sym);
+        }
+        sci_target_->ListNumArgs(listFile, offset + 1, num_args_[i]);
+        break;
+
+      case Form::BRANCH:
+        listFile->ListOp(offset, op);
+        listFile->ListArg(
+            "$%-4x\t(.%d)",
+            SCIUWord(targetOffset(i).value() - (offset + sizes_[i])),
+            targets_[i]);
+        break;
+
+      case Form::SEND:
+        listFile->ListOp(offset, op);
+        sci_target_->ListNumArgs(listFile, offset + 1, num_args_[i]);
+        break;
+
+      case Form::SUPER:
+        listFile->ListOp(offset, op);
+        listFile->ListArg("$%-4x\t(%s)", std::uint32_t(values_[i]), *sym);
+        sci_target_->ListNumArgs(listFile, offset + 1, num_args_[i]);
+        break;
+
+      case Form::LINE_NUM:
+        // FIXME: We want to be able to report the source line here. Perhaps
+        // we can take text ranges and keep them with the line number?
+        break;
+    }
+  }
+}
+
+void CodeBuffer::emit(OutputWriter* out) const {
+  for (std::size_t i = 0; i < ops_.size(); ++i) {
+    std::uint32_t op = ops_[i];
+
+    switch (FormOf(op)) {
+      case Form::LABEL:
+        break;
+
+      case Form::PLAIN:
+        out->WriteOp(op);
+        break;
+
+      case Form::SIGNED:
+      case Form::UNSIGNED:
+      case Form::VAR_ACCESS:
+        out->WriteOp(op);
+        WriteOperand(out, op, values_[i]);
+        break;
+
+      case Form::EFFCT_ADDR:
+        out->WriteOp(op);
+        WriteOperand(out, op, extras_[i]);
+        WriteOperand(out, op, values_[i]);
+        break;
+
+      case Form::LOAD_OFFSET:
+        out->WriteOp(op);
+        out->WriteWord(targetOffset(i).value());
+        break;
+
+      case Form::CALL: {
+        auto target_offset = targetOffset(i);
+        if (!target_offset) {
+          throw std::runtime_error(
+              absl::StrFormat("Undefined procedure: %s", *name(i)));
+        }
+        out->WriteOp(op);
+        WriteOperand(out, op, *target_offset - (offsets_[i] + sizes_[i]));
+        sci_target_->WriteNumArgs(out, num_args_[i]);
+        break;
+      }
+
+      case Form::EXTERN:
+        out->WriteOp(op);
+        if ((op & ~OP_BYTE) == op_calle) {
+          WriteOperand(out, op, extras_[i]);
+        }
+        WriteOperand(out, op, values_[i]);
+        sci_target_->WriteNumArgs(out, num_args_[i]);
+        break;
+
+      case Form::BRANCH:
+        out->WriteOp(op);
+        WriteOperand(out, op,
+                     targetOffset(i).value() - (offsets_[i] + sizes_[i]));
+        break;
+
+      case Form::SEND:
+        out->WriteOp(op);
+        sci_target_->WriteNumArgs(out, num_args_[i]);
+        break;
+
+      case Form::SUPER:
+        out->WriteOp(op);
+        WriteOperand(out, op, values_[i]);
+        sci_target_->WriteNumArgs(out, num_args_[i]);
+        break;
+
+      case Form::LINE_NUM:
+        out->WriteOp(op);
+        out->WriteWord(values_[i]);
+        break;
+    }
+  }
+}
+
+}  // namespace codegen
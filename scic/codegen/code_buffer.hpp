@@ -0,0 +1,185 @@
+//	code_buffer.hpp
+// 	the instructions of a procedure or method
+
+#ifndef CODE_BUFFER_HPP
+#define CODE_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "scic/codegen/anode.hpp"
+#include "scic/codegen/listing.hpp"
+#include "scic/codegen/name_table.hpp"
+#include "scic/codegen/output.hpp"
+#include "scic/codegen/target.hpp"
+
+namespace codegen {
+
+// The body of a procedure or method, as a flat buffer of instructions.
+//
+// Each instruction is a row across a set of parallel arrays, so the optimizer
+// and the layout passes walk plain vectors instead of a list of nodes. What
+// the operands mean depends on the opcode:
+//
+// - value: the immediate value, variable or property address, class number,
+//   kernel/extern entry, or line number. For a label, the label number.
+// - extra: the module of an extern call, or the variable type of a lea.
+// - num_args: the argument byte count of a call or send.
+// - target: for a branch, the number of the label it goes to. For a call or
+//   a lofsa, the index of the node it refers to in the ref table.
+// - name: the id of the instruction's symbol in the module's NameTable, only
+//   used in the listing.
+//
+// Labels are pseudo-instructions with the opcode OP_LABEL and no size. They
+// are numbered in the order they are added to the buffer.
+class CodeBuffer {
+ public:
+  static constexpr std::size_t npos = std::size_t(-1);
+  static constexpr std::uint32_t kNone = std::uint32_t(-1);
+
+  // If given, owner is told whenever the size of the code changes.
+  CodeBuffer(SciTargetStrategy const* sci_target, NameTable* names,
+             ANode* owner = nullptr);
+
+  // The number of instructions, including labels and removed instructions.
+  std::size_t length() const { return ops_.size(); }
+
+  std::uint32_t op(std::size_t i) const { return ops_[i]; }
+  std::int32_t value(std::size_t i) const { return values_[i]; }
+  std::int32_t extra(std::size_t i) const { return extras_[i]; }
+  std::uint32_t numArgs(std::size_t i) const { return num_args_[i]; }
+  std::uint32_t target(std::size_t i) const { return targets_[i]; }
+  std::size_t size(std::size_t i) const { return sizes_[i]; }
+  std::size_t offset(std::size_t i) const { return offsets_[i]; }
+
+  // Returns the index of the label with the given number.
+  std::size_t labelIndex(std::uint32_t label) const { return labels_[label]; }
+
+  // Appending instructions. Each returns the index of the new instruction.
+
+  // An instruction with no operands.
+  std::size_t addOp(std::uint32_t op);
+  // An instruction with a signed immediate (pushi, loadi).
+  std::size_t addSigned(std::uint32_t op, int value);
+  // An instruction with an unsigned immediate (link, class, &rest).
+  std::size_t addUnsigned(std::uint32_t op, std::uint32_t value,
+                          std::optional<std::string_view> name = std::nullopt);
+  // A variable or property access. The opcode must already have OP_BYTE set
+  // if the address fits in a byte.
+  std::size_t addVarAccess(std::uint32_t op, std::uint32_t addr,
+                           std::optional<std::string_view> name);
+  std::size_t addEffctAddr(std::uint32_t addr, std::uint32_t ea_type,
+                           std::optional<std::string_view> name);
+  // Loads the offset of the given node, which is resolved with setRef().
+  std::size_t addLoadOffset(std::size_t ref,
+                            std::optional<std::string_view> name);
+  // A call to a local procedure, which is resolved with setRef().
+  std::size_t addCall(std::size_t ref, std::string_view name,
+                      std::uint32_t num_args);
+  // A call to a kernel function (module -1) or another module's procedure.
+  std::size_t addExtern(std::string_view name, std::int32_t module,
+                        std::uint32_t entry, std::uint32_t num_args);
+  // A branch, whose target is set with setBranchTarget().
+  std::size_t addBranch(std::uint32_t op);
+  std::size_t addSend(std::uint32_t op, std::uint32_t num_args);
+  std::size_t addSuper(std::string_view name, std::uint32_t class_num,
+                       std::uint32_t num_args);
+  std::size_t addLineNum(std::size_t num);
+  // Adds a label, returning its number.
+  std::uint32_t addLabel();
+
+  // Adds an entry to the ref table, to be set once the node it refers to
+  // exists.
+  std::size_t addRef(ANode const* node = nullptr);
+  void setRef(std::size_t ref, ANode const* node) { refs_[ref] = node; }
+
+  void setBranchTarget(std::size_t i, std::uint32_t label) {
+    targets_[i] = label;
+  }
+
+  // Changes the opcode of an instruction, keeping its operands.
+  void setOp(std::size_t i, std::uint32_t op);
+  // Replaces an instruction with one that has no operands.
+  void replaceWithOp(std::size_t i, std::uint32_t op);
+  // Replaces an instruction with a send that has the given argument count.
+  void replaceWithSend(std::size_t i, std::uint32_t op,
+                       std::uint32_t num_args);
+
+  // Marks an instruction as removed. It is skipped by next() and prev(), and
+  // dropped from the buffer by compact().
+  void remove(std::size_t i);
+  bool isRemoved(std::size_t i) const { return ops_[i] == kRemovedOp; }
+
+  // Returns the index of the next (or previous) instruction that hasn't been
+  // removed, or npos if there is none.
+  std::size_t next(std::size_t i) const;
+  std::size_t prev(std::size_t i) const;
+
+  // Drops removed instructions from the buffer.
+  void compact();
+
+  // Assigns offsets to the instructions, starting at ofs. Returns the offset
+  // following the last instruction.
+  std::size_t setOffset(std::size_t ofs);
+
+  // Shrinks every call and branch in the buffers that can reach its target
+  // with a byte offset. The buffers must have been laid out with setOffset()
+  // in a single address space, in order, and must be laid out again
+  // afterwards.
+  //
+  // Shrinking a transfer brings the targets of the transfers that span it
+  // closer, so this keeps a worklist: each transfer counts how many bytes its
+  // span still has to lose, and is shrunk once that reaches zero. Only
+  // transfers that span a few dozen others can ever fit, so the work is
+  // linear in the number of transfers. The result is the same as shrinking
+  // everything that fits and re-laying out until nothing changes.
+  static void RelaxTransfers(std::vector<CodeBuffer*> const& buffers);
+
+  // The total size of the instructions, in bytes.
+  std::size_t byteSize() const;
+
+  // Adds fixups for the offsets in the code that refer to the heap. The
+  // fixups are relative to the node holding the buffer, which is at
+  // base_offset.
+  void collectFixups(FixupContext* fixup_ctxt, ANode const* base,
+                     std::size_t base_offset) const;
+
+  void list(ListingFile* listFile) const;
+  void emit(OutputWriter* out) const;
+
+ private:
+  static constexpr std::uint16_t kRemovedOp = 0xFFFF;
+
+  std::size_t append(std::uint32_t op);
+  NameTable::Id addName(std::optional<std::string_view> name);
+  std::size_t computeSize(std::size_t i) const;
+  // Sets the size of the instruction from its opcode.
+  void updateSize(std::size_t i);
+  // The offset of the instruction's branch or call target.
+  std::optional<std::size_t> targetOffset(std::size_t i) const;
+  std::optional<std::string_view> name(std::size_t i) const;
+
+  SciTargetStrategy const* sci_target_;
+
+  std::vector<std::uint16_t> ops_;
+  std::vector<std::int32_t> values_;
+  std::vector<std::int32_t> extras_;
+  std::vector<std::uint32_t> num_args_;
+  std::vector<std::uint32_t> targets_;
+  std::vector<NameTable::Id> names_;
+  std::vector<std::uint8_t> sizes_;
+  std::vector<std::uint32_t> offsets_;
+
+  // The index of each label, by number.
+  std::vector<std::size_t> labels_;
+  std::vector<ANode const*> refs_;
+  NameTable* name_table_;
+  ANode* owner_;
+};
+
+}  // namespace codegen
+
+#endif
@@ -0,0 +1,107 @@
+#include "scic/codegen/code_buffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/name_table.hpp"
+#include "scic/codegen/opcodes.hpp"
+#include "scic/codegen/target.hpp"
+
+namespace codegen {
+namespace {
+
+std::vector<std::uint32_t> Ops(CodeBuffer const& code) {
+  std::vector<std::uint32_t> ops;
+  for (auto i = code.next(CodeBuffer::npos); i != CodeBuffer::npos;
+       i = code.next(i)) {
+    ops.push_back(code.op(i));
+  }
+  return ops;
+}
+
+TEST(CodeBufferTest, SetsByteFlagFromOperand) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto small = code.addSigned(op_pushi, 5);
+  auto large = code.addSigned(op_pushi, 1000);
+
+  EXPECT_EQ(code.op(small), op_pushi | OP_BYTE);
+  EXPECT_EQ(code.size(small), 2);
+  EXPECT_EQ(code.op(large), op_pushi);
+  EXPECT_EQ(code.size(large), 3);
+}
+
+TEST(CodeBufferTest, RemovedInstructionsAreSkippedAndCompacted) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  code.addOp(op_push);
+  auto toss = code.addOp(op_toss);
+  auto label = code.addLabel();
+  code.addOp(op_ret);
+
+  code.remove(toss);
+  EXPECT_EQ(Ops(code), (std::vector<std::uint32_t>{op_push, OP_LABEL, op_ret}));
+  EXPECT_EQ(code.length(), 4);
+
+  code.compact();
+  EXPECT_EQ(code.length(), 3);
+  EXPECT_EQ(code.labelIndex(label), 1);
+  EXPECT_EQ(code.op(code.labelIndex(label)), OP_LABEL);
+}
+
+TEST(CodeBufferTest, ShrinksShortBranches) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto branch = code.addBranch(op_jmp);
+  auto label = code.addLabel();
+  code.setBranchTarget(branch, label);
+  code.addOp(op_ret);
+
+  EXPECT_EQ(code.setOffset(0), 4);
+  CodeBuffer::RelaxTransfers({&code});
+  EXPECT_EQ(code.setOffset(0), 3);
+  EXPECT_EQ(code.op(branch), op_jmp | OP_BYTE);
+}
+
+TEST(CodeBufferTest, ShrinksBranchesOnceTheirSpanShrinks) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  // The outer branch is a byte too far from its target until the branches it
+  // jumps over are shrunk.
+  auto outer = code.addBranch(op_jmp);
+  std::vector<std::size_t> inner;
+  for (int i = 0; i < 43; ++i) {
+    inner.push_back(code.addBranch(op_bt));
+  }
+  auto label = code.addLabel();
+  code.setBranchTarget(outer, label);
+  for (auto branch : inner) {
+    code.setBranchTarget(branch, label);
+  }
+  code.addOp(op_ret);
+
+  EXPECT_EQ(code.setOffset(0), 44 * 3 + 1);
+  CodeBuffer::RelaxTransfers({&code});
+  EXPECT_EQ(code.setOffset(0), 44 * 2 + 1);
+  EXPECT_EQ(code.op(outer), op_jmp | OP_BYTE);
+}
+
+TEST(CodeBufferTest, KeepsLongBranches) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto branch = code.addBranch(op_jmp);
+  for (int i = 0; i < 50; ++i) {
+    code.addSigned(op_pushi, 1000);
+  }
+  code.setBranchTarget(branch, code.addLabel());
+
+  EXPECT_EQ(code.setOffset(0), 153);
+  CodeBuffer::RelaxTransfers({&code});
+  EXPECT_EQ(code.setOffset(0), 153);
+  EXPECT_EQ(code.op(branch), op_jmp);
+}
+
+}  // namespace
+}  // namespace codegen
@@ -17,6 +17,7 @@
 #include "scic/codegen/alist.hpp"
 #include "scic/codegen/anode.hpp"
 #include "scic/codegen/anode_impls.hpp"
+#include "scic/codegen/code_buffer.hpp"
 #include "scic/codegen/common.hpp"
 #include "scic/codegen/fixup_list.hpp"
 #include "scic/codegen/listing.hpp"
@@ -34,16 +35,21 @@ class Var {
   std::optional<util::Choice<int, TextRef>> value;
 };
 
+// Answers heap membership from an index of the heap's nodes, built once, so
+// that collecting fixups doesn't walk the heap for every reference.
+//
+// The index is a snapshot. Nodes added to the heap afterwards (the entries of
+// its fixup table) are not in it, but nothing refers to those.
 class CompilerHeapContext : public HeapContext {
  public:
-  CompilerHeapContext(CodeGenerator* compiler) : compiler_(compiler) {}
+  CompilerHeapContext(FixupList const* heap) { heap->collectNodes(&nodes_); }
 
   bool IsInHeap(ANode const* node) const override {
-    return compiler_->IsInHeap(node);
+    return nodes_.contains(node);
   }
 
  private:
-  CodeGenerator* compiler_;
+  ANodeSet nodes_;
 };
 
 class ANVars : public ANode
@@ -125,17 +131,15 @@ void OptimizeHunk(Optimization opt, ANode* anode) {
     }
   }
 
-  // Make a first pass, resolving offsets and converting to byte offsets
-  // where possible.
+  // Make a first pass, resolving offsets, then convert the calls and
+  // branches to byte offsets where possible.
   anode->setOffset(0);
 
-  // Continue resolving and converting to byte offsets until we've shrunk
-  // the code as far as it will go.
-  while (true) {
-    if (!anode->tryShrink()) break;
+  std::vector<CodeBuffer*> buffers;
+  anode->collectCode(&buffers);
+  CodeBuffer::RelaxTransfers(buffers);
 
-    anode->setOffset(0);
-  }
+  anode->setOffset(0);
 }
 
 uint8_t GetBinOpValue(FunctionBuilder::BinOp op) {
@@ -192,6 +196,7 @@ class ANDispTable : public ANode {
     while (dispatches_.size() <= index) {
       dispatches_.push_back(std::make_unique<ANDispatch>());
     }
+    invalidateLayout();
     auto* pub = dispatches_[index].get();
     pub->name = std::move(name);
     target->RegisterCallback([pub](ANode* target) { pub->target = target; });
@@ -220,13 +225,11 @@ class ANDispTable : public ANode {
     }
   }
 
-  bool contains(ANode const* node) const override {
+  void collectNodes(ANodeSet* nodes) const override {
+    ANode::collectNodes(nodes);
     for (auto const& dispatch : dispatches_) {
-      if (dispatch->contains(node)) {
-        return true;
-      }
+      dispatch->collectNodes(nodes);
     }
-    return false;
   }
 
   bool optimize() override {
@@ -325,28 +328,28 @@ LabelRef FunctionBuilder::CreateLabelRef() { return LabelRef(); }
 
 void FunctionBuilder::AddLineAnnotation(std::size_t lineNum) {
   if (target_->SupportsDebugInstructions()) {
-    code_node_->getList()->newNode<ANLineNum>(lineNum);
+    code_node_->code.addLineNum(lineNum);
   }
 }
 
 void FunctionBuilder::AddPushOp() {
-  code_node_->getList()->newNode<ANOpCode>(op_push);
+  code_node_->code.addOp(op_push);
 }
 
 void FunctionBuilder::AddPushImmediate(int value) {
-  code_node_->getList()->newNode<ANOpSign>(op_pushi, value);
+  code_node_->code.addSigned(op_pushi, value);
 }
 
 void FunctionBuilder::AddPushPrevOp() {
-  code_node_->getList()->newNode<ANOpCode>(op_pprev);
+  code_node_->code.addOp(op_pprev);
 }
 
 void FunctionBuilder::AddTossOp() {
-  code_node_->getList()->newNode<ANOpCode>(op_toss);
+  code_node_->code.addOp(op_toss);
 }
 
 void FunctionBuilder::AddDupOp() {
-  code_node_->getList()->newNode<ANOpCode>(op_dup);
+  code_node_->code.addOp(op_dup);
 }
 
 void FunctionBuilder::AddRestOp(std::size_t value) {
@@ -354,28 +357,30 @@ void FunctionBuilder::AddRestOp(std::size_t value) {
   if (value < 256) {
     op |= OP_BYTE;
   }
-  code_node_->getList()->newNode<ANOpUnsign>(op, std::uint32_t(value));
+  code_node_->code.addUnsigned(op, std::uint32_t(value));
 }
 
 void FunctionBuilder::AddLoadImmediate(LiteralValue value) {
   value.visit(
-      [this](int num) {
-        code_node_->getList()->newNode<ANOpSign>(op_loadi, num);
-      },
+      [this](int num) { code_node_->code.addSigned(op_loadi, num); },
       [this](TextRef text) {
-        code_node_->getList()->newNode<ANOpOfs>(text.ref_);
+        auto& code = code_node_->code;
+        code.addLoadOffset(code.addRef(text.ref_), std::nullopt);
       });
 }
 
 void FunctionBuilder::AddLoadOffsetTo(PtrRef* ptr,
-                                      std::optional<std::string> name) {
-  auto* ofs = code_node_->getList()->newNode<ANObjID>(std::move(name));
-  ptr->ref_.RegisterCallback([ofs](ANode* target) { ofs->target = target; });
+                                      std::optional<std::string_view> name) {
+  auto* code = &code_node_->code;
+  auto ref = code->addRef();
+  code->addLoadOffset(ref, name);
+  ptr->ref_.RegisterCallback(
+      [code, ref](ANode* target) { code->setRef(ref, target); });
 }
 
 void FunctionBuilder::AddLoadVarAddr(VarType var_type, std::size_t offset,
                                      bool addAccumIndex,
-                                     std::optional<std::string> name) {
+                                     std::optional<std::string_view> name) {
   uint32_t accType;
   switch (var_type) {
     case GLOBAL:
@@ -399,16 +404,12 @@ void FunctionBuilder::AddLoadVarAddr(VarType var_type, std::size_t offset,
     accType |= OP_INDEX;
   }
 
-  auto* node = code_node_->getList()->newNode<ANEffctAddr>(
-      op_lea, std::uint32_t(offset), accType);
-  if (name) {
-    node->name = std::move(name).value();
-  }
+  code_node_->code.addEffctAddr(std::uint32_t(offset), accType, name);
 }
 
 void FunctionBuilder::AddVarAccess(VarType var_type, ValueOp value_op,
                                    std::size_t offset, bool add_accum_index,
-                                   std::optional<std::string> name) {
+                                   std::optional<std::string_view> name) {
   uint8_t op = OP_LDST;
   if (value_op == STORE) {
     // Since the stored value is on the stack, we need to change the
@@ -461,14 +462,11 @@ void FunctionBuilder::AddVarAccess(VarType var_type, ValueOp value_op,
   }
 
   if (offset < 256) op |= OP_BYTE;
-  auto* an = code_node_->getList()->newNode<ANVarAccess>(op, offset);
-  if (name) {
-    an->name = std::move(name).value();
-  }
+  code_node_->code.addVarAccess(op, offset, name);
 }
 
 void FunctionBuilder::AddPropAccess(ValueOp value_op, std::size_t offset,
-                                    std::optional<std::string> name) {
+                                    std::optional<std::string_view> name) {
   // Set the bits indicating the type of variable to be accessed, then
   // put out the opcode to access it.
   uint8_t op;
@@ -491,19 +489,16 @@ void FunctionBuilder::AddPropAccess(ValueOp value_op, std::size_t offset,
   }
 
   if (offset < 256) op |= OP_BYTE;
-  auto* an = code_node_->getList()->newNode<ANVarAccess>(op, offset);
-  if (name) {
-    an->name = std::move(name).value();
-  }
+  code_node_->code.addVarAccess(op, offset, name);
 }
 
-void FunctionBuilder::AddLoadClassOp(std::string name, std::size_t class_num) {
-  auto* node = code_node_->getList()->newNode<ANOpUnsign>(op_class, class_num);
-  node->name = std::move(name);
+void FunctionBuilder::AddLoadClassOp(std::string_view name,
+                                     std::size_t class_num) {
+  code_node_->code.addUnsigned(op_class, class_num, name);
 }
 
 void FunctionBuilder::AddLoadSelfOp() {
-  code_node_->getList()->newNode<ANOpCode>(op_selfID);
+  code_node_->code.addOp(op_selfID);
 }
 
 void FunctionBuilder::AddUnOp(UnOp op) {
@@ -521,11 +516,11 @@ void FunctionBuilder::AddUnOp(UnOp op) {
     default:
       throw std::runtime_error("Invalid unary operation");
   }
-  code_node_->getList()->newNode<ANOpCode>(opcode);
+  code_node_->code.addOp(opcode);
 }
 
 void FunctionBuilder::AddBinOp(BinOp op) {
-  code_node_->getList()->newNode<ANOpCode>(GetBinOpValue(op));
+  code_node_->code.addOp(GetBinOpValue(op));
 }
 
 void FunctionBuilder::AddBranchOp(BranchOp op, LabelRef* target) {
@@ -543,58 +538,51 @@ void FunctionBuilder::AddBranchOp(BranchOp op, LabelRef* target) {
     default:
       throw std::runtime_error("Invalid branch operation");
   }
-  auto* branch = code_node_->getList()->newNode<ANBranch>(opcode);
-  target->ref_.RegisterCallback(
-      [branch](ANLabel* target) { branch->target = target; });
+  auto* code = &code_node_->code;
+  auto branch = code->addBranch(opcode);
+  target->ref_.RegisterCallback([code, branch](std::size_t label) {
+    code->setBranchTarget(branch, label);
+  });
 }
 
 void FunctionBuilder::AddLabel(LabelRef* label) {
-  auto* an_label = code_node_->getList()->newNode<ANLabel>();
-  label->ref_.Resolve(an_label);
+  label->ref_.Resolve(code_node_->code.addLabel());
 }
 
-void FunctionBuilder::AddProcCall(std::string name, std::size_t numArgs,
+void FunctionBuilder::AddProcCall(std::string_view name, std::size_t numArgs,
                                   PtrRef* target) {
-  ANCall* call =
-      code_node_->getList()->newNode<ANCall>(std::move(name), target_);
-  call->numArgs = 2 * numArgs;
+  auto* code = &code_node_->code;
+  auto ref = code->addRef();
+  code->addCall(ref, name, 2 * numArgs);
   target->ref_.RegisterCallback(
-      [call](ANode* target) { call->target = target; });
+      [code, ref](ANode* target) { code->setRef(ref, target); });
 }
 
-void FunctionBuilder::AddExternCall(std::string name, std::size_t numArgs,
+void FunctionBuilder::AddExternCall(std::string_view name, std::size_t numArgs,
                                     std::size_t script_num, std::size_t entry) {
-  ANOpExtern* ext_call = code_node_->getList()->newNode<ANOpExtern>(
-      std::move(name), target_, script_num, entry);
-  ext_call->numArgs = 2 * numArgs;
+  code_node_->code.addExtern(name, script_num, entry, 2 * numArgs);
 }
 
-void FunctionBuilder::AddKernelCall(std::string name, std::size_t numArgs,
+void FunctionBuilder::AddKernelCall(std::string_view name, std::size_t numArgs,
                                     std::size_t entry) {
-  ANOpExtern* ext_call = code_node_->getList()->newNode<ANOpExtern>(
-      std::move(name), target_, -1, entry);
-  ext_call->numArgs = 2 * numArgs;
+  code_node_->code.addExtern(name, -1, entry, 2 * numArgs);
 }
 
 void FunctionBuilder::AddSend(std::size_t numArgs) {
-  ANSend* send = code_node_->getList()->newNode<ANSend>(target_, op_send);
-  send->numArgs = 2 * numArgs;
+  code_node_->code.addSend(op_send, 2 * numArgs);
 }
 
 void FunctionBuilder::AddSelfSend(std::size_t numArgs) {
-  ANSend* send = code_node_->getList()->newNode<ANSend>(target_, op_self);
-  send->numArgs = 2 * numArgs;
+  code_node_->code.addSend(op_self, 2 * numArgs);
 }
 
-void FunctionBuilder::AddSuperSend(std::string name, std::size_t numArgs,
+void FunctionBuilder::AddSuperSend(std::string_view name, std::size_t numArgs,
                                    std::size_t species) {
-  auto* send = code_node_->getList()->newNode<ANSuper>(target_, std::move(name),
-                                                       species);
-  send->numArgs = 2 * numArgs;
+  code_node_->code.addSuper(name, species, 2 * numArgs);
 }
 
 void FunctionBuilder::AddReturnOp() {
-  code_node_->getList()->newNode<ANOpCode>(op_ret);
+  code_node_->code.addOp(op_ret);
 }
 
 FunctionBuilder::FunctionBuilder(SciTargetStrategy const* target,
@@ -623,8 +611,10 @@ std::unique_ptr<CodeGenerator> CodeGenerator::Create(Options options) {
 }
 
 CodeGenerator::CodeGenerator() : active(false) {
-  hunkList = std::make_unique<FixupList>();
-  heapList = std::make_unique<FixupList>();
+  arena = std::make_unique<NodeArena>();
+  names = std::make_unique<NameTable>();
+  hunkList = std::make_unique<FixupList>(arena.get());
+  heapList = std::make_unique<FixupList>(arena.get());
 }
 
 CodeGenerator::~CodeGenerator() = default;
@@ -684,7 +674,7 @@ void CodeGenerator::Assemble(std::string_view source_file_name,
   outputFiles->GetHunk()->WriteByte(0x00);
 
   {
-    CompilerHeapContext heapContext(this);
+    CompilerHeapContext heapContext(heapList.get());
     heapList->emit(&heapContext, outputFiles->GetHeap());
     hunkList->emit(&heapContext, outputFiles->GetHunk());
   }
@@ -722,10 +712,6 @@ void CodeGenerator::AddPublic(std::string name, std::size_t index,
   dispTable->AddPublic(std::move(name), index, &target->ref_);
 }
 
-bool CodeGenerator::IsInHeap(ANode const* node) {
-  return heapList->contains(node);
-}
-
 TextRef CodeGenerator::AddTextNode(std::string_view text) {
   auto it = textNodes.find(text);
   if (it != textNodes.end()) return TextRef(it->second);
@@ -768,10 +754,12 @@ std::unique_ptr<FunctionBuilder> CodeGenerator::CreateFunction(
     PtrRef* ptr_ref) {
   ANCodeBlk* code = std::move(name).visit(
       [&](ProcedureName name) -> ANCodeBlk* {
-        return codeList->newNode<ANProcCode>(std::move(name.procName));
+        return codeList->newNode<ANProcCode>(sci_target, names.get(),
+                                             std::move(name.procName));
       },
       [&](MethodName name) -> ANCodeBlk* {
-        return codeList->newNode<ANMethCode>(std::move(name.methName),
+        return codeList->newNode<ANMethCode>(sci_target, names.get(),
+                                             std::move(name.methName),
                                              std::move(name.objName));
       });
 
@@ -781,13 +769,13 @@ std::unique_ptr<FunctionBuilder> CodeGenerator::CreateFunction(
     // If supported by the configuration, add line number information.
     // procedures and methods get special treatment:  the line number
     // and file name are set here
-    code->getList()->newNode<ANLineNum>(*lineNum);
+    code->code.addLineNum(*lineNum);
   }
 
   // If there are to be any temporary variables, add a link node to
   // create them.
   if (numTemps > 0) {
-    code->getList()->newNode<ANOpUnsign>(op_link, numTemps);
+    code->code.addUnsigned(op_link, numTemps);
   }
 
   return absl::WrapUnique(new FunctionBuilder(sci_target, code));
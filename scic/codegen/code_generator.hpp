@@ -16,6 +16,8 @@
 #include "scic/codegen/anode.hpp"
 #include "scic/codegen/anode_impls.hpp"
 #include "scic/codegen/fixup_list.hpp"
+#include "scic/codegen/name_table.hpp"
+#include "scic/codegen/node_arena.hpp"
 #include "scic/codegen/output.hpp"
 #include "scic/codegen/target.hpp"
 #include "scic/codegen/text_sink.hpp"
@@ -146,7 +148,7 @@ class LabelRef {
  private:
   friend class FunctionBuilder;
   LabelRef() = default;
-  ForwardRef<ANLabel*> ref_;
+  ForwardRef<std::size_t> ref_;
 };
 
 class FunctionBuilder {
@@ -244,7 +246,7 @@ class FunctionBuilder {
   //
   //
   void AddLoadOffsetTo(PtrRef* ptr,
-                       std::optional<std::string> name = std::nullopt);
+                       std::optional<std::string_view> name = std::nullopt);
 
   // Load the effective address of the given variable.
   //
@@ -254,7 +256,8 @@ class FunctionBuilder {
   // If add_accum_index is true, it will also add the accumulator index to the
   // offset before loading the address.
   void AddLoadVarAddr(VarType var_type, std::size_t offset,
-                      bool add_accum_index, std::optional<std::string> name);
+                      bool add_accum_index,
+                      std::optional<std::string_view> name);
 
   // Add a variable access operation.
   //
@@ -264,7 +267,8 @@ class FunctionBuilder {
   // If add_accum_index is true, it will also add the accumulator index to the
   // offset before performing the access.
   void AddVarAccess(VarType var_type, ValueOp value_op, std::size_t offset,
-                    bool add_accum_index, std::optional<std::string> name);
+                    bool add_accum_index,
+                    std::optional<std::string_view> name);
 
   // Add a property access operation.
   //
@@ -272,10 +276,10 @@ class FunctionBuilder {
   //
   // It is not possible to index a property with the accumulator.
   void AddPropAccess(ValueOp value_op, std::size_t offset,
-                     std::optional<std::string> name);
+                     std::optional<std::string_view> name);
 
   // Loads a pointer to the class with the given species into the accumulator.
-  void AddLoadClassOp(std::string name, std::size_t species);
+  void AddLoadClassOp(std::string_view name, std::size_t species);
 
   // Loads a pointer to the current object into the accumulator.
   void AddLoadSelfOp();
@@ -302,17 +306,19 @@ class FunctionBuilder {
   void AddLabel(LabelRef* label);
 
   // Adds a call to the given procedure.
-  void AddProcCall(std::string name, std::size_t numArgs, PtrRef* target);
+  void AddProcCall(std::string_view name, std::size_t numArgs, PtrRef* target);
 
-  void AddExternCall(std::string name, std::size_t numArgs,
+  void AddExternCall(std::string_view name, std::size_t numArgs,
                      std::size_t script_num, std::size_t entry);
 
-  void AddKernelCall(std::string name, std::size_t numArgs, std::size_t entry);
+  void AddKernelCall(std::string_view name, std::size_t numArgs,
+                     std::size_t entry);
 
   // Send methods.
   void AddSend(std::size_t numArgs);
   void AddSelfSend(std::size_t numArgs);
-  void AddSuperSend(std::string name, std::size_t numArgs, std::size_t species);
+  void AddSuperSend(std::string_view name, std::size_t numArgs,
+                    std::size_t species);
 
   // Add a Return.
   void AddReturnOp();
@@ -340,8 +346,6 @@ class CodeGenerator {
 
   void AddPublic(std::string name, std::size_t index, PtrRef* target);
 
-  bool IsInHeap(ANode const* node);
-
   TextRef AddTextNode(std::string_view text);
 
   // Returns the current number of variables.
@@ -369,6 +373,10 @@ class CodeGenerator {
   SciTargetStrategy const* sci_target;
   Optimization opt;
   bool active;
+  // Owns every node in the heap and hunk lists.
+  std::unique_ptr<NodeArena> arena;
+  // The names of the symbols the code refers to, for the listing.
+  std::unique_ptr<NameTable> names;
   std::unique_ptr<FixupList> heapList;
   std::unique_ptr<FixupList> hunkList;
   std::vector<Var> localVars;
@@ -0,0 +1,91 @@
+//	control_flow.cpp
+// 	the basic blocks of a procedure or method
+
+#include "scic/codegen/control_flow.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/opcodes.hpp"
+
+namespace codegen {
+
+namespace {
+
+bool IsBranch(std::uint32_t op) {
+  switch (op & ~OP_BYTE) {
+    case op_bt:
+    case op_bnt:
+    case op_jmp:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+bool EndsBlock(std::uint32_t op) {
+  return IsBranch(op) || (op & ~OP_BYTE) == op_ret;
+}
+
+}  // namespace
+
+ControlFlowGraph ControlFlowGraph::Build(CodeBuffer const* code) {
+  ControlFlowGraph cfg;
+  auto& blocks = cfg.blocks_;
+  cfg.block_of_.assign(code->length(), npos);
+
+  // Split the code into blocks. A label that follows another label is in the
+  // same block, so that branches to either go to the same place.
+  bool block_ended = true;
+  for (auto i = code->next(npos); i != npos; i = code->next(i)) {
+    if (block_ended || (code->op(i) == OP_LABEL &&
+                        code->op(blocks.back().last) != OP_LABEL)) {
+      blocks.push_back(Block{.first = i, .last = i});
+    }
+    blocks.back().last = i;
+    cfg.block_of_[i] = blocks.size() - 1;
+    block_ended = EndsBlock(code->op(i));
+  }
+
+  auto addEdge = [&blocks](std::size_t from, std::size_t to) {
+    auto& succs = blocks[from].succs;
+    if (std::find(succs.begin(), succs.end(), to) != succs.end()) {
+      return;
+    }
+    succs.push_back(to);
+    blocks[to].preds.push_back(from);
+  };
+
+  for (std::size_t b = 0; b < blocks.size(); ++b) {
+    auto last = blocks[b].last;
+    auto op = code->op(last) & ~OP_BYTE;
+
+    if (IsBranch(op)) {
+      if (code->target(last) == CodeBuffer::kNone) {
+        blocks[b].exits = true;
+      } else {
+        addEdge(b, cfg.BlockOf(code->labelIndex(code->target(last))));
+      }
+    }
+
+    if (op != op_jmp && op != op_ret) {
+      if (b + 1 < blocks.size()) {
+        addEdge(b, b + 1);
+      } else {
+        blocks[b].exits = true;
+      }
+    }
+  }
+
+  return cfg;
+}
+
+bool ControlFlowGraph::OnlyEnteredFromPrevious(std::size_t b) const {
+  auto const& preds = blocks_[b].preds;
+  return b > 0 && preds.size() == 1 && preds[0] == b - 1;
+}
+
+}  // namespace codegen
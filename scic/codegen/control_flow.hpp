@@ -0,0 +1,64 @@
+//	control_flow.hpp
+// 	the basic blocks of a procedure or method
+
+#ifndef CONTROL_FLOW_HPP
+#define CONTROL_FLOW_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "scic/codegen/code_buffer.hpp"
+
+namespace codegen {
+
+// The basic blocks of a code block, and the edges between them.
+//
+// A block starts at the first instruction, at a label (or a run of labels),
+// and after every branch or ret. It ends with the instruction before the
+// next block starts. Control enters a block only at its start, and leaves it
+// only from its last instruction: through its branch, by falling through to
+// the next block, or with a ret.
+//
+// The graph describes the code as it was when it was built. It stays usable
+// as instructions other than branches are removed, though the first or last
+// instruction of a block may then be one that was removed. Changing a branch
+// makes it out of date.
+class ControlFlowGraph {
+ public:
+  static constexpr std::size_t npos = CodeBuffer::npos;
+
+  struct Block {
+    // The indices of the first and last instructions of the block.
+    std::size_t first;
+    std::size_t last;
+    // The blocks control can come from, and go to.
+    std::vector<std::size_t> preds = {};
+    std::vector<std::size_t> succs = {};
+    // Set if control can leave the block for somewhere unknown: off the end
+    // of the code, or through a branch whose target isn't set.
+    bool exits = false;
+  };
+
+  static ControlFlowGraph Build(CodeBuffer const* code);
+
+  std::size_t size() const { return blocks_.size(); }
+  Block const& block(std::size_t b) const { return blocks_[b]; }
+
+  // Returns the block holding instruction i, which must not have been removed
+  // when the graph was built.
+  std::size_t BlockOf(std::size_t i) const { return block_of_[i]; }
+
+  // Returns true iff control only enters the block from the end of the block
+  // before it, so whatever held there still holds at its start.
+  bool OnlyEnteredFromPrevious(std::size_t b) const;
+
+ private:
+  ControlFlowGraph() = default;
+
+  std::vector<Block> blocks_;
+  std::vector<std::size_t> block_of_;
+};
+
+}  // namespace codegen
+
+#endif
@@ -0,0 +1,99 @@
+#include "scic/codegen/control_flow.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/name_table.hpp"
+#include "scic/codegen/opcodes.hpp"
+#include "scic/codegen/target.hpp"
+
+namespace codegen {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(ControlFlowGraphTest, SplitsAtLabelsAndBranches) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  // if (acc) { push0 } else { push1 }; ret
+  auto bnt = code.addBranch(op_bnt);
+  code.addOp(op_push0);
+  auto jmp = code.addBranch(op_jmp);
+  auto else_label = code.addLabel();
+  code.addOp(op_push1);
+  auto end_label = code.addLabel();
+  auto ret = code.addOp(op_ret);
+  code.setBranchTarget(bnt, else_label);
+  code.setBranchTarget(jmp, end_label);
+
+  auto cfg = ControlFlowGraph::Build(&code);
+  ASSERT_EQ(cfg.size(), 4);
+  EXPECT_EQ(cfg.BlockOf(bnt), 0);
+  EXPECT_EQ(cfg.BlockOf(jmp), 1);
+  EXPECT_EQ(cfg.BlockOf(code.labelIndex(else_label)), 2);
+  EXPECT_EQ(cfg.BlockOf(ret), 3);
+
+  EXPECT_THAT(cfg.block(0).succs, ElementsAre(2, 1));
+  EXPECT_THAT(cfg.block(1).succs, ElementsAre(3));
+  EXPECT_THAT(cfg.block(2).preds, ElementsAre(0));
+  EXPECT_THAT(cfg.block(3).preds, ElementsAre(1, 2));
+  EXPECT_THAT(cfg.block(3).succs, IsEmpty());
+  EXPECT_FALSE(cfg.block(3).exits);
+
+  EXPECT_TRUE(cfg.OnlyEnteredFromPrevious(1));
+  EXPECT_FALSE(cfg.OnlyEnteredFromPrevious(2));
+  EXPECT_FALSE(cfg.OnlyEnteredFromPrevious(3));
+}
+
+TEST(ControlFlowGraphTest, MergesAdjacentLabels) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto jmp = code.addBranch(op_jmp);
+  auto first = code.addLabel();
+  auto second = code.addLabel();
+  code.addOp(op_ret);
+  code.setBranchTarget(jmp, second);
+
+  auto cfg = ControlFlowGraph::Build(&code);
+  ASSERT_EQ(cfg.size(), 2);
+  EXPECT_EQ(cfg.BlockOf(code.labelIndex(first)),
+            cfg.BlockOf(code.labelIndex(second)));
+  EXPECT_TRUE(cfg.OnlyEnteredFromPrevious(1));
+}
+
+TEST(ControlFlowGraphTest, LoopsAndExits) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto top = code.addLabel();
+  code.addOp(op_push);
+  auto bt = code.addBranch(op_bt);
+  code.setBranchTarget(bt, top);
+  code.addOp(op_toss);
+
+  auto cfg = ControlFlowGraph::Build(&code);
+  ASSERT_EQ(cfg.size(), 2);
+  EXPECT_THAT(cfg.block(0).preds, ElementsAre(0));
+  EXPECT_THAT(cfg.block(0).succs, ElementsAre(0, 1));
+  // The code runs off its end after the toss.
+  EXPECT_TRUE(cfg.block(1).exits);
+}
+
+TEST(ControlFlowGraphTest, SkipsRemovedInstructions) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  code.addOp(op_push);
+  auto jmp = code.addBranch(op_jmp);
+  auto ret = code.addOp(op_ret);
+  code.remove(jmp);
+
+  auto cfg = ControlFlowGraph::Build(&code);
+  ASSERT_EQ(cfg.size(), 1);
+  EXPECT_EQ(cfg.block(0).last, ret);
+}
+
+}  // namespace
+}  // namespace codegen
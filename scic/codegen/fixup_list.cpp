@@ -1,8 +1,6 @@
 #include "scic/codegen/fixup_list.hpp"
 
 #include <cstddef>
-#include <memory>
-#include <utility>
 
 #include "scic/codegen/alist.hpp"
 #include "scic/codegen/anode.hpp"
@@ -58,10 +56,11 @@ class ANWordPadding : public ANode {
 // Class FixupList
 ///////////////////////////////////////////////////
 
-FixupList::FixupList() {
-  auto root = std::make_unique<ANComposite<ANode>>();
+FixupList::FixupList(NodeArena* arena) {
+  auto* root = arena->New<ANComposite<ANode>>();
   auto* list = root->getList();
-  root_ = std::move(root);
+  list->setArena(arena);
+  root_ = root;
   auto* fixupOffsetNode = list->newNode<ANOffsetWord>(nullptr, 0);
   bodyList_ = list->newNode<ANTable>("object file body")->getList();
   // We need padding before the fixup table to ensure it is word-aligned.
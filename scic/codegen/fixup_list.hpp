@@ -2,11 +2,11 @@
 #define FIXUP_LIST_HPP
 
 #include <cstddef>
-#include <memory>
 
 #include "scic/codegen/alist.hpp"
 #include "scic/codegen/anode.hpp"
 #include "scic/codegen/listing.hpp"
+#include "scic/codegen/node_arena.hpp"
 #include "scic/codegen/output.hpp"
 
 namespace codegen {
@@ -25,7 +25,9 @@ class FixupList {
   // by the interpreter at load time.  It builds a table of offsets needing
   // relocation which is appended to the end of the object code being generated.
  public:
-  FixupList();
+  // The nodes of the list are allocated from the given arena, which must
+  // outlive the list.
+  explicit FixupList(NodeArena* arena);
   ~FixupList();
 
   void list(ListingFile* listFile);
@@ -44,11 +46,12 @@ class FixupList {
    */
   void addFixup(ANode const* node, std::size_t rel_ofs);
 
-  bool contains(ANode const* ln) { return root_->contains(ln); }
+  // Adds every node in the list to the set.
+  void collectNodes(ANodeSet* nodes) const { root_->collectNodes(nodes); }
 
   ANodeList* getBody() { return bodyList_; }
 
-  ANode* getRoot() { return root_.get(); }
+  ANode* getRoot() { return root_; }
 
  protected:
   struct Offset {
@@ -60,7 +63,7 @@ class FixupList {
       return *node_base->offset + rel_offset;
     }
   };
-  std::unique_ptr<ANode> root_;
+  ANode* root_;
   ANodeList* bodyList_;
   ANodeList* fixupList_;
 };
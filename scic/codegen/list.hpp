@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <memory>
 
+#include "scic/codegen/node_arena.hpp"
 #include "util/types/casts.hpp"
 
 namespace codegen {
@@ -21,6 +22,7 @@ class TNode {
 
  private:
   friend class TListBase;
+  friend class NodeArena;
 
   template <class T>
   friend class TList;
@@ -48,7 +50,11 @@ class TNode {
 
 class TListBase {
  public:
-  TListBase() : head_(nullptr), tail_(nullptr) {}
+  TListBase() : head_(nullptr), tail_(nullptr), arena_(nullptr) {}
+
+  // The arena that nodes created by the list are allocated from.
+  NodeArena* arena() const { return arena_; }
+  void setArena(NodeArena* arena) { arena_ = arena; }
 
   // Add ln to the tail of the list.
   void addBack(TNode* ln);
@@ -72,6 +78,7 @@ class TListBase {
 
   TNode* head_;
   TNode* tail_;
+  NodeArena* arena_;
 };
 
 template <class T>
@@ -173,37 +180,6 @@ class TList {
    public:
     iterator() : IteratorBase<iterator, T>() {}
 
-    // Add node nn before node ln in the list.
-    void addBefore(std::unique_ptr<T> nn) {
-      if (this->curr_item_ == nullptr) {
-        this->parent_->addBack(nn.release());
-      } else {
-        this->curr_item_->InsertBefore(nn.release());
-      }
-    }
-
-    void addAfter(std::unique_ptr<T> nn) {
-      assert(this->curr_item_);
-      this->curr_item_->InsertAfter(nn.release());
-    }
-
-    std::unique_ptr<T> remove() {
-      assert(this->curr_item_);
-      auto* next = this->curr_item_->next_;
-      this->curr_item_->RemoveFromList();
-      return std::unique_ptr<T>(this->curr_item_);
-      this->curr_item_ = down_cast<T>(next);
-    }
-
-    std::unique_ptr<T> replaceWith(std::unique_ptr<T> nn) {
-      assert(this->curr_item_);
-      auto* removed_node = this->curr_item_;
-      auto* new_node = nn.release();
-      removed_node->ReplaceWith(new_node);
-      this->curr_item_ = new_node;
-      return std::unique_ptr<T>(removed_node);
-    }
-
    private:
     friend class TList;
     friend class const_iterator;
@@ -249,27 +225,26 @@ class TList {
 
   T* frontPtr() { return down_cast<T>(list_->front()); }
 
-  // Delete all elements in the list.
+  NodeArena* arena() const { return list_->arena(); }
+  void setArena(NodeArena* arena) { list_->setArena(arena); }
+
+  // Remove all elements from the list. The nodes themselves are owned by
+  // the arena.
   void clear() {
-    while (true) {
-      TNode* ln = list_->removeFront();
-      if (!ln) break;
-      delete ln;
+    while (list_->removeFront()) {
     }
   }
 
-  // Add ln to the tail of the list.
-  T* addBack(std::unique_ptr<T> ln) {
-    auto* node = ln.release();
-    list_->addBack(node);
-    return node;
+  // Add ln to the tail of the list. The node must belong to the list's arena.
+  T* addBack(T* ln) {
+    list_->addBack(ln);
+    return ln;
   }
 
-  // Add ln to the head of the list.
-  T* addFront(std::unique_ptr<T> ln) {
-    auto* node = ln.release();
-    list_->addFront(node);
-    return node;
+  // Add ln to the head of the list. The node must belong to the list's arena.
+  T* addFront(T* ln) {
+    list_->addFront(ln);
+    return ln;
   }
 
   bool contains(T* ln) { return list_->contains(ln); }
@@ -0,0 +1,391 @@
+//	liveness.cpp
+// 	which registers hold values that later code still needs
+
+#include "scic/codegen/liveness.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/control_flow.hpp"
+#include "scic/codegen/opcodes.hpp"
+
+namespace codegen {
+
+#define isVarAccess(op) bool((op) & OP_LDST)
+#define isStore(op) (((op) & OP_TYPE) == OP_STORE)
+#define indexed(op) ((op) & OP_INDEX)
+#define toStack(op) ((op) & OP_STACK)
+
+bool OpReadsAccum(CodeBuffer const* code, std::size_t i) {
+  // OP_LABEL is a pseudo-op, and doesn't use the accumulator.
+  if (code->op(i) == OP_LABEL) {
+    return false;
+  }
+  // We don't care about the byte flag here.
+  uint8_t op = code->op(i) & ~OP_BYTE;
+
+  // Operations are listed in opcode order, to make it easier to make sure
+  // none are missed.
+  switch (op) {
+    // All math/logic ops use the accumulator.
+    case op_bnot:
+    case op_add:
+    case op_sub:
+    case op_mul:
+    case op_div:
+    case op_mod:
+    case op_shr:
+    case op_shl:
+    case op_xor:
+    case op_and:
+    case op_or:
+    case op_neg:
+    case op_not:
+      return true;
+
+    // All comparison ops use the accumulator
+    case op_eq:
+    case op_ne:
+    case op_gt:
+    case op_ge:
+    case op_lt:
+    case op_le:
+    case op_ugt:
+    case op_uge:
+    case op_ult:
+    case op_ule:
+      return true;
+
+    // The conditional branches test the accumulator. Where execution goes
+    // after a branch is up to the liveness pass.
+    case op_bt:
+    case op_bnt:
+      return true;
+
+    case op_jmp:
+      return false;
+
+    case op_loadi:
+      return false;
+
+    case op_push:
+      return true;
+
+    case op_pushi:
+    case op_toss:
+    case op_dup:
+    case op_link:
+      return false;
+
+    case op_call:
+      return true;
+
+    // The non-local calls all use op parameters to choose which procedure to
+    // call.
+    case op_callk:
+    case op_callb:
+    case op_calle:
+      return false;
+
+    case op_ret:
+    case op_send:
+      return true;
+
+    case op_class:
+      return false;
+
+    // self and super are like send, but take the object from the environment.
+    // They do not read the accumulator.
+    case op_self:
+    case op_super:
+      return false;
+
+    case op_rest:
+      return false;
+
+    case op_lea: {
+      // LEA is a bit trickier, as we have to look at the parameters to the
+      // instruction to see if it's indexed, and thus reads the accumulator.
+      return (code->extra(i) & OP_INDEX) != 0;
+    }
+
+    case op_selfID:
+    case op_pprev:
+      return false;
+
+    // Only the store accum to property instruction uses the accumulator.
+    case op_pToa:
+      return false;
+
+    case op_aTop:
+      return true;
+
+    case op_pTos:
+    case op_sTop:
+    case op_ipToa:
+    case op_dpToa:
+    case op_ipTos:
+    case op_dpTos:
+      return false;
+
+    case op_lofsa:
+    case op_lofss:
+    case op_push0:
+    case op_push1:
+    case op_push2:
+    case op_pushSelf:
+      return false;
+
+    // Line numbers are only debug information.
+    case op_lineNum:
+      return false;
+
+    default: {
+      // This should be a variable access. Everything else should be an invalid
+      // opcode.
+      if (!isVarAccess(op)) {
+        throw std::runtime_error("Invalid opcode");
+      }
+
+      // There are two ways for this opcode to use the accumulator: Either it's
+      // storing the accumulator to the variable, or it's indexing the variable
+      // offset with the accumulator.
+      return (isStore(op) && !toStack(op)) || indexed(op);
+    }
+  }
+}
+
+bool OpCanModifyAccum(CodeBuffer const* code, std::size_t i) {
+  // OP_LABEL is a pseudo-op, and doesn't modify the accumulator.
+  if (code->op(i) == OP_LABEL) {
+    return false;
+  }
+
+  // We don't care about the byte flag here.
+  uint8_t op = code->op(i) & ~OP_BYTE;
+
+  // Operations are listed in opcode order, to make it easier to make sure
+  // none are missed.
+  switch (op) {
+    // All math/logic ops modify the accumulator.
+    case op_bnot:
+    case op_add:
+    case op_sub:
+    case op_mul:
+    case op_div:
+    case op_mod:
+    case op_shr:
+    case op_shl:
+    case op_xor:
+    case op_and:
+    case op_or:
+    case op_neg:
+    case op_not:
+      return true;
+
+    // All comparison ops modify the accumulator
+    case op_eq:
+    case op_ne:
+    case op_gt:
+    case op_ge:
+    case op_lt:
+    case op_le:
+    case op_ugt:
+    case op_uge:
+    case op_ult:
+    case op_ule:
+      return true;
+
+    // Branch instructions don't modify the accumulator
+    case op_bt:
+    case op_bnt:
+    case op_jmp:
+      return false;
+
+    case op_loadi:
+      return true;
+
+    case op_push:
+      return false;
+
+    case op_pushi:
+    case op_toss:
+    case op_dup:
+    case op_link:
+      return false;
+
+    // All calls modify the accumulator
+    case op_call:
+    case op_callk:
+    case op_callb:
+    case op_calle:
+      return true;
+
+    case op_ret:
+      return false;
+
+    case op_send:
+    case op_class:
+    case op_self:
+    case op_super:
+      return true;
+
+    case op_rest:
+      return false;
+
+    case op_lea:
+    case op_selfID:
+      return true;
+
+    case op_pprev:
+      return false;
+
+    // Only the store accum to property instruction uses the accumulator.
+    case op_pToa:
+      return true;
+
+    case op_aTop:
+    case op_pTos:
+    case op_sTop:
+      return false;
+
+    case op_ipToa:
+    case op_dpToa:
+      return true;
+
+    case op_ipTos:
+    case op_dpTos:
+      return false;
+
+    case op_lofsa:
+      return true;
+    case op_lofss:
+    case op_push0:
+    case op_push1:
+    case op_push2:
+    case op_pushSelf:
+      return false;
+
+    case op_lineNum:
+      return false;
+
+    default: {
+      // This should be a variable access. Everything else should be an invalid
+      // opcode.
+      if (!isVarAccess(op)) {
+        throw std::runtime_error("Invalid opcode");
+      }
+
+      // For this to modify the accumulator, it must be loading the variable
+      // to the accumulator (which is all types aside from store).
+      return !isStore(op) && !toStack(op);
+    }
+  }
+}
+
+namespace {
+
+// The registers the instruction reads.
+std::uint8_t Uses(CodeBuffer const* code, std::size_t i) {
+  std::uint8_t uses = 0;
+  if (OpReadsAccum(code, i)) {
+    uses |= Liveness::kAccum;
+  }
+  if ((code->op(i) & ~OP_BYTE) == op_pprev) {
+    uses |= Liveness::kPrev;
+  }
+  return uses;
+}
+
+// The registers the instruction always overwrites.
+std::uint8_t Defs(CodeBuffer const* code, std::size_t i) {
+  if (code->op(i) == OP_LABEL) {
+    return 0;
+  }
+
+  std::uint8_t defs = 0;
+  if (OpCanModifyAccum(code, i)) {
+    defs |= Liveness::kAccum;
+  }
+  switch (code->op(i) & ~OP_BYTE) {
+    // The comparisons keep their left operand in prev.
+    case op_eq:
+    case op_ne:
+    case op_gt:
+    case op_ge:
+    case op_lt:
+    case op_le:
+    case op_ugt:
+    case op_uge:
+    case op_ult:
+    case op_ule:
+      defs |= Liveness::kPrev;
+      break;
+  }
+  return defs;
+}
+
+constexpr std::uint8_t kAll = Liveness::kAccum | Liveness::kPrev;
+
+}  // namespace
+
+Liveness Liveness::Compute(CodeBuffer const* code) {
+  return Compute(code, ControlFlowGraph::Build(code));
+}
+
+Liveness Liveness::Compute(CodeBuffer const* code,
+                           ControlFlowGraph const& cfg) {
+  Liveness liveness;
+  liveness.live_in_.assign(code->length(), 0);
+  liveness.live_out_.assign(code->length(), 0);
+
+  // Carries the liveness at the end of a block back through it, recording it
+  // at each instruction, and returns the liveness at its start. The graph may
+  // predate removals from the block, so start from its last remaining
+  // instruction.
+  auto throughBlock = [&](ControlFlowGraph::Block const& block,
+                          std::uint8_t live) {
+    auto last = code->isRemoved(block.last) ? code->prev(block.last)
+                                            : block.last;
+    for (auto i = last; i != CodeBuffer::npos && i >= block.first;
+         i = code->prev(i)) {
+      liveness.live_out_[i] = live;
+      live = Uses(code, i) | (live & ~Defs(code, i));
+      liveness.live_in_[i] = live;
+    }
+    return live;
+  };
+
+  // The liveness at the start of each block.
+  std::vector<std::uint8_t> block_in(cfg.size(), 0);
+  auto liveAtEnd = [&](ControlFlowGraph::Block const& block) {
+    std::uint8_t live = block.exits ? kAll : 0;
+    for (auto succ : block.succs) {
+      live |= block_in[succ];
+    }
+    return live;
+  };
+
+  // Sweep the blocks backwards until nothing changes. Each sweep carries
+  // liveness through straight-line code and forward branches, so it only
+  // takes another one for each level of loop nesting.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto b = cfg.size(); b-- > 0;) {
+      auto const& block = cfg.block(b);
+      auto live = throughBlock(block, liveAtEnd(block));
+      if (live != block_in[b]) {
+        block_in[b] = live;
+        changed = true;
+      }
+    }
+  }
+
+  return liveness;
+}
+
+}  // namespace codegen
@@ -0,0 +1,65 @@
+//	liveness.hpp
+// 	which registers hold values that later code still needs
+
+#ifndef LIVENESS_HPP
+#define LIVENESS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/control_flow.hpp"
+
+namespace codegen {
+
+// Returns true iff the instruction reads the accumulator.
+bool OpReadsAccum(CodeBuffer const* code, std::size_t i);
+
+// Returns true iff the instruction can modify the accumulator.
+bool OpCanModifyAccum(CodeBuffer const* code, std::size_t i);
+
+// The registers whose values are still needed at each instruction of a code
+// block.
+//
+// A register is live at a point if some path from there reads it before
+// overwriting it. This is computed once for the whole code block by a
+// backward pass over its control flow graph. A ret ends a path, and leaving
+// the code any other way is taken to need everything.
+//
+// The result describes the code as it was when it was computed. Rewrites that
+// only drop reads or add writes leave it conservative; any other rewrite
+// means it has to be computed again.
+class Liveness {
+ public:
+  // The registers that are tracked, as bits of a mask.
+  enum Register : std::uint8_t {
+    kAccum = 1 << 0,
+    // The prev register, which holds the left operand of the last comparison
+    // and is pushed by op_pprev.
+    kPrev = 1 << 1,
+  };
+
+  static Liveness Compute(CodeBuffer const* code);
+  // As above, with the graph of the code as it is now.
+  static Liveness Compute(CodeBuffer const* code, ControlFlowGraph const& cfg);
+
+  // Returns true iff the register may be read before being overwritten,
+  // starting just before (or just after) instruction i.
+  bool LiveBefore(std::size_t i, Register reg) const {
+    return (live_in_[i] & reg) != 0;
+  }
+  bool LiveAfter(std::size_t i, Register reg) const {
+    return (live_out_[i] & reg) != 0;
+  }
+
+ private:
+  Liveness() = default;
+
+  std::vector<std::uint8_t> live_in_;
+  std::vector<std::uint8_t> live_out_;
+};
+
+}  // namespace codegen
+
+#endif
@@ -0,0 +1,113 @@
+#include "scic/codegen/liveness.hpp"
+
+#include "gtest/gtest.h"
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/control_flow.hpp"
+#include "scic/codegen/name_table.hpp"
+#include "scic/codegen/opcodes.hpp"
+#include "scic/codegen/target.hpp"
+
+namespace codegen {
+namespace {
+
+// lat: loads a temporary variable into the accumulator.
+constexpr auto kLoadTmp = OP_LDST | OP_LOAD | OP_TMP | OP_BYTE;
+
+TEST(LivenessTest, StraightLineCode) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto load = code.addVarAccess(kLoadTmp, 0, "x");
+  auto push = code.addOp(op_push);
+  auto loadi = code.addSigned(op_loadi, 5);
+  auto ret = code.addOp(op_ret);
+
+  auto liveness = Liveness::Compute(&code);
+  EXPECT_FALSE(liveness.LiveBefore(load, Liveness::kAccum));
+  EXPECT_TRUE(liveness.LiveAfter(load, Liveness::kAccum));
+  EXPECT_FALSE(liveness.LiveAfter(push, Liveness::kAccum));
+  EXPECT_TRUE(liveness.LiveAfter(loadi, Liveness::kAccum));
+  EXPECT_FALSE(liveness.LiveAfter(ret, Liveness::kAccum));
+}
+
+TEST(LivenessTest, FollowsJumps) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  // The accumulator is overwritten wherever the jmp goes, so the push is its
+  // last use even though the jmp is in between.
+  code.addVarAccess(kLoadTmp, 0, "x");
+  auto push = code.addOp(op_push);
+  auto jmp = code.addBranch(op_jmp);
+  code.addOp(op_ret);
+  code.setBranchTarget(jmp, code.addLabel());
+  code.addSigned(op_loadi, 1);
+  code.addOp(op_ret);
+
+  auto liveness = Liveness::Compute(&code);
+  EXPECT_FALSE(liveness.LiveAfter(push, Liveness::kAccum));
+}
+
+TEST(LivenessTest, LiveAroundLoops) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto top = code.addLabel();
+  auto push = code.addOp(op_push);
+  auto bt = code.addBranch(op_bt);
+  code.setBranchTarget(bt, top);
+  code.addOp(op_ret);
+
+  // The push at the top of the loop reads the accumulator on the next trip.
+  auto liveness = Liveness::Compute(&code);
+  EXPECT_TRUE(liveness.LiveAfter(bt, Liveness::kAccum));
+  EXPECT_TRUE(liveness.LiveAfter(push, Liveness::kAccum));
+}
+
+TEST(LivenessTest, TracksPrev) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto lt = code.addOp(op_lt);
+  auto bnt = code.addBranch(op_bnt);
+  auto pprev = code.addOp(op_pprev);
+  auto gt = code.addOp(op_gt);
+  code.setBranchTarget(bnt, code.addLabel());
+  code.addOp(op_ret);
+
+  auto liveness = Liveness::Compute(&code);
+  EXPECT_FALSE(liveness.LiveBefore(lt, Liveness::kPrev));
+  EXPECT_TRUE(liveness.LiveAfter(lt, Liveness::kPrev));
+  EXPECT_TRUE(liveness.LiveAfter(bnt, Liveness::kPrev));
+  EXPECT_FALSE(liveness.LiveAfter(pprev, Liveness::kPrev));
+  EXPECT_FALSE(liveness.LiveAfter(gt, Liveness::kPrev));
+}
+
+TEST(LivenessTest, SkipsInstructionsRemovedSinceTheGraphWasBuilt) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  code.addSigned(op_loadi, 1);
+  auto push = code.addOp(op_push);
+  auto load = code.addVarAccess(kLoadTmp, 0, "x");
+  code.addLabel();
+  code.addSigned(op_loadi, 2);
+  code.addOp(op_ret);
+
+  auto cfg = ControlFlowGraph::Build(&code);
+  ASSERT_EQ(cfg.block(0).last, load);
+  code.remove(load);
+
+  // The removed load ended the block, but must not be read as an
+  // instruction that uses the accumulator.
+  auto liveness = Liveness::Compute(&code, cfg);
+  EXPECT_FALSE(liveness.LiveAfter(push, Liveness::kAccum));
+}
+
+TEST(LivenessTest, EverythingIsLiveAtTheEnd) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto push = code.addOp(op_push);
+
+  auto liveness = Liveness::Compute(&code);
+  EXPECT_TRUE(liveness.LiveAfter(push, Liveness::kAccum));
+  EXPECT_TRUE(liveness.LiveAfter(push, Liveness::kPrev));
+}
+
+}  // namespace
+}  // namespace codegen
@@ -0,0 +1,19 @@
+#include "scic/codegen/name_table.hpp"
+
+#include <string_view>
+
+namespace codegen {
+
+NameTable::Id NameTable::Intern(std::string_view name) {
+  auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+
+  Id id = names_.size();
+  names_.emplace_back(name);
+  ids_.emplace(names_.back(), id);
+  return id;
+}
+
+}  // namespace codegen
@@ -0,0 +1,51 @@
+//	name_table.hpp
+// 	interned names of the symbols referred to by the generated code
+
+#ifndef NAME_TABLE_HPP
+#define NAME_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace codegen {
+
+// The names of the procedures, variables, properties and classes that the
+// instructions of a module refer to.
+//
+// The names are only needed for the listing, so instructions keep an id
+// rather than a copy of the name. Each distinct name is stored once, however
+// many instructions refer to it.
+class NameTable {
+ public:
+  using Id = std::uint32_t;
+
+  // The id of a missing name.
+  static constexpr Id kNone = Id(-1);
+
+  NameTable() = default;
+
+  NameTable(NameTable const&) = delete;
+  NameTable& operator=(NameTable const&) = delete;
+
+  // Returns the id of the name, adding it to the table if it's new.
+  Id Intern(std::string_view name);
+
+  // Returns the name with the given id, which must not be kNone.
+  std::string_view Get(Id id) const { return names_[id]; }
+
+  std::size_t size() const { return names_.size(); }
+
+ private:
+  // A deque, so that the views in ids_ stay valid as names are added.
+  std::deque<std::string> names_;
+  absl::flat_hash_map<std::string_view, Id> ids_;
+};
+
+}  // namespace codegen
+
+#endif
@@ -0,0 +1,37 @@
+#include "scic/codegen/name_table.hpp"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace codegen {
+namespace {
+
+TEST(NameTableTest, InternsEachNameOnce) {
+  NameTable names;
+  auto foo = names.Intern("foo");
+  auto bar = names.Intern("bar");
+
+  EXPECT_NE(foo, bar);
+  EXPECT_EQ(names.Intern(std::string("foo")), foo);
+  EXPECT_EQ(names.size(), 2);
+  EXPECT_EQ(names.Get(foo), "foo");
+  EXPECT_EQ(names.Get(bar), "bar");
+}
+
+TEST(NameTableTest, NamesStayValidAsTableGrows) {
+  NameTable names;
+  auto first = names.Intern("first");
+  auto view = names.Get(first);
+  for (int i = 0; i < 1000; ++i) {
+    names.Intern("name" + std::to_string(i));
+  }
+
+  EXPECT_EQ(view, "first");
+  EXPECT_EQ(names.Intern("first"), first);
+  EXPECT_EQ(names.Intern("name500"), names.Intern("name500"));
+  EXPECT_EQ(names.size(), 1001);
+}
+
+}  // namespace
+}  // namespace codegen
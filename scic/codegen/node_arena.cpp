@@ -0,0 +1,51 @@
+#include "scic/codegen/node_arena.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "scic/codegen/list.hpp"
+
+namespace codegen {
+
+namespace {
+
+constexpr std::size_t kBlockSize = 64 * 1024;
+
+}  // namespace
+
+NodeArena::NodeArena() = default;
+
+NodeArena::~NodeArena() {
+  // Nodes are destroyed all at once, so there is no point in keeping the
+  // lists consistent while they are. Detaching every node first also means
+  // the order of destruction doesn't matter, even though lists are owned by
+  // the nodes that contain them.
+  for (auto* node : nodes_) {
+    node->list_ = nullptr;
+  }
+  for (auto* node : nodes_) {
+    node->~TNode();
+  }
+}
+
+void* NodeArena::Allocate(std::size_t size, std::size_t align) {
+  auto padding = -reinterpret_cast<std::uintptr_t>(next_) & (align - 1);
+  if (!next_ || padding + size > remaining_) {
+    // Start a new block. The rest of the current one is wasted, but nodes
+    // are small compared to a block.
+    auto block_size = std::max(kBlockSize, size + align);
+    blocks_.push_back(std::make_unique_for_overwrite<std::byte[]>(block_size));
+    next_ = blocks_.back().get();
+    remaining_ = block_size;
+    padding = -reinterpret_cast<std::uintptr_t>(next_) & (align - 1);
+  }
+
+  auto* result = next_ + padding;
+  next_ = result + size;
+  remaining_ -= padding + size;
+  return result;
+}
+
+}  // namespace codegen
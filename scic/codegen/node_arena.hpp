@@ -0,0 +1,59 @@
+//	node_arena.hpp
+// 	definition of the arena that list nodes are allocated from
+
+#ifndef NODE_ARENA_HPP
+#define NODE_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace codegen {
+
+class TNode;
+
+// A monotonic arena for list nodes.
+//
+// Code generation creates a very large number of small nodes, all of which
+// live until the module has been assembled. Rather than allocating each one
+// separately, nodes are carved out of large blocks, and are all destroyed
+// together with the arena.
+class NodeArena {
+ public:
+  NodeArena();
+  ~NodeArena();
+
+  NodeArena(NodeArena const&) = delete;
+  NodeArena& operator=(NodeArena const&) = delete;
+
+  // Creates a node in the arena. The node is owned by the arena, and is
+  // destroyed when the arena is.
+  template <class T, class... Args>
+  T* New(Args&&... args) {
+    void* storage = Allocate(sizeof(T), alignof(T));
+    T* node = new (storage) T(std::forward<Args>(args)...);
+    nodes_.push_back(node);
+    return node;
+  }
+
+  // The number of nodes created in the arena.
+  std::size_t num_nodes() const { return nodes_.size(); }
+
+  // The number of blocks allocated from the system to hold them.
+  std::size_t num_blocks() const { return blocks_.size(); }
+
+ private:
+  void* Allocate(std::size_t size, std::size_t align);
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  // The free space in the current block.
+  std::byte* next_ = nullptr;
+  std::size_t remaining_ = 0;
+  std::vector<TNode*> nodes_;
+};
+
+}  // namespace codegen
+
+#endif
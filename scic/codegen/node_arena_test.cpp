@@ -0,0 +1,66 @@
+#include "scic/codegen/node_arena.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/list.hpp"
+
+namespace codegen {
+namespace {
+
+struct TestNode : TNode {
+  TestNode(int value, std::size_t* num_destroyed)
+      : value(value), num_destroyed(num_destroyed) {}
+  ~TestNode() override { ++*num_destroyed; }
+
+  int value;
+  std::size_t* num_destroyed;
+};
+
+std::vector<int> Values(TList<TestNode> const& list) {
+  std::vector<int> values;
+  for (auto const& node : list) {
+    values.push_back(node.value);
+  }
+  return values;
+}
+
+TEST(NodeArenaTest, AllocatesNodesInBlocks) {
+  std::size_t num_destroyed = 0;
+  constexpr std::size_t kNumNodes = 100000;
+  {
+    NodeArena arena;
+    TList<TestNode> list;
+    list.setArena(&arena);
+    for (std::size_t i = 0; i < kNumNodes; ++i) {
+      list.addBack(arena.New<TestNode>(int(i), &num_destroyed));
+    }
+
+    EXPECT_EQ(arena.num_nodes(), kNumNodes);
+    // Far fewer allocations than nodes.
+    EXPECT_LT(arena.num_blocks() * 100, kNumNodes);
+    EXPECT_EQ(num_destroyed, 0);
+  }
+  EXPECT_EQ(num_destroyed, kNumNodes);
+}
+
+TEST(NodeArenaTest, NodesOutliveTheirList) {
+  std::size_t num_destroyed = 0;
+  NodeArena arena;
+  // The list is destroyed before the arena, as with lists owned by nodes.
+  auto list = std::make_unique<TList<TestNode>>();
+  list->setArena(&arena);
+  for (int i = 0; i < 3; ++i) {
+    list->addBack(arena.New<TestNode>(i, &num_destroyed));
+  }
+  EXPECT_EQ(Values(*list), (std::vector<int>{0, 1, 2}));
+
+  // The nodes belong to the arena until it is destroyed.
+  list = nullptr;
+  EXPECT_EQ(num_destroyed, 0);
+}
+
+}  // namespace
+}  // namespace codegen
@@ -3,18 +3,18 @@
 
 #include "scic/codegen/optimize.hpp"
 
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <ranges>
-#include <stdexcept>
+#include <optional>
 #include <utility>
+#include <vector>
 
-#include "scic/codegen/alist.hpp"
-#include "scic/codegen/anode.hpp"
-#include "scic/codegen/anode_impls.hpp"
-#include "scic/codegen/list.hpp"
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/control_flow.hpp"
+#include "scic/codegen/liveness.hpp"
 #include "scic/codegen/opcodes.hpp"
-#include "util/types/casts.hpp"
 
 namespace codegen {
 
@@ -27,296 +27,29 @@ bool SafeEq(T1 a, T2 b) {
   return T2(a) == b;
 }
 
-ANOpCode const* FindNextOp(AList<ANOpCode> const* list, ANOpCode const* start) {
-  if (!start) {
-    throw new std::runtime_error("start cannot be nullptr");
-  }
-
-  for (auto& opcode :
-       std::ranges::subrange(list->find(start).next(), list->end())) {
-    if (opcode.op != OP_LABEL) {
-      return &opcode;
+// Returns the index of the first instruction after start that isn't a label,
+// or npos if there is none.
+std::size_t FindNextOp(CodeBuffer const* code, std::size_t start) {
+  for (auto i = code->next(start); i != CodeBuffer::npos; i = code->next(i)) {
+    if (code->op(i) != OP_LABEL) {
+      return i;
     }
   }
 
-  return nullptr;
+  return CodeBuffer::npos;
 }
 
-#define isVarAccess(op) bool((op) & OP_LDST)
-#define isStore(op) (((op) & OP_TYPE) == OP_STORE)
 #define indexed(op) ((op) & OP_INDEX)
 #define toStack(op) ((op) & OP_STACK)
 
-// Returns true iff the given opcode reads from the accumulator.
-bool OpReadsAccum(ANOpCode const* node) {
-  // OP_LABEL is a pseudo-op, and doesn't use the accumulator.
-  if (node->op == OP_LABEL) {
-    return false;
-  }
-  // We don't care about the byte flag here.
-  uint8_t op = node->op & ~OP_BYTE;
-
-  // Operations are listed in opcode order, to make it easier to make sure
-  // none are missed.
-  switch (op) {
-    // All math/logic ops use the accumulator.
-    case op_bnot:
-    case op_add:
-    case op_sub:
-    case op_mul:
-    case op_div:
-    case op_mod:
-    case op_shr:
-    case op_shl:
-    case op_xor:
-    case op_and:
-    case op_or:
-    case op_neg:
-    case op_not:
-      return true;
-
-    // All comparison ops use the accumulator
-    case op_eq:
-    case op_ne:
-    case op_gt:
-    case op_ge:
-    case op_lt:
-    case op_le:
-    case op_ugt:
-    case op_uge:
-    case op_ult:
-    case op_ule:
-      return true;
-
-    // We can't tell about branch instructions, but depending on when/how they
-    // branch, and what comes after. To be safe, assume that all branches use
-    // the accumulator.
-    case op_bt:
-    case op_bnt:
-    case op_jmp:
-      return true;
-
-    case op_loadi:
-      return false;
-
-    case op_push:
-      return true;
-
-    case op_pushi:
-    case op_toss:
-    case op_dup:
-    case op_link:
-      return false;
-
-    case op_call:
-      return true;
-
-    // The non-local calls all use op parameters to choose which procedure to
-    // call.
-    case op_callk:
-    case op_callb:
-    case op_calle:
-      return false;
-
-    case op_ret:
-    case op_send:
-      return true;
-
-    case op_class:
-      return false;
-
-    // self and super are like send, but take the object from the environment.
-    // They do not read the accumulator.
-    case op_self:
-    case op_super:
-      return false;
-
-    case op_rest:
-      return false;
-
-    case op_lea: {
-      // LEA is a bit trickier, as we have to look at the parameters to the
-      // instruction to see if it's indexed, and thus reads the accumulator.
-      auto* lea_node = down_cast<ANEffctAddr const>(node);
-      return (lea_node->eaType & OP_INDEX) != 0;
-    }
-
-    case op_selfID:
-    case op_pprev:
-      return false;
-
-    // Only the store accum to property instruction uses the accumulator.
-    case op_pToa:
-      return false;
-
-    case op_aTop:
-      return true;
-
-    case op_pTos:
-    case op_sTop:
-    case op_ipToa:
-    case op_dpToa:
-    case op_ipTos:
-    case op_dpTos:
-      return false;
-
-    case op_lofsa:
-    case op_lofss:
-    case op_push0:
-    case op_push1:
-    case op_push2:
-    case op_pushSelf:
-      return true;
-
-    default: {
-      // This should be a variable access. Everything else should be an invalid
-      // opcode.
-      if (!isVarAccess(op)) {
-        throw new std::runtime_error("Invalid opcode");
-      }
-
-      // There are two ways for this opcode to use the accumulator: Either it's
-      // storing the accumulator to the variable, or it's indexing the variable
-      // offset with the accumulator.
-      return (isStore(op) && !toStack(op)) || indexed(op);
-    }
-  }
-}
-
-// Returns true iff the given opcode can modify the accumulator.
-bool OpCanModifyAccum(ANOpCode const* node) {
-  // OP_LABEL is a pseudo-op, and doesn't modify the accumulator.
-  if (node->op == OP_LABEL) {
-    return false;
-  }
-
-  // We don't care about the byte flag here.
-  uint8_t op = node->op & ~OP_BYTE;
-
-  // Operations are listed in opcode order, to make it easier to make sure
-  // none are missed.
-  switch (op) {
-    // All math/logic ops modify the accumulator.
-    case op_bnot:
-    case op_add:
-    case op_sub:
-    case op_mul:
-    case op_div:
-    case op_mod:
-    case op_shr:
-    case op_shl:
-    case op_xor:
-    case op_and:
-    case op_or:
-    case op_neg:
-    case op_not:
-      return true;
-
-    // All comparison ops modify the accumulator
-    case op_eq:
-    case op_ne:
-    case op_gt:
-    case op_ge:
-    case op_lt:
-    case op_le:
-    case op_ugt:
-    case op_uge:
-    case op_ult:
-    case op_ule:
-      return true;
-
-    // Branch instructions don't modify the accumulator
-    case op_bt:
-    case op_bnt:
-    case op_jmp:
-      return false;
-
-    case op_loadi:
-      return true;
-
-    case op_push:
-      return false;
-
-    case op_pushi:
-    case op_toss:
-    case op_dup:
-    case op_link:
-      return false;
-
-    // All calls modify the accumulator
-    case op_call:
-    case op_callk:
-    case op_callb:
-    case op_calle:
-      return true;
-
-    case op_ret:
-      return false;
-
-    case op_send:
-    case op_class:
-    case op_self:
-    case op_super:
-      return true;
-
-    case op_rest:
-      return false;
-
-    case op_lea:
-    case op_selfID:
-      return true;
-
-    case op_pprev:
-      return false;
-
-    // Only the store accum to property instruction uses the accumulator.
-    case op_pToa:
-      return true;
-
-    case op_aTop:
-    case op_pTos:
-    case op_sTop:
-      return false;
-
-    case op_ipToa:
-    case op_dpToa:
-      return true;
-
-    case op_ipTos:
-    case op_dpTos:
-      return false;
-
-    case op_lofsa:
-      return true;
-    case op_lofss:
-    case op_push0:
-    case op_push1:
-    case op_push2:
-    case op_pushSelf:
-      return false;
-
-    default: {
-      // This should be a variable access. Everything else should be an invalid
-      // opcode.
-      if (!isVarAccess(op)) {
-        throw new std::runtime_error("Invalid opcode");
-      }
-
-      // For this to modify the accumulator, it must be loading the variable
-      // to the accumulator (which is all types aside from store).
-      return !isStore(op) && !toStack(op);
-    }
-  }
-}
-
 // Returns true iff the given opcode can change the control flow of a sequence
 // of opcodes.
-bool OpChangesControlFlow(ANOpCode const* node) {
-  if (node->op == OP_LABEL) {
+bool OpChangesControlFlow(CodeBuffer const* code, std::size_t i) {
+  if (code->op(i) == OP_LABEL) {
     return false;
   }
   // We don't care about the byte flag here.
-  uint8_t op = node->op & ~OP_BYTE;
+  uint8_t op = code->op(i) & ~OP_BYTE;
 
   // This is simpler than the other functions. Only the branch instructions
   // and return change control flow.
@@ -332,37 +65,6 @@ bool OpChangesControlFlow(ANOpCode const* node) {
   }
 }
 
-// Returns if the instruction modifies the accumulator without reading it.
-//
-// This is useful to see if the accumulator value is important to later
-// operations.
-bool OpClobbersAccum(ANOpCode const* node) {
-  return !OpReadsAccum(node) && OpCanModifyAccum(node);
-}
-
-// Returns true if the current value of the accumulator does not matter.
-bool ExecutionClobbersAccum(TList<ANOpCode>::const_iterator it) {
-  // This does a linear search through the opcode list, so could potentially
-  // cause O(n^2) behavior. This should be fine for most cases, but we should
-  // be aware for future optimizations.
-  while (it) {
-    if (OpReadsAccum(it.get())) {
-      // The accumulator is used.
-      return false;
-    }
-    if (OpCanModifyAccum(it.get())) {
-      // The accumulator is overwritten.
-      return true;
-    }
-    // The accumulator hasn't been changed by the instruction. Check the next
-    // one.
-    ++it;
-  }
-
-  throw std::runtime_error(
-      "Got to end of opcode list without finding a branch or return.");
-}
-
 enum {
   UNKNOWN = 0x4000,
   IMMEDIATE,
@@ -371,16 +73,44 @@ enum {
   SELF,
 };
 
-uint32_t OptimizeProc(AOpList* al) {
+uint32_t OptimizeProc(CodeBuffer* code) {
   uint32_t accType = UNKNOWN;
   int accVal = 0;
   int stackVal = 0;
   uint32_t stackType = UNKNOWN;
   uint32_t nOptimizations = 0;
 
-  for (auto it = al->iter(); it; ++it) {
-    bool byteOp = it->op & OP_BYTE;
-    uint32_t op = it->op & ~OP_BYTE;
+  // Removing the current instruction ends the pass; OptimizeHunk() runs
+  // another one for as long as anything changes.
+  bool passDone = false;
+
+  auto opAt = [code](std::size_t i) -> uint32_t {
+    return i == CodeBuffer::npos ? UINT32_MAX : code->op(i);
+  };
+
+  // Computed when first needed. Rewrites that add a read of the accumulator
+  // or drop a write to it reset the liveness, as they can make it live
+  // further up.
+  std::optional<ControlFlowGraph> cfg;
+  std::optional<Liveness> liveness;
+  auto flowGraph = [&]() -> ControlFlowGraph const& {
+    if (!cfg) {
+      cfg = ControlFlowGraph::Build(code);
+    }
+    return *cfg;
+  };
+  auto accumLiveAfter = [&](std::size_t i) {
+    if (!liveness) {
+      liveness = Liveness::Compute(code, flowGraph());
+    }
+    return liveness->LiveAfter(i, Liveness::kAccum);
+  };
+
+  // next(npos) is the first instruction in the buffer.
+  for (auto i = code->next(CodeBuffer::npos);
+       !passDone && i != CodeBuffer::npos; i = code->next(i)) {
+    bool byteOp = code->op(i) & OP_BYTE;
+    uint32_t op = code->op(i) & ~OP_BYTE;
 
     switch (op) {
       case op_bnot:
@@ -419,11 +149,18 @@ uint32_t OptimizeProc(AOpList* al) {
       case op_self:
       case op_super:
       case op_lea:
-      case OP_LABEL:
       case op_lofss:
         accType = stackType = UNKNOWN;
         break;
 
+      case OP_LABEL:
+        // What we know about the registers only carries into a block that
+        // can't be reached from anywhere else.
+        if (!flowGraph().OnlyEnteredFromPrevious(flowGraph().BlockOf(i))) {
+          accType = stackType = UNKNOWN;
+        }
+        break;
+
       case op_link:
       case op_toss:
         stackType = UNKNOWN;
@@ -454,28 +191,29 @@ uint32_t OptimizeProc(AOpList* al) {
         break;
 
       case op_pushi: {
-        int val = down_cast<ANOpSign>(it.get())->value;
+        int val = code->value(i);
         if (val == 0) {
-          it.replaceWith(std::make_unique<ANOpCode>(op_push0));
+          code->replaceWithOp(i, op_push0);
           ++nOptimizations;
 
         } else if (val == 1) {
-          it.replaceWith(std::make_unique<ANOpCode>(op_push1));
+          code->replaceWithOp(i, op_push1);
           ++nOptimizations;
 
         } else if (val == 2) {
-          it.replaceWith(std::make_unique<ANOpCode>(op_push2));
+          code->replaceWithOp(i, op_push2);
           ++nOptimizations;
 
         } else if (accType == IMMEDIATE && accVal == val) {
           // If accumulator already contains this value,
           // just push it.
-          it.replaceWith(std::make_unique<ANOpCode>(op_push));
+          code->replaceWithOp(i, op_push);
+          liveness.reset();
           ++nOptimizations;
 
         } else if (stackType == IMMEDIATE && stackVal == val) {
           // If stack already contains this value, dup it.
-          it.replaceWith(std::make_unique<ANOpCode>(op_dup));
+          code->replaceWithOp(i, op_dup);
           ++nOptimizations;
         }
 
@@ -486,68 +224,42 @@ uint32_t OptimizeProc(AOpList* al) {
 
       case op_ret: {
         // Optimize out double returns.
-        auto nextOp = it.next();
-        if (nextOp && nextOp->op == op_ret) {
-          nextOp.remove();
+        auto nextOp = code->next(i);
+        if (opAt(nextOp) == op_ret) {
+          code->remove(nextOp);
           ++nOptimizations;
         }
         break;
       }
 
       case op_loadi: {
-        auto* an = down_cast<ANOpSign>(it.get());
-        auto nextOp = it.next();
-        if (nextOp->op == op_push) {
+        auto nextOp = code->next(i);
+        if (opAt(nextOp) == op_push) {
           // Replace a load immediate followed by a push with
           // a push immediate.
-          nextOp.remove();
+          code->remove(nextOp);
           accType = UNKNOWN;
           stackType = IMMEDIATE;
-          stackVal = an->value;
+          stackVal = code->value(i);
           op = byteOp ? op_pushi | OP_BYTE : op_pushi;
-          it.replaceWith(std::make_unique<ANOpSign>(op, stackVal));
+          code->setOp(i, op);
+          liveness.reset();
           ++nOptimizations;
-        } else if (accType == IMMEDIATE && accVal == an->value) {
+        } else if (accType == IMMEDIATE && accVal == code->value(i)) {
           // If acc already has this value, delete
           // this node.
-          it.remove();
+          code->remove(i);
+          passDone = true;
           ++nOptimizations;
 
         } else {
           accType = IMMEDIATE;
-          accVal = an->value;
+          accVal = code->value(i);
         }
 
         break;
       }
 
-      case op_bt:
-      case op_bnt:
-      case op_jmp: {
-        // Eliminate branches to branches.
-        ANLabel const* label = ((ANBranch*)it.get())->target;
-        while (label) {
-          // 'label' points to the label to which we are branching.  Search
-          // for the first op-code following this label.
-          ANBranch* tmp = (ANBranch*)FindNextOp(al, label);
-
-          // If the first op-code following the label is not a jump or
-          // a branch of the same sense, no more optimization is possible.
-          uint32_t opType = tmp->op & ~OP_BYTE;
-          if (opType != op_jmp && opType != (it->op & ~OP_BYTE)) break;
-
-          // We're pointing to another jump.  Make its label ou
-          // destination and keep trying to optimize.
-          if (tmp->target == label)
-            label = 0;
-          else {
-            ((ANBranch*)it.get())->target = label = tmp->target;
-            ++nOptimizations;
-          }
-        }
-        break;
-      }
-
       case op_ipToa:
       case op_dpToa:
         accType = accVal = UNKNOWN;
@@ -559,19 +271,22 @@ uint32_t OptimizeProc(AOpList* al) {
         break;
 
       case op_pToa: {
-        auto* an = down_cast<ANOpSign>(it.get());
-        auto nextOp = it.next();
-        if (nextOp->op == op_push) {
-          nextOp.remove();
-          op = an->op = byteOp ? op_pTos | OP_BYTE : op_pTos;
+        auto nextOp = code->next(i);
+        if (opAt(nextOp) == op_push) {
+          code->remove(nextOp);
+          op = byteOp ? op_pTos | OP_BYTE : op_pTos;
+          code->setOp(i, op);
+          liveness.reset();
           ++nOptimizations;
           stackType = accType;
           stackVal = accVal;
           accType = UNKNOWN;
           if (indexed(op)) stackType = UNKNOWN;
 
-        } else if (accType == PROP && accVal == an->value && !indexed(op)) {
-          it.remove();
+        } else if (accType == PROP && accVal == code->value(i) &&
+                   !indexed(op)) {
+          code->remove(i);
+          passDone = true;
           ++nOptimizations;
 
         } else if (indexed(op))
@@ -579,53 +294,49 @@ uint32_t OptimizeProc(AOpList* al) {
 
         else {
           accType = PROP;
-          accVal = an->value;
+          accVal = code->value(i);
         }
         break;
       }
 
       case op_pTos: {
-        auto* an = down_cast<ANOpSign>(it.get());
         if (indexed(op)) {
           stackType = stackVal = UNKNOWN;
 
-        } else if (accType == PROP && an->value == accVal) {
+        } else if (accType == PROP && code->value(i) == accVal) {
           // Replace a load to the stack with the acc's current
           // value by a push.
-          it.replaceWith(std::make_unique<ANOpCode>(op_push));
+          code->replaceWithOp(i, op_push);
+          liveness.reset();
           ++nOptimizations;
 
-        } else if (stackType == PROP && an->value == stackVal) {
+        } else if (stackType == PROP && code->value(i) == stackVal) {
           // Replace a load to the stack of its current value
           // with a dup.
-          it.replaceWith(std::make_unique<ANOpCode>(op_dup));
+          code->replaceWithOp(i, op_dup);
           ++nOptimizations;
 
         } else {
           // Update the stack's value.
           stackType = op & OP_VAR;
-          stackVal = an->value;
+          stackVal = code->value(i);
         }
         break;
       }
 
       case op_selfID: {
-        auto nextOp = it.next();
-        if (nextOp->op == op_push) {
-          nextOp.remove();
-          it->op = op_pushSelf;
+        auto nextOp = code->next(i);
+        if (opAt(nextOp) == op_push) {
+          code->remove(nextOp);
+          code->setOp(i, op_pushSelf);
+          liveness.reset();
           stackType = SELF;
           ++nOptimizations;
 
         } else {
-          auto nextOpIt = it.next();
-          if (nextOpIt->op == op_send) {
-            ANSend* nextOp = static_cast<ANSend*>(nextOpIt.get());
-            it.replaceWith(
-                std::make_unique<ANSend>(nextOp->sci_target, op_self));
-            ANSend* an = static_cast<ANSend*>(it.get());
-            an->numArgs = nextOp->numArgs;
-            nextOpIt.remove();
+          if (opAt(nextOp) == op_send) {
+            code->replaceWithSend(i, op_self, code->numArgs(nextOp));
+            code->remove(nextOp);
             ++nOptimizations;
             stackType = accType = UNKNOWN;
 
@@ -638,21 +349,22 @@ uint32_t OptimizeProc(AOpList* al) {
       default: {
         if (!(op & OP_LDST)) break;
 
-        auto* an = down_cast<ANVarAccess>(it.get());
+        int32_t addr = code->value(i);
 
         // We can only optimize loads -- others just set the value of the
         // accumulator.
         if ((op & OP_TYPE) == OP_STORE) {
           // The main kind of optimization we can do here is to alter this
           // instruction depending on the previous one.
-          auto prevOp = it.prev();
+          auto prevOp = code->prev(i);
 
-          if (prevOp->op == op_push && toStack(op) && !indexed(op)) {
+          if (opAt(prevOp) == op_push && toStack(op) && !indexed(op)) {
             // We pushing a value from the accumulator, then storing it
             // from the stack, without using the accumulator. Remove the
             // push, and change this to a store from the stack.
-            prevOp.remove();
-            op = an->op = an->op & ~OP_STACK;
+            code->remove(prevOp);
+            op = code->op(i) & ~OP_STACK;
+            code->setOp(i, op);
             // We no longer know the state of the stack from before.
             stackType = stackVal = UNKNOWN;
             ++nOptimizations;
@@ -671,16 +383,17 @@ uint32_t OptimizeProc(AOpList* al) {
             accType = stackType = UNKNOWN;
           else {
             accType = op & OP_VAR;
-            accVal = an->addr;
+            accVal = addr;
           }
           break;
         }
 
         if (!toStack(op) && !indexed(op) && (op & OP_VAR) == accType &&
-            SafeEq(an->addr, accVal)) {
+            SafeEq(addr, accVal)) {
           // Then this just loads the acc with its present value.
           // Remove the node.
-          it.remove();
+          code->remove(i);
+          passDone = true;
           ++nOptimizations;
           break;
         }
@@ -691,17 +404,18 @@ uint32_t OptimizeProc(AOpList* al) {
           //
           // We have to be careful, because if later code depends on the
           // accumulator, this could be unsound. (Ask me how I know...)
-          auto nextOp = it.next();
+          auto nextOp = code->next(i);
 
-          if (!toStack(op) && nextOp->op == op_push &&
-              ExecutionClobbersAccum(nextOp.next())) {
-            nextOp.remove();
+          if (!toStack(op) && opAt(nextOp) == op_push &&
+              !accumLiveAfter(nextOp)) {
+            code->remove(nextOp);
             // Replace a load followed by a push with a load directly
             // to the stack.
             stackType = accType;
             stackVal = accVal;
             accType = UNKNOWN;
-            op = an->op |= OP_STACK;
+            op = code->op(i) | OP_STACK;
+            code->setOp(i, op);
             ++nOptimizations;
           }
         }
@@ -709,19 +423,20 @@ uint32_t OptimizeProc(AOpList* al) {
         if (!toStack(op)) {
           // Not a stack operation -- update accumulator's value.
           accType = op & OP_VAR;
-          accVal = an->addr;
-        } else if ((op & OP_VAR) == accType && SafeEq(an->addr, accVal)) {
+          accVal = addr;
+        } else if ((op & OP_VAR) == accType && SafeEq(addr, accVal)) {
           // Replace a load to the stack with the acc's current
           // value by a push.
-          it.replaceWith(std::make_unique<ANOpCode>(op_push));
+          code->replaceWithOp(i, op_push);
+          liveness.reset();
           stackType = accType;
           stackVal = accVal;
           ++nOptimizations;
 
-        } else if ((op & OP_VAR) == stackType && SafeEq(an->addr, stackVal)) {
+        } else if ((op & OP_VAR) == stackType && SafeEq(addr, stackVal)) {
           // Replace a load to the stack of its current value
           // with a dup.
-          it.replaceWith(std::make_unique<ANOpCode>(op_dup));
+          code->replaceWithOp(i, op_dup);
           ++nOptimizations;
 
         } else if (indexed(op)) {
@@ -730,13 +445,288 @@ uint32_t OptimizeProc(AOpList* al) {
         } else {
           // Update the stack's value.
           stackType = op & OP_VAR;
-          stackVal = an->addr;
+          stackVal = addr;
         }
         break;
       }
     }
   }
 
+  code->compact();
+  return nOptimizations;
+}
+
+// Returns true iff there is nothing but labels between instruction i and the
+// label, so that branching to it from i does nothing.
+bool FallsIntoLabel(CodeBuffer const* code, std::size_t i, uint32_t label) {
+  auto index = code->labelIndex(label);
+  if (index <= i) {
+    return false;
+  }
+
+  for (auto j = code->next(i); j != index; j = code->next(j)) {
+    if (code->op(j) != OP_LABEL) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the label that a branch with the given opcode to the label ends up
+// at, skipping over the jmps (and branches of the same sense) that it would
+// take from there. Returns the label itself if the chain loops back on
+// itself, so that the branch isn't moved around the loop forever.
+uint32_t FollowBranchChain(CodeBuffer const* code, uint32_t op,
+                           uint32_t label) {
+  std::vector<uint32_t> seen = {label};
+  auto dest = label;
+  while (true) {
+    auto i = FindNextOp(code, code->labelIndex(dest));
+    if (i == CodeBuffer::npos) {
+      return dest;
+    }
+
+    uint32_t nextOp = code->op(i) & ~OP_BYTE;
+    if ((nextOp != op_jmp && nextOp != op) ||
+        code->target(i) == CodeBuffer::kNone) {
+      return dest;
+    }
+
+    dest = code->target(i);
+    if (std::find(seen.begin(), seen.end(), dest) != seen.end()) {
+      return label;
+    }
+    seen.push_back(dest);
+  }
+}
+
+uint32_t ThreadJumps(CodeBuffer* code) {
+  uint32_t nOptimizations = 0;
+
+  for (auto i = code->next(CodeBuffer::npos); i != CodeBuffer::npos;
+       i = code->next(i)) {
+    uint32_t op = code->op(i) & ~OP_BYTE;
+    if ((op != op_bt && op != op_bnt && op != op_jmp) ||
+        code->target(i) == CodeBuffer::kNone) {
+      continue;
+    }
+
+    // Go straight to the end of a chain of branches.
+    auto dest = FollowBranchChain(code, op, code->target(i));
+    if (dest != code->target(i)) {
+      code->setBranchTarget(i, dest);
+      ++nOptimizations;
+    }
+
+    // A branch to the next instruction does nothing.
+    if (FallsIntoLabel(code, i, dest)) {
+      code->remove(i);
+      ++nOptimizations;
+      continue;
+    }
+
+    if (op == op_jmp) {
+      // Return directly, rather than jumping to a return.
+      auto destOp = FindNextOp(code, code->labelIndex(dest));
+      if (destOp != CodeBuffer::npos &&
+          (code->op(destOp) & ~OP_BYTE) == op_ret) {
+        code->replaceWithOp(i, op_ret);
+        ++nOptimizations;
+      }
+      continue;
+    }
+
+    // A conditional branch over a jmp is the opposite branch to where the jmp
+    // goes:
+    //
+    //   bnt .1            bt  .2
+    //   jmp .2      =>  .1
+    // .1
+    auto next = code->next(i);
+    if (next != CodeBuffer::npos && (code->op(next) & ~OP_BYTE) == op_jmp &&
+        code->target(next) != CodeBuffer::kNone &&
+        FallsIntoLabel(code, next, dest)) {
+      uint32_t inverse = op == op_bt ? op_bnt : op_bt;
+      code->setOp(i, inverse | (code->op(i) & OP_BYTE));
+      code->setBranchTarget(i, code->target(next));
+      code->remove(next);
+      ++nOptimizations;
+    }
+  }
+
+  code->compact();
+  return nOptimizations;
+}
+
+// How an instruction uses a temporary variable.
+enum class TempAccess {
+  NONE,
+  // Reads the temp (increments and decrements read it too).
+  USE,
+  // Overwrites the temp without reading it.
+  DEF,
+  // Takes the address of a temp, or indexes from one, so any temp may be
+  // read or written through it.
+  ESCAPE,
+};
+
+TempAccess ClassifyTempAccess(CodeBuffer const* code, std::size_t i) {
+  uint32_t op = code->op(i);
+  if (op == OP_LABEL) {
+    return TempAccess::NONE;
+  }
+
+  if ((op & ~OP_BYTE) == op_lea) {
+    return (code->extra(i) & OP_VAR) == OP_TMP ? TempAccess::ESCAPE
+                                                : TempAccess::NONE;
+  }
+
+  if (!(op & OP_LDST) || (op & OP_VAR) != OP_TMP) {
+    return TempAccess::NONE;
+  }
+  if (indexed(op)) {
+    return TempAccess::ESCAPE;
+  }
+  return (op & OP_TYPE) == OP_STORE ? TempAccess::DEF : TempAccess::USE;
+}
+
+// Removes stores to temps whose values are never read. Returns the number of
+// stores removed.
+uint32_t RemoveDeadTempStores(CodeBuffer* code) {
+  // Find the temps that are accessed. If any temp's address is taken, give
+  // up, as the stores may be read through it.
+  std::size_t numTemps = 0;
+  for (auto i = code->next(CodeBuffer::npos); i != CodeBuffer::npos;
+       i = code->next(i)) {
+    switch (ClassifyTempAccess(code, i)) {
+      case TempAccess::NONE:
+        break;
+
+      case TempAccess::ESCAPE:
+        return 0;
+
+      case TempAccess::USE:
+      case TempAccess::DEF:
+        numTemps = std::max(numTemps, std::size_t(code->value(i)) + 1);
+        break;
+    }
+  }
+  if (numTemps == 0) {
+    return 0;
+  }
+
+  // The frame, and its temps, go away at a ret. Leaving the code any other
+  // way is taken to need all of them.
+  auto cfg = ControlFlowGraph::Build(code);
+  auto liveAtEnd = [&](std::vector<std::vector<bool>> const& block_in,
+                       std::size_t b) {
+    auto const& block = cfg.block(b);
+    std::vector<bool> live(numTemps, block.exits);
+    for (auto succ : block.succs) {
+      for (std::size_t t = 0; t < numTemps; ++t) {
+        if (block_in[succ][t]) {
+          live[t] = true;
+        }
+      }
+    }
+    return live;
+  };
+
+  // Carries the live temps back through a block. If remove is set, removes
+  // the stores to temps that aren't live.
+  uint32_t nOptimizations = 0;
+  auto throughBlock = [&](std::size_t b, std::vector<bool> live,
+                          bool remove) {
+    auto const& block = cfg.block(b);
+    for (auto i = block.last; i != CodeBuffer::npos && i >= block.first;
+         i = code->prev(i)) {
+      auto temp = std::size_t(code->value(i));
+      switch (ClassifyTempAccess(code, i)) {
+        case TempAccess::USE:
+          live[temp] = true;
+          break;
+
+        case TempAccess::DEF:
+          if (remove && !live[temp]) {
+            if (toStack(code->op(i))) {
+              // The store still has to pop the value off the stack.
+              code->replaceWithOp(i, op_toss);
+            } else {
+              code->remove(i);
+            }
+            ++nOptimizations;
+          }
+          live[temp] = false;
+          break;
+
+        default:
+          break;
+      }
+    }
+    return live;
+  };
+
+  std::vector<std::vector<bool>> block_in(cfg.size(),
+                                          std::vector<bool>(numTemps));
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto b = cfg.size(); b-- > 0;) {
+      auto live = throughBlock(b, liveAtEnd(block_in, b), false);
+      if (live != block_in[b]) {
+        block_in[b] = std::move(live);
+        changed = true;
+      }
+    }
+  }
+
+  for (std::size_t b = 0; b < cfg.size(); ++b) {
+    throughBlock(b, liveAtEnd(block_in, b), true);
+  }
+  return nOptimizations;
+}
+
+uint32_t RemoveDeadCode(CodeBuffer* code) {
+  uint32_t nOptimizations = 0;
+
+  // Only the start of the code can be entered from outside, so anything that
+  // can't be reached from it is dead. The labels stay, in case a dead branch
+  // still refers to them.
+  auto cfg = ControlFlowGraph::Build(code);
+  std::vector<bool> reachable(cfg.size());
+  std::vector<std::size_t> work;
+  if (cfg.size() > 0) {
+    reachable[0] = true;
+    work.push_back(0);
+  }
+  while (!work.empty()) {
+    auto b = work.back();
+    work.pop_back();
+    for (auto succ : cfg.block(b).succs) {
+      if (!reachable[succ]) {
+        reachable[succ] = true;
+        work.push_back(succ);
+      }
+    }
+  }
+
+  for (std::size_t b = 0; b < cfg.size(); ++b) {
+    if (reachable[b]) {
+      continue;
+    }
+    auto const& block = cfg.block(b);
+    for (auto i = block.first; i != CodeBuffer::npos && i <= block.last;
+         i = code->next(i)) {
+      if (code->op(i) != OP_LABEL) {
+        code->remove(i);
+        ++nOptimizations;
+      }
+    }
+  }
+
+  nOptimizations += RemoveDeadTempStores(code);
+
+  code->compact();
   return nOptimizations;
 }
 
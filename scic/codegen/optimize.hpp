@@ -5,11 +5,22 @@
 
 #include <cstdint>
 
-#include "scic/codegen/alist.hpp"
+#include "scic/codegen/code_buffer.hpp"
 
 namespace codegen {
 
-uint32_t OptimizeProc(AOpList* al);
+uint32_t OptimizeProc(CodeBuffer* code);
+
+// Shortens the paths that branches take: branches to branches go straight to
+// the final target, a conditional branch over a jmp becomes the opposite
+// branch, a jmp to a ret becomes a ret, and branches to the next instruction
+// are removed. Returns the number of changes.
+uint32_t ThreadJumps(CodeBuffer* code);
+
+// Removes the code that can't be reached from the start of the block, and
+// stores to temporary variables that are never read again. Returns the number
+// of instructions removed.
+uint32_t RemoveDeadCode(CodeBuffer* code);
 
 }  // namespace codegen
 
@@ -0,0 +1,166 @@
+#include "scic/codegen/optimize.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/code_buffer.hpp"
+#include "scic/codegen/name_table.hpp"
+#include "scic/codegen/opcodes.hpp"
+#include "scic/codegen/target.hpp"
+
+namespace codegen {
+namespace {
+
+// sat, sst and lat: store the accumulator or the top of the stack to a
+// temporary variable, or load one into the accumulator.
+constexpr auto kStoreTmp = OP_LDST | OP_STORE | OP_TMP | OP_BYTE;
+constexpr auto kStoreTmpFromStack = kStoreTmp | OP_STACK;
+constexpr auto kLoadTmp = OP_LDST | OP_LOAD | OP_TMP | OP_BYTE;
+
+std::vector<std::uint32_t> Ops(CodeBuffer const& code) {
+  std::vector<std::uint32_t> ops;
+  for (auto i = code.next(CodeBuffer::npos); i != CodeBuffer::npos;
+       i = code.next(i)) {
+    ops.push_back(code.op(i));
+  }
+  return ops;
+}
+
+TEST(ThreadJumpsTest, CollapsesBranchChains) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto bt = code.addBranch(op_bt);
+  code.addOp(op_push0);
+  code.setBranchTarget(bt, code.addLabel());
+  auto first = code.addBranch(op_bt);
+  code.addOp(op_push1);
+  code.setBranchTarget(first, code.addLabel());
+  auto second = code.addBranch(op_jmp);
+  code.addOp(op_push2);
+  auto end = code.addLabel();
+  code.setBranchTarget(second, end);
+  code.addOp(op_toss);
+
+  EXPECT_NE(ThreadJumps(&code), 0);
+  EXPECT_EQ(code.target(code.next(CodeBuffer::npos)), end);
+}
+
+TEST(ThreadJumpsTest, LeavesLoopsOfJumpsAlone) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto entry = code.addBranch(op_jmp);
+  code.addOp(op_push0);
+  auto first = code.addLabel();
+  auto to_second = code.addBranch(op_jmp);
+  code.addOp(op_push1);
+  auto second = code.addLabel();
+  auto to_first = code.addBranch(op_jmp);
+  code.addOp(op_ret);
+  code.setBranchTarget(entry, first);
+  code.setBranchTarget(to_second, second);
+  code.setBranchTarget(to_first, first);
+
+  EXPECT_EQ(ThreadJumps(&code), 0);
+  EXPECT_EQ(code.target(entry), first);
+}
+
+TEST(ThreadJumpsTest, InvertsBranchesOverJumps) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto bnt = code.addBranch(op_bnt);
+  auto jmp = code.addBranch(op_jmp);
+  auto skip = code.addLabel();
+  code.addOp(op_push0);
+  auto end = code.addLabel();
+  code.addOp(op_toss);
+  code.setBranchTarget(bnt, skip);
+  code.setBranchTarget(jmp, end);
+
+  EXPECT_EQ(ThreadJumps(&code), 1);
+  EXPECT_EQ(Ops(code), (std::vector<std::uint32_t>{op_bt, OP_LABEL, op_push0,
+                                                   OP_LABEL, op_toss}));
+  EXPECT_EQ(code.target(0), end);
+}
+
+TEST(ThreadJumpsTest, ReturnsInsteadOfJumpingToReturn) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto jmp = code.addBranch(op_jmp);
+  code.addOp(op_push0);
+  code.setBranchTarget(jmp, code.addLabel());
+  code.addOp(op_ret);
+
+  EXPECT_EQ(ThreadJumps(&code), 1);
+  EXPECT_EQ(Ops(code),
+            (std::vector<std::uint32_t>{op_ret, op_push0, OP_LABEL, op_ret}));
+}
+
+TEST(ThreadJumpsTest, RemovesBranchesToTheNextInstruction) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto bt = code.addBranch(op_bt);
+  code.setBranchTarget(bt, code.addLabel());
+  code.addOp(op_toss);
+
+  EXPECT_EQ(ThreadJumps(&code), 1);
+  EXPECT_EQ(Ops(code), (std::vector<std::uint32_t>{OP_LABEL, op_toss}));
+}
+
+TEST(RemoveDeadCodeTest, RemovesUnreachableCode) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto bt = code.addBranch(op_bt);
+  code.addOp(op_ret);
+  code.addOp(op_push0);
+  auto loop = code.addLabel();
+  code.addOp(op_push1);
+  code.setBranchTarget(code.addBranch(op_jmp), loop);
+  auto taken = code.addLabel();
+  code.setBranchTarget(bt, taken);
+  code.addOp(op_ret);
+
+  EXPECT_EQ(RemoveDeadCode(&code), 3);
+  EXPECT_EQ(Ops(code), (std::vector<std::uint32_t>{op_bt, op_ret, OP_LABEL,
+                                                   OP_LABEL, op_ret}));
+}
+
+TEST(RemoveDeadCodeTest, RemovesStoresToDeadTemps) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  code.addVarAccess(kStoreTmp, 0, "a");
+  code.addVarAccess(kStoreTmp, 1, "b");
+  code.addOp(op_push0);
+  code.addVarAccess(kStoreTmpFromStack, 0, "a");
+  code.addVarAccess(kLoadTmp, 1, "b");
+  code.addOp(op_ret);
+
+  EXPECT_EQ(RemoveDeadCode(&code), 2);
+  EXPECT_EQ(Ops(code), (std::vector<std::uint32_t>{kStoreTmp, op_push0,
+                                                   op_toss, kLoadTmp, op_ret}));
+}
+
+TEST(RemoveDeadCodeTest, KeepsStoresReadAroundLoops) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  auto top = code.addLabel();
+  code.addVarAccess(kLoadTmp, 0, "i");
+  code.addVarAccess(kStoreTmp, 0, "i");
+  code.setBranchTarget(code.addBranch(op_bt), top);
+  code.addOp(op_ret);
+
+  EXPECT_EQ(RemoveDeadCode(&code), 0);
+}
+
+TEST(RemoveDeadCodeTest, KeepsStoresToAddressTakenTemps) {
+  NameTable names;
+  CodeBuffer code(SciTargetStrategy::GetSci11(), &names);
+  code.addVarAccess(kStoreTmp, 0, "a");
+  code.addEffctAddr(0, OP_TMP, "a");
+  code.addOp(op_ret);
+
+  EXPECT_EQ(RemoveDeadCode(&code), 0);
+}
+
+}  // namespace
+}  // namespace codegen
@@ -0,0 +1,366 @@
+#include "scic/frontend/build_state.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "scic/codegen/code_generator.hpp"
+#include "scic/frontend/flags.hpp"
+#include "scic/sem/module_env.hpp"
+#include "scic/sem/module_summary.hpp"
+#include "scic/status/status.hpp"
+#include "util/hash/sha256.hpp"
+#include "util/status/status_macros.hpp"
+#include "util/strings/ref_str.hpp"
+
+namespace frontend {
+namespace {
+
+// The first line of the manifest. Bump the version whenever the format, or
+// anything that affects the generated code without showing up in the
+// manifest, changes.
+constexpr std::string_view kManifestHeader = "scic-manifest 1";
+
+// Splits a manifest line into its keyword and the rest of the line.
+std::pair<std::string_view, std::string_view> SplitLine(
+    std::string_view line) {
+  auto pos = line.find(' ');
+  if (pos == std::string_view::npos) {
+    return {line, ""};
+  }
+  return {line.substr(0, pos), line.substr(pos + 1)};
+}
+
+std::string LiteralValueToString(codegen::LiteralValue const& value) {
+  return value.visit([](int num) { return absl::StrFormat("%d", num); },
+                     [](codegen::TextRef const&) { return std::string("@"); });
+}
+
+}  // namespace
+
+status::StatusOr<BuildManifest> BuildManifest::Load(
+    std::filesystem::path const& path) {
+  BuildManifest manifest;
+  std::ifstream file;
+  file.open(path, std::ios::in);
+  if (!file.good()) {
+    return manifest;
+  }
+
+  auto corrupt = [&](std::string_view line) {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Corrupt build manifest %s: %s", path, line));
+  };
+
+  std::string line;
+  if (!std::getline(file, line) || line != kManifestHeader) {
+    // An older or unknown manifest. Treat everything as out of date.
+    return manifest;
+  }
+
+  ModuleBuildState* curr_module = nullptr;
+  while (std::getline(file, line)) {
+    auto [keyword, rest] = SplitLine(line);
+    if (keyword == "config") {
+      manifest.config_hash = std::string(rest);
+    } else if (keyword == "module") {
+      curr_module = &manifest.modules[std::string(rest)];
+    } else if (!curr_module) {
+      return corrupt(line);
+    } else if (keyword == "script") {
+      curr_module->script_num = std::stoul(std::string(rest));
+    } else if (keyword == "source") {
+      curr_module->source_hash = std::string(rest);
+    } else if (keyword == "include") {
+      auto [hash, include_path] = SplitLine(rest);
+      curr_module->include_hashes.emplace(std::string(include_path),
+                                          std::string(hash));
+    } else if (keyword == "ident") {
+      curr_module->identifiers.emplace(rest);
+    } else if (keyword == "interface") {
+      curr_module->interface_hash = std::string(rest);
+    } else {
+      return corrupt(line);
+    }
+  }
+
+  return manifest;
+}
+
+status::Status BuildManifest::Save(std::filesystem::path const& path) const {
+  // Write to a temporary file first, so an interrupted build never leaves a
+  // truncated manifest behind.
+  auto temp_path = path;
+  temp_path += ".tmp";
+  {
+    std::ofstream file;
+    file.open(temp_path, std::ios::out | std::ios::trunc);
+    if (!file.good()) {
+      return status::FailedPreconditionError(
+          absl::StrFormat("Could not open file: %s", temp_path));
+    }
+
+    file << kManifestHeader << "\n";
+    file << "config " << config_hash << "\n";
+    for (auto const& [source_file, module] : modules) {
+      file << "module " << source_file << "\n";
+      file << "script " << module.script_num << "\n";
+      file << "source " << module.source_hash << "\n";
+      for (auto const& [include_path, hash] : module.include_hashes) {
+        file << "include " << hash << " " << include_path << "\n";
+      }
+      for (auto const& ident : module.identifiers) {
+        file << "ident " << ident << "\n";
+      }
+      file << "interface " << module.interface_hash << "\n";
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    return status::FailedPreconditionError(absl::StrFormat(
+        "Could not write manifest %s: %s", path, error.message()));
+  }
+  return status::OkStatus();
+}
+
+status::StatusOr<std::string> HashFile(std::filesystem::path const& path) {
+  std::ifstream file;
+  file.open(path, std::ios::in | std::ios::binary);
+  if (!file.good()) {
+    return status::NotFoundError(
+        absl::StrFormat("Could not open file: %s", path));
+  }
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return util::Sha256Hex(buffer.str());
+}
+
+status::StatusOr<sem::ModuleSummary> LoadModuleSummary(
+    std::filesystem::path const& path) {
+  std::ifstream file;
+  file.open(path, std::ios::in | std::ios::binary);
+  if (!file.good()) {
+    return status::NotFoundError(
+        absl::StrFormat("Could not open file: %s", path));
+  }
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+
+  return sem::ModuleSummary::Deserialize(buffer.str(),
+                                         util::RefStr(path.string()));
+}
+
+status::Status WriteModuleSummary(std::filesystem::path const& root_path,
+                                  sem::ModuleSummary const& summary) {
+  auto path = root_path / absl::StrFormat("%d.sum", summary.script_num.value());
+  std::ofstream file;
+  file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file.good()) {
+    return status::FailedPreconditionError(
+        absl::StrFormat("Could not open file: %s", path));
+  }
+
+  auto data = summary.Serialize();
+  file.write(data.data(), data.size());
+  return status::OkStatus();
+}
+
+status::StatusOr<std::string> HashBuildConfig(
+    CompilerFlags const& flags,
+    absl::Span<std::filesystem::path const> global_files) {
+  util::Sha256 hasher;
+  hasher.Update(absl::StrFormat("target %d\nopt %d\n",
+                                int(flags.codegen_options.target),
+                                int(flags.codegen_options.opt)));
+  for (auto const& [name, value] : flags.command_line_defines) {
+    hasher.Update(absl::StrFormat("define %s=%s\n", name, value));
+  }
+  for (auto const& include_path : flags.include_paths) {
+    hasher.Update(absl::StrFormat("include_path %s\n", include_path));
+  }
+  for (auto const& global_file : global_files) {
+    ASSIGN_OR_RETURN(auto hash, HashFile(global_file));
+    hasher.Update(absl::StrFormat("global %s %s\n", hash, global_file));
+  }
+  return std::move(hasher).FinishHex();
+}
+
+std::string HashGlobalInterface(sem::GlobalEnvironment const* global_env,
+                                std::set<std::string> const& names) {
+  util::Sha256 hasher;
+  for (auto const& name : names) {
+    if (auto const* selector =
+            global_env->selector_table()->LookupByName(name)) {
+      hasher.Update(absl::StrFormat("selector %s %d\n", name,
+                                    selector->selector_num().value()));
+    }
+
+    if (auto const* cls = global_env->class_table()->LookupByName(name)) {
+      hasher.Update(absl::StrFormat(
+          "class %s %d %d %d\n", name, cls->species().value(),
+          cls->super() ? int(cls->super()->species().value()) : -1,
+          cls->script_num().value()));
+      for (auto const& prop : cls->prop_list().properties()) {
+        hasher.Update(absl::StrFormat("  prop %d %s\n",
+                                      prop.selector()->selector_num().value(),
+                                      LiteralValueToString(prop.value())));
+      }
+      for (auto const& method : cls->methods()) {
+        hasher.Update(absl::StrFormat(
+            "  method %d\n", method.selector()->selector_num().value()));
+      }
+    }
+
+    if (auto const* ext = global_env->extern_table()->LookupByName(name)) {
+      hasher.Update(absl::StrFormat(
+          "extern %s %d %d\n", name,
+          ext->script_num() ? int(ext->script_num()->value()) : -1,
+          ext->index().value()));
+    }
+
+    if (auto const* var = global_env->global_table()->LookupByName(name)) {
+      hasher.Update(
+          absl::StrFormat("global %s %d\n", name, var->index().value()));
+    }
+  }
+  return std::move(hasher).FinishHex();
+}
+
+status::StatusOr<std::optional<std::string>> CheckModuleInputs(
+    BuildManifest const& manifest, std::string const& config_hash,
+    std::string const& source_file,
+    std::filesystem::path const& output_directory) {
+  if (manifest.config_hash != config_hash) {
+    return "build configuration changed";
+  }
+
+  auto it = manifest.modules.find(source_file);
+  if (it == manifest.modules.end()) {
+    return "no previous build";
+  }
+  auto const& module = it->second;
+
+  ASSIGN_OR_RETURN(auto source_hash, HashFile(source_file));
+  if (source_hash != module.source_hash) {
+    return "source changed";
+  }
+
+  for (auto const& [include_path, hash] : module.include_hashes) {
+    auto include_hash = HashFile(include_path);
+    if (!include_hash.ok() || include_hash.value() != hash) {
+      return absl::StrFormat("include %s changed", include_path);
+    }
+  }
+
+  for (auto const* extension : {"hep", "scr", "sl", "sum"}) {
+    auto output_path =
+        output_directory /
+        absl::StrFormat("%d.%s", module.script_num, extension);
+    if (!std::filesystem::exists(output_path)) {
+      return absl::StrFormat("output %s missing", output_path);
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::vector<bool> AssignShard(std::vector<std::string> const& files,
+                              std::size_t shard_index,
+                              std::size_t shard_count) {
+  std::vector<std::uintmax_t> sizes;
+  std::vector<std::size_t> order;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(files[i], error);
+    // A missing file is reported when its shard parses it.
+    sizes.push_back(error ? 0 : size);
+    order.push_back(i);
+  }
+  std::ranges::sort(order, [&](std::size_t a, std::size_t b) {
+    if (sizes[a] != sizes[b]) {
+      return sizes[a] > sizes[b];
+    }
+    return files[a] < files[b];
+  });
+
+  std::vector<std::uintmax_t> shard_sizes(shard_count, 0);
+  std::vector<bool> in_shard(files.size(), false);
+  for (auto i : order) {
+    auto smallest = std::ranges::min_element(shard_sizes) - shard_sizes.begin();
+    shard_sizes[smallest] += sizes[i];
+    in_shard[i] = std::size_t(smallest) == shard_index;
+  }
+  return in_shard;
+}
+
+status::StatusOr<RebuildPlan> PlanRebuild(
+    BuildManifest const& manifest, std::string const& config_hash,
+    std::vector<std::string> const& files,
+    std::filesystem::path const& output_directory) {
+  RebuildPlan plan;
+  for (auto const& file : files) {
+    ASSIGN_OR_RETURN(auto reason, CheckModuleInputs(manifest, config_hash,
+                                                    file, output_directory));
+    if (!reason) {
+      auto summary = LoadModuleSummary(
+          output_directory /
+          absl::StrFormat("%d.sum", manifest.modules.at(file).script_num));
+      if (summary.ok()) {
+        plan.clean_summaries.emplace(file, std::move(summary).value());
+        continue;
+      }
+      reason = "summary could not be loaded";
+    }
+    plan.dirty_files.push_back(file);
+    plan.rebuild_reasons.emplace(file, *reason);
+  }
+  return plan;
+}
+
+bool MarkStaleModules(BuildManifest const& manifest,
+                      sem::GlobalEnvironment const* global_env,
+                      std::vector<std::string> const& files,
+                      RebuildPlan* plan) {
+  bool marked = false;
+  for (auto it = plan->clean_summaries.begin();
+       it != plan->clean_summaries.end();) {
+    auto const& module_state = manifest.modules.at(it->first);
+    if (HashGlobalInterface(global_env, module_state.identifiers) ==
+        module_state.interface_hash) {
+      ++it;
+      continue;
+    }
+    plan->rebuild_reasons.emplace(it->first, "global interface changed");
+    it = plan->clean_summaries.erase(it);
+    marked = true;
+  }
+
+  if (marked) {
+    plan->dirty_files.clear();
+    for (auto const& file : files) {
+      if (plan->rebuild_reasons.contains(file)) {
+        plan->dirty_files.push_back(file);
+      }
+    }
+  }
+  return marked;
+}
+
+}  // namespace frontend
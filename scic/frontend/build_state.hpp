@@ -0,0 +1,121 @@
+#ifndef FRONTEND_BUILD_STATE_HPP
+#define FRONTEND_BUILD_STATE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "scic/frontend/flags.hpp"
+#include "scic/sem/module_env.hpp"
+#include "scic/sem/module_summary.hpp"
+#include "scic/status/status.hpp"
+
+namespace frontend {
+
+// The state of a single module as of the last time it was compiled.
+struct ModuleBuildState {
+  std::size_t script_num = 0;
+  std::string source_hash;
+  // The hash of every file included while preprocessing the module, by path.
+  std::map<std::string, std::string> include_hashes;
+  // Every identifier that appears in the preprocessed module. The part of the
+  // global environment a module depends on is the meaning of these names.
+  std::set<std::string> identifiers;
+  // The hash of the global environment, as seen through the identifiers.
+  std::string interface_hash;
+};
+
+// A record of the inputs of each module from previous builds, kept in the
+// output directory. It is used to decide which modules need to be recompiled.
+struct BuildManifest {
+  static constexpr std::string_view kFileName = "scic.manifest";
+
+  // Loads the manifest from the given path. If the file doesn't exist, an
+  // empty manifest is returned.
+  static status::StatusOr<BuildManifest> Load(
+      std::filesystem::path const& path);
+
+  status::Status Save(std::filesystem::path const& path) const;
+
+  // The hash of the options and global inputs shared by every module.
+  std::string config_hash;
+  // Keyed by the source file path, as given on the command line.
+  std::map<std::string, ModuleBuildState> modules;
+};
+
+status::StatusOr<std::string> HashFile(std::filesystem::path const& path);
+
+status::StatusOr<sem::ModuleSummary> LoadModuleSummary(
+    std::filesystem::path const& path);
+
+// Writes the summary to "<script>.sum" in the given directory.
+status::Status WriteModuleSummary(std::filesystem::path const& root_path,
+                                  sem::ModuleSummary const& summary);
+
+// Hashes the parts of the build configuration that affect every module: the
+// code generation options, command line defines, and the contents of the
+// global files (global includes and anything they include).
+status::StatusOr<std::string> HashBuildConfig(
+    CompilerFlags const& flags,
+    absl::Span<std::filesystem::path const> global_files);
+
+// Hashes what each of the given names refers to in the global environment:
+// selector numbers, class layouts, externs and global variables. Names that
+// aren't defined globally contribute nothing, so defining one later changes
+// the hash as well.
+std::string HashGlobalInterface(sem::GlobalEnvironment const* global_env,
+                                std::set<std::string> const& names);
+
+// Checks whether the source file's inputs have changed since the manifest
+// was written. Returns a description of why the module must be rebuilt, or
+// nullopt if its inputs are unchanged. This does not check the module's view
+// of the global environment, which requires the new environment to be built.
+status::StatusOr<std::optional<std::string>> CheckModuleInputs(
+    BuildManifest const& manifest, std::string const& config_hash,
+    std::string const& source_file,
+    std::filesystem::path const& output_directory);
+
+// Returns whether each file is in the given shard. Files are assigned
+// largest first, each to the shard with the least total size so far, so that
+// the shards get similar amounts of work. The assignment depends only on the
+// names and sizes of the files, so every process computes the same one.
+std::vector<bool> AssignShard(std::vector<std::string> const& files,
+                              std::size_t shard_index,
+                              std::size_t shard_count);
+
+// The modules of an incremental build, split into those that have to be
+// recompiled and those that are up to date.
+struct RebuildPlan {
+  // The modules to recompile, in command line order.
+  std::vector<std::string> dirty_files;
+  // Why each of the dirty modules has to be recompiled.
+  std::map<std::string, std::string> rebuild_reasons;
+  // The summaries of the up to date modules from the last build, keyed by
+  // source file.
+  std::map<std::string, sem::ModuleSummary> clean_summaries;
+};
+
+// Checks the inputs of each of the given source files, and loads the last
+// build's summary of each module whose inputs are unchanged.
+status::StatusOr<RebuildPlan> PlanRebuild(
+    BuildManifest const& manifest, std::string const& config_hash,
+    std::vector<std::string> const& files,
+    std::filesystem::path const& output_directory);
+
+// Marks the up to date modules whose view of the global environment has
+// changed as dirty, keeping the dirty modules in command line order. Returns
+// true if any module was marked.
+bool MarkStaleModules(BuildManifest const& manifest,
+                      sem::GlobalEnvironment const* global_env,
+                      std::vector<std::string> const& files,
+                      RebuildPlan* plan);
+
+}  // namespace frontend
+
+#endif
@@ -0,0 +1,464 @@
+#include "scic/frontend/build_state.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "scic/codegen/code_generator.hpp"
+#include "scic/codegen/output.hpp"
+#include "scic/codegen/text_sink.hpp"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/code_builder.hpp"
+#include "scic/sem/input.hpp"
+#include "scic/sem/item_index.hpp"
+#include "scic/sem/module_env.hpp"
+#include "scic/sem/module_summary.hpp"
+#include "scic/sem/test_helpers.hpp"
+#include "scic/status/status.hpp"
+#include "util/status/status_macros.hpp"
+#include "util/status/status_matchers.hpp"
+
+namespace frontend {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::EndsWith;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+using ::testing::StartsWith;
+using ::util::status::IsOkAndHolds;
+
+constexpr std::string_view kConfigHash = "config";
+
+// Collects the output in memory, in the same byte order as the compiler's
+// output files.
+class StringOutputWriter : public codegen::OutputWriter {
+ public:
+  void WriteByte(std::uint8_t c) override { data_.push_back(char(c)); }
+  void WriteOp(std::uint8_t op) override { WriteByte(op); }
+  void WriteWord(std::int16_t w) override {
+    std::uint16_t u = w;
+    WriteByte(u & 0xFF);
+    WriteByte(u >> 8);
+  }
+  void Write(const void* ptr, std::size_t size) override {
+    data_.append(static_cast<char const*>(ptr), size);
+  }
+  int WriteNullTerminatedString(std::string_view str) override {
+    Write(str.data(), str.size());
+    WriteByte(0);
+    return str.size() + 1;
+  }
+  int Write(std::string_view str) override {
+    WriteWord(str.size());
+    Write(str.data(), str.size());
+    return str.size() + 2;
+  }
+
+  std::string const& data() const { return data_; }
+
+ private:
+  std::string data_;
+};
+
+class StringOutputFiles : public codegen::OutputFiles {
+ public:
+  codegen::OutputWriter* GetHeap() override { return &heap_; }
+  codegen::OutputWriter* GetHunk() override { return &hunk_; }
+
+  // The heap and hunk contents, one after the other.
+  std::string contents() const { return heap_.data() + hunk_.data(); }
+
+ private:
+  StringOutputWriter heap_;
+  StringOutputWriter hunk_;
+};
+
+// The generated code for each script, by script number.
+using ScriptOutputs = std::map<std::size_t, std::string>;
+
+class BuildStateTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::path(::testing::TempDir()) /
+           ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+    global_items_ = sem::ParseItemsOrDie(R"(
+        (selectors
+            -objID- 4096
+            -size- 4097
+            -propDict- 4098
+            -methDict- 4099
+            -classScript- 4100
+            -script- 4101
+            -super- 4102
+            -info- 4103
+            name 20
+            init 21)
+    )");
+
+    // Three modules, given out of script order, where each class is a
+    // subclass of the one in the script before it.
+    AddModule("third.sc", R"(
+        (script# 3)
+        (class Third of Second
+            (properties
+                third 0)
+            (method (init) (return)))
+    )",
+              {"Second", "Third", "init", "third"});
+    AddModule("first.sc", R"(
+        (script# 1)
+        (class First
+            (properties
+                first 0)
+            (method (firstMethod) (return)))
+    )",
+              {"First", "first", "firstMethod"});
+    AddModule("second.sc", R"(
+        (script# 2)
+        (class Second of First
+            (properties
+                second 0)
+            (method (secondMethod) (return)))
+    )",
+              {"First", "Second", "second", "secondMethod"});
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  void WriteFile(std::filesystem::path const& path, std::string_view contents) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << contents;
+  }
+
+  // Adds a module, in command line order, and writes its source.
+  void AddModule(std::string_view name, std::string_view source,
+                 std::set<std::string> identifiers) {
+    auto path = (dir_ / name).string();
+    WriteFile(path, source);
+    files_.push_back(path);
+    identifiers_.emplace(path, std::move(identifiers));
+  }
+
+  std::vector<parsers::sci::Item> const& ParseModule(
+      std::string const& file) {
+    std::ifstream stream(file);
+    std::string source((std::istreambuf_iterator<char>(stream)),
+                       std::istreambuf_iterator<char>());
+    return module_items_.emplace_back(sem::ParseItemsOrDie(source));
+  }
+
+  // Builds the environment as an incremental build does, from the sources
+  // of the dirty modules and the summaries of the clean ones.
+  status::StatusOr<sem::CompilationEnvironment> BuildEnv(
+      RebuildPlan const& plan) {
+    sem::Input input;
+    input.global_items = global_items_;
+    for (auto const& file : plan.dirty_files) {
+      input.modules.push_back(
+          sem::Input::Module{.module_items = ParseModule(file)});
+    }
+    for (auto const& [file, summary] : plan.clean_summaries) {
+      input.module_summaries.push_back(summary);
+    }
+
+    return sem::BuildCompilationEnvironment(kCodegenOptions, input);
+  }
+
+  // Compiles one shard of the modules, as the compiler does: the modules in
+  // the shard are compiled, and the others are only summarized.
+  status::StatusOr<ScriptOutputs> BuildShard(std::size_t shard_index,
+                                             std::size_t shard_count) {
+    auto in_shard = AssignShard(files_, shard_index, shard_count);
+    sem::Input input;
+    input.global_items = global_items_;
+    for (std::size_t i = 0; i < files_.size(); ++i) {
+      auto const& items = ParseModule(files_[i]);
+      if (in_shard[i]) {
+        input.modules.push_back(sem::Input::Module{.module_items = items});
+      } else {
+        ASSIGN_OR_RETURN(auto summary, sem::ModuleSummary::Build(
+                                           sem::ItemIndex::Build(items)));
+        input.module_summaries.push_back(std::move(summary));
+      }
+    }
+
+    ASSIGN_OR_RETURN(auto env,
+                     sem::BuildCompilationEnvironment(kCodegenOptions, input));
+    ScriptOutputs outputs;
+    for (auto const* module : env.module_envs()) {
+      RETURN_IF_ERROR(sem::BuildCode(module));
+      StringOutputFiles output_files;
+      auto list_sink = codegen::TextSink::Null();
+      module->codegen()->Assemble("<unknown>", module->script_num().value(),
+                                  list_sink.get(), &output_files);
+      outputs.emplace(module->script_num().value(), output_files.contents());
+    }
+    return outputs;
+  }
+
+  // Records the dirty modules in the manifest and writes their outputs, as
+  // the compiler does once it has generated their code.
+  status::Status RecordBuild(RebuildPlan const& plan,
+                             sem::CompilationEnvironment const& env) {
+    manifest_.config_hash = kConfigHash;
+    for (auto const& file : plan.dirty_files) {
+      ASSIGN_OR_RETURN(auto summary,
+                       sem::ModuleSummary::Build(
+                           sem::ItemIndex::Build(ParseModule(file))));
+      RETURN_IF_ERROR(WriteModuleSummary(dir_, summary));
+      auto script_num = summary.script_num.value();
+      for (auto const* extension : {"hep", "scr", "sl"}) {
+        WriteFile(dir_ / absl::StrFormat("%d.%s", script_num, extension), "");
+      }
+
+      ASSIGN_OR_RETURN(auto source_hash, HashFile(file));
+      auto const& identifiers = identifiers_.at(file);
+      manifest_.modules[file] = ModuleBuildState{
+          .script_num = std::size_t(script_num),
+          .source_hash = std::move(source_hash),
+          .identifiers = identifiers,
+          .interface_hash = HashGlobalInterface(env.global_env(), identifiers),
+      };
+    }
+    return status::OkStatus();
+  }
+
+  // Runs an incremental build, and returns the modules that were rebuilt.
+  // The manifest is loaded before the build and saved after it, as the
+  // compiler does.
+  status::StatusOr<std::vector<std::string>> RunIncrementalBuild() {
+    ASSIGN_OR_RETURN(manifest_, BuildManifest::Load(ManifestPath()));
+    ASSIGN_OR_RETURN(auto plan, PlanRebuild(manifest_, std::string(kConfigHash),
+                                            files_, dir_));
+    ASSIGN_OR_RETURN(auto env, BuildEnv(plan));
+    if (MarkStaleModules(manifest_, env.global_env(), files_, &plan)) {
+      ASSIGN_OR_RETURN(env, BuildEnv(plan));
+      // Compiling the stale modules doesn't change the global environment,
+      // so no more modules go stale.
+      EXPECT_FALSE(
+          MarkStaleModules(manifest_, env.global_env(), files_, &plan));
+    }
+    RETURN_IF_ERROR(RecordBuild(plan, env));
+    RETURN_IF_ERROR(manifest_.Save(ManifestPath()));
+    return plan.dirty_files;
+  }
+
+  std::filesystem::path ManifestPath() const {
+    return dir_ / BuildManifest::kFileName;
+  }
+
+  // Checks the inputs of one of the modules against the last build.
+  status::StatusOr<std::optional<std::string>> CheckInputs(
+      std::string const& file,
+      std::string_view config_hash = kConfigHash) const {
+    return CheckModuleInputs(manifest_, std::string(config_hash), file, dir_);
+  }
+
+  static constexpr codegen::CodeGenerator::Options kCodegenOptions{
+      .target = codegen::SciTarget::SCI_2,
+      .opt = codegen::Optimization::OPTIMIZE,
+  };
+
+  std::filesystem::path dir_;
+  std::vector<parsers::sci::Item> global_items_;
+  // The items of every module parsed, which must outlive the environments
+  // built from them.
+  std::deque<std::vector<parsers::sci::Item>> module_items_;
+  std::vector<std::string> files_;
+  std::map<std::string, std::set<std::string>> identifiers_;
+  BuildManifest manifest_;
+};
+
+TEST_F(BuildStateTest, ManifestRoundTrips) {
+  BuildManifest manifest;
+  manifest.config_hash = "config";
+  manifest.modules["dir/first.sc"] = ModuleBuildState{
+      .script_num = 1,
+      .source_hash = "source1",
+      .include_hashes = {{"game.sh", "include1"}, {"dir/my file.sh", "inc2"}},
+      .identifiers = {"First", "init"},
+      .interface_hash = "interface1",
+  };
+  manifest.modules["second.sc"] = ModuleBuildState{
+      .script_num = 2,
+      .source_hash = "source2",
+      .interface_hash = "interface2",
+  };
+  ASSERT_OK(manifest.Save(ManifestPath()));
+
+  ASSERT_OK_AND_ASSIGN(auto loaded, BuildManifest::Load(ManifestPath()));
+  EXPECT_EQ(loaded.config_hash, manifest.config_hash);
+  ASSERT_EQ(loaded.modules.size(), manifest.modules.size());
+  for (auto const& [file, module] : manifest.modules) {
+    auto const& loaded_module = loaded.modules[file];
+    EXPECT_EQ(loaded_module.script_num, module.script_num) << file;
+    EXPECT_EQ(loaded_module.source_hash, module.source_hash) << file;
+    EXPECT_EQ(loaded_module.include_hashes, module.include_hashes) << file;
+    EXPECT_EQ(loaded_module.identifiers, module.identifiers) << file;
+    EXPECT_EQ(loaded_module.interface_hash, module.interface_hash) << file;
+  }
+}
+
+TEST_F(BuildStateTest, MissingOrOutdatedManifestIsEmpty) {
+  ASSERT_OK_AND_ASSIGN(auto missing, BuildManifest::Load(ManifestPath()));
+  EXPECT_THAT(missing.config_hash, IsEmpty());
+  EXPECT_THAT(missing.modules, IsEmpty());
+
+  WriteFile(ManifestPath(), "scic-manifest 0\nconfig config\n");
+  ASSERT_OK_AND_ASSIGN(auto outdated, BuildManifest::Load(ManifestPath()));
+  EXPECT_THAT(outdated.config_hash, IsEmpty());
+  EXPECT_THAT(outdated.modules, IsEmpty());
+}
+
+TEST_F(BuildStateTest, CorruptManifestIsAnError) {
+  WriteFile(ManifestPath(), "scic-manifest 1\nconfig config\nscript 1\n");
+  EXPECT_FALSE(BuildManifest::Load(ManifestPath()).ok());
+}
+
+TEST_F(BuildStateTest, UnchangedInputsNeedNoRebuild) {
+  ASSERT_OK(RunIncrementalBuild());
+  for (auto const& file : files_) {
+    EXPECT_THAT(CheckInputs(file), IsOkAndHolds(Eq(std::nullopt))) << file;
+  }
+}
+
+TEST_F(BuildStateTest, ModulesMissingFromTheManifestAreRebuilt) {
+  manifest_.config_hash = kConfigHash;
+  EXPECT_THAT(CheckInputs(files_[0]),
+              IsOkAndHolds(Optional(Eq("no previous build"))));
+}
+
+TEST_F(BuildStateTest, ChangedSourceIsRebuilt) {
+  ASSERT_OK(RunIncrementalBuild());
+
+  WriteFile(files_[0], "; A comment is still a change.\n");
+  EXPECT_THAT(CheckInputs(files_[0]),
+              IsOkAndHolds(Optional(Eq("source changed"))));
+  EXPECT_THAT(CheckInputs(files_[1]), IsOkAndHolds(Eq(std::nullopt)));
+}
+
+TEST_F(BuildStateTest, ChangedIncludeIsRebuilt) {
+  ASSERT_OK(RunIncrementalBuild());
+  auto include = (dir_ / "game.sh").string();
+  WriteFile(include, "(define MAX 10)\n");
+  ASSERT_OK_AND_ASSIGN(auto include_hash, HashFile(include));
+  manifest_.modules.at(files_[0]).include_hashes.emplace(include,
+                                                         include_hash);
+  EXPECT_THAT(CheckInputs(files_[0]), IsOkAndHolds(Eq(std::nullopt)));
+
+  auto changed = absl::StrFormat("include %s changed", include);
+  WriteFile(include, "(define MAX 20)\n");
+  EXPECT_THAT(CheckInputs(files_[0]), IsOkAndHolds(Optional(Eq(changed))));
+
+  // A deleted include counts as a change too.
+  std::filesystem::remove(include);
+  EXPECT_THAT(CheckInputs(files_[0]), IsOkAndHolds(Optional(Eq(changed))));
+}
+
+TEST_F(BuildStateTest, ChangedConfigRebuildsEverything) {
+  ASSERT_OK(RunIncrementalBuild());
+  for (auto const& file : files_) {
+    EXPECT_THAT(CheckInputs(file, "other config"),
+                IsOkAndHolds(Optional(Eq("build configuration changed"))))
+        << file;
+  }
+}
+
+TEST_F(BuildStateTest, MissingSummaryIsRebuilt) {
+  ASSERT_OK(RunIncrementalBuild());
+
+  // files_[1] is script 1.
+  std::filesystem::remove(dir_ / "1.sum");
+  EXPECT_THAT(CheckInputs(files_[1]),
+              IsOkAndHolds(Optional(AllOf(StartsWith("output "),
+                                          HasSubstr("1.sum"),
+                                          EndsWith(" missing")))));
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(ElementsAre(files_[1])));
+}
+
+TEST_F(BuildStateTest, CorruptSummaryIsRebuilt) {
+  ASSERT_OK(RunIncrementalBuild());
+
+  WriteFile(dir_ / "1.sum", "not a summary");
+  ASSERT_OK_AND_ASSIGN(
+      auto plan,
+      PlanRebuild(manifest_, std::string(kConfigHash), files_, dir_));
+  EXPECT_THAT(plan.dirty_files, ElementsAre(files_[1]));
+  EXPECT_EQ(plan.rebuild_reasons[files_[1]], "summary could not be loaded");
+}
+
+TEST_F(BuildStateTest, FirstBuildRebuildsEverything) {
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(files_));
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(BuildStateTest, EditingOneModuleRebuildsOnlyThatModule) {
+  ASSERT_OK(RunIncrementalBuild());
+
+  // A new method body doesn't affect any other module.
+  WriteFile(files_[2], R"(
+      (script# 2)
+      (class Second of First
+          (properties
+              second 0)
+          (method (secondMethod) (return 1)))
+  )");
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(ElementsAre(files_[2])));
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(BuildStateTest, StaleModulesAreRebuiltInCommandLineOrder) {
+  ASSERT_OK(RunIncrementalBuild());
+
+  // A new property changes the layout of every subclass.
+  WriteFile(files_[1], R"(
+      (script# 1)
+      (class First
+          (properties
+              first 0
+              extra 0)
+          (method (firstMethod) (return)))
+  )");
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(files_));
+  EXPECT_THAT(RunIncrementalBuild(), IsOkAndHolds(IsEmpty()));
+}
+
+TEST_F(BuildStateTest, ShardsGenerateTheSameCodeAsAnUnshardedBuild) {
+  ASSERT_OK_AND_ASSIGN(auto unsharded, BuildShard(0, 1));
+  ASSERT_EQ(unsharded.size(), files_.size());
+
+  for (std::size_t shard_count : {2, 3}) {
+    ScriptOutputs sharded;
+    for (std::size_t shard_index = 0; shard_index < shard_count;
+         ++shard_index) {
+      ASSERT_OK_AND_ASSIGN(auto outputs, BuildShard(shard_index, shard_count));
+      for (auto& [script_num, output] : outputs) {
+        // Each script is compiled by exactly one shard.
+        EXPECT_TRUE(sharded.emplace(script_num, std::move(output)).second);
+      }
+    }
+    EXPECT_EQ(sharded, unsharded) << shard_count << " shards";
+  }
+}
+
+}  // namespace
+}  // namespace frontend
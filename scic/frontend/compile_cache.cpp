@@ -0,0 +1,232 @@
+#include "scic/frontend/compile_cache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "scic/codegen/code_generator.hpp"
+#include "scic/status/status.hpp"
+#include "scic/tokens/token.hpp"
+#include "util/hash/sha256.hpp"
+
+namespace frontend {
+namespace {
+
+// Bump this whenever the compiler changes in a way that affects its output,
+// so that old entries are no longer used.
+constexpr std::string_view kCacheVersion = "scic-cache 2";
+
+constexpr std::string_view kOutputExtensions[] = {"hep", "scr", "sl"};
+
+std::filesystem::path OutputPath(std::filesystem::path const& directory,
+                                 std::size_t script_num,
+                                 std::string_view extension) {
+  return directory / absl::StrFormat("%d.%s", script_num, extension);
+}
+
+std::filesystem::path EntryFilePath(std::filesystem::path const& entry_path,
+                                    std::string_view extension) {
+  return entry_path / absl::StrFormat("script.%s", extension);
+}
+
+// Lists the hash of each output in an entry, so that a damaged entry is
+// noticed when it is fetched.
+constexpr std::string_view kHashesFileName = "hashes";
+
+std::optional<std::string> ReadFile(std::filesystem::path const& path) {
+  std::ifstream file;
+  file.open(path, std::ios::in | std::ios::binary);
+  if (!file.good()) {
+    return std::nullopt;
+  }
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  if (file.bad()) {
+    return std::nullopt;
+  }
+  return std::move(buffer).str();
+}
+
+bool WriteFile(std::filesystem::path const& path, std::string_view contents) {
+  std::ofstream file;
+  file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+  file.write(contents.data(), contents.size());
+  file.close();
+  return !file.fail();
+}
+
+// Reads the outputs stored in an entry, in the order of kOutputExtensions.
+// Returns nullopt if any of them is missing or doesn't match its hash.
+std::optional<std::vector<std::string>> ReadEntry(
+    std::filesystem::path const& entry_path) {
+  auto hashes_file = ReadFile(entry_path / kHashesFileName);
+  if (!hashes_file) {
+    return std::nullopt;
+  }
+
+  std::map<std::string, std::string, std::less<>> hashes;
+  std::istringstream hashes_stream(*hashes_file);
+  std::string extension;
+  std::string hash;
+  while (hashes_stream >> extension >> hash) {
+    hashes.emplace(extension, hash);
+  }
+
+  std::vector<std::string> outputs;
+  for (auto extension : kOutputExtensions) {
+    auto it = hashes.find(extension);
+    auto contents = ReadFile(EntryFilePath(entry_path, extension));
+    if (it == hashes.end() || !contents ||
+        util::Sha256Hex(*contents) != it->second) {
+      return std::nullopt;
+    }
+    outputs.push_back(std::move(contents).value());
+  }
+  return outputs;
+}
+
+// Strings are length-prefixed so that no two token streams encode the same.
+void HashToken(util::Sha256* hasher, tokens::Token const& token) {
+  if (auto const* ident = token.AsIdent()) {
+    auto name = ident->name.view();
+    hasher->Update(absl::StrFormat("i%d:%s%d\n", name.size(), name,
+                                   int(ident->trailer)));
+  } else if (auto const* string = token.AsString()) {
+    auto value = string->decodedString.view();
+    hasher->Update(absl::StrFormat("s%d:%s\n", value.size(), value));
+  } else if (auto const* number = token.AsNumber()) {
+    hasher->Update(absl::StrFormat("n%d\n", number->value));
+  } else if (auto const* punct = token.AsPunct()) {
+    hasher->Update(absl::StrFormat("p%c\n", char(punct->type)));
+  } else if (auto const* preproc = token.AsPreProcessor()) {
+    hasher->Update(absl::StrFormat("x%d\n", int(preproc->type)));
+    for (auto const& line_token : preproc->lineTokens) {
+      HashToken(hasher, line_token);
+    }
+  }
+}
+
+}  // namespace
+
+std::string HashTokens(absl::Span<tokens::Token const> tokens) {
+  util::Sha256 hasher;
+  for (auto const& token : tokens) {
+    HashToken(&hasher, token);
+  }
+  return std::move(hasher).FinishHex();
+}
+
+std::string ComputeCacheKey(std::string_view token_hash,
+                            codegen::CodeGenerator::Options const& options,
+                            std::string_view global_fingerprint) {
+  util::Sha256 hasher;
+  hasher.Update(absl::StrFormat("%s\ntarget %d\nopt %d\ntokens %s\nenv %s\n",
+                                kCacheVersion, int(options.target),
+                                int(options.opt), token_hash,
+                                global_fingerprint));
+  return std::move(hasher).FinishHex();
+}
+
+status::StatusOr<bool> CompileCache::Fetch(
+    std::string_view key, std::filesystem::path const& output_directory,
+    std::size_t script_num) const {
+  auto entry_path = EntryPath(key);
+  std::error_code error;
+  if (!std::filesystem::is_directory(entry_path, error)) {
+    return false;
+  }
+
+  auto outputs = ReadEntry(entry_path);
+  if (!outputs) {
+    // The entry is incomplete or damaged, or was removed by someone cleaning
+    // the cache. Treat it as a miss, and remove it so that the caller's
+    // regenerated outputs can be stored in its place.
+    std::filesystem::remove_all(entry_path, error);
+    return false;
+  }
+
+  // Only write the outputs once the whole entry has been checked, so that a
+  // miss never leaves a mix of cached and stale outputs behind.
+  for (std::size_t i = 0; i < std::size(kOutputExtensions); ++i) {
+    auto output_path =
+        OutputPath(output_directory, script_num, kOutputExtensions[i]);
+    if (!WriteFile(output_path, (*outputs)[i])) {
+      return status::FailedPreconditionError(
+          absl::StrFormat("Could not write file: %s", output_path));
+    }
+  }
+  return true;
+}
+
+status::Status CompileCache::Store(
+    std::string_view key, std::filesystem::path const& output_directory,
+    std::size_t script_num) const {
+  auto entry_path = EntryPath(key);
+  std::error_code error;
+  if (std::filesystem::is_directory(entry_path, error)) {
+    return status::OkStatus();
+  }
+
+  std::random_device random;
+  auto temp_path =
+      root_ / "tmp" /
+      absl::StrFormat("%s.%08x%08x", key, std::uint32_t(random()),
+                      std::uint32_t(random()));
+  std::filesystem::create_directories(temp_path, error);
+  if (error) {
+    return status::FailedPreconditionError(absl::StrFormat(
+        "Could not create cache directory %s: %s", temp_path, error.message()));
+  }
+
+  std::string hashes;
+  for (auto extension : kOutputExtensions) {
+    auto contents =
+        ReadFile(OutputPath(output_directory, script_num, extension));
+    if (!contents || !WriteFile(EntryFilePath(temp_path, extension),
+                                *contents)) {
+      std::filesystem::remove_all(temp_path, error);
+      return status::FailedPreconditionError(
+          absl::StrFormat("Could not copy script %d outputs to cache",
+                          script_num));
+    }
+    hashes += absl::StrFormat("%s %s\n", extension,
+                              util::Sha256Hex(*contents));
+  }
+  if (!WriteFile(temp_path / kHashesFileName, hashes)) {
+    std::filesystem::remove_all(temp_path, error);
+    return status::FailedPreconditionError(absl::StrFormat(
+        "Could not write script %d cache entry", script_num));
+  }
+
+  std::filesystem::create_directories(entry_path.parent_path(), error);
+  std::filesystem::rename(temp_path, entry_path, error);
+  if (error) {
+    // Either another process stored the same entry first, in which case its
+    // contents are identical to ours, or the cache is unwritable. Neither is
+    // worth failing the build over.
+    std::filesystem::remove_all(temp_path, error);
+  }
+  return status::OkStatus();
+}
+
+std::filesystem::path CompileCache::EntryPath(std::string_view key) const {
+  // Spread entries over subdirectories, to keep the directories small.
+  return root_ / key.substr(0, 2) / key;
+}
+
+}  // namespace frontend
@@ -0,0 +1,60 @@
+#ifndef FRONTEND_COMPILE_CACHE_HPP
+#define FRONTEND_COMPILE_CACHE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/types/span.h"
+#include "scic/codegen/code_generator.hpp"
+#include "scic/status/status.hpp"
+#include "scic/tokens/token.hpp"
+
+namespace frontend {
+
+// Hashes a preprocessed token stream. Only the token values contribute, not
+// where they came from, so the same script in two checkouts hashes the same.
+std::string HashTokens(absl::Span<tokens::Token const> tokens);
+
+// Computes the cache key for a module from the hash of its preprocessed
+// tokens, the code generation options, and the fingerprint of the part of the
+// global environment the module uses.
+std::string ComputeCacheKey(std::string_view token_hash,
+                            codegen::CodeGenerator::Options const& options,
+                            std::string_view global_fingerprint);
+
+// A content-addressed store for the outputs of compiling a single script
+// (the .hep, .scr, and .sl files).
+//
+// Each entry is a directory named by its key. Entries are written to a
+// temporary directory and renamed into place, so readers only ever see
+// complete entries, and any number of processes can share a cache.
+class CompileCache {
+ public:
+  explicit CompileCache(std::filesystem::path root) : root_(std::move(root)) {}
+
+  // If the cache has an entry for the key, copies its outputs into the output
+  // directory under the given script number and returns true. An entry whose
+  // outputs don't match the hashes stored with them is removed, and counts as
+  // a miss.
+  status::StatusOr<bool> Fetch(std::string_view key,
+                               std::filesystem::path const& output_directory,
+                               std::size_t script_num) const;
+
+  // Stores the outputs of the given script from the output directory under
+  // the key. If another process stored the same key first, its entry is kept.
+  status::Status Store(std::string_view key,
+                       std::filesystem::path const& output_directory,
+                       std::size_t script_num) const;
+
+ private:
+  std::filesystem::path EntryPath(std::string_view key) const;
+
+  std::filesystem::path root_;
+};
+
+}  // namespace frontend
+
+#endif
@@ -0,0 +1,145 @@
+#include "scic/frontend/compile_cache.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/code_generator.hpp"
+#include "util/status/status_matchers.hpp"
+
+namespace frontend {
+namespace {
+
+using ::util::status::IsOkAndHolds;
+
+constexpr std::size_t kScriptNum = 5;
+
+class CompileCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::path(::testing::TempDir()) /
+           ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(OutputDir());
+    key_ = ComputeCacheKey(
+        "tokens",
+        codegen::CodeGenerator::Options{
+            .target = codegen::SciTarget::SCI_2,
+            .opt = codegen::Optimization::OPTIMIZE,
+        },
+        "fingerprint");
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  std::filesystem::path CacheDir() const { return dir_ / "cache"; }
+  std::filesystem::path OutputDir() const { return dir_ / "out"; }
+
+  std::filesystem::path OutputPath(std::string_view extension) const {
+    return OutputDir() / (std::to_string(kScriptNum) + "." +
+                          std::string(extension));
+  }
+
+  static void WriteFile(std::filesystem::path const& path,
+                        std::string_view contents) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << contents;
+  }
+
+  static std::string ReadFile(std::filesystem::path const& path) {
+    std::ifstream file(path);
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+  }
+
+  void WriteOutputs(std::string_view contents) {
+    for (auto const* extension : {"hep", "scr", "sl"}) {
+      WriteFile(OutputPath(extension), std::string(contents) + extension);
+    }
+  }
+
+  // Stores the given outputs under key_, and then replaces them in the
+  // output directory, so that a fetch has to restore them.
+  void StoreOutputs(CompileCache const& cache, std::string_view contents) {
+    WriteOutputs(contents);
+    ASSERT_OK(cache.Store(key_, OutputDir(), kScriptNum));
+    WriteOutputs("stale");
+  }
+
+  // The directory holding the entry for key_.
+  std::filesystem::path EntryPath() const {
+    for (auto const& dir :
+         std::filesystem::recursive_directory_iterator(CacheDir())) {
+      if (dir.path().filename() == key_) {
+        return dir.path();
+      }
+    }
+    return {};
+  }
+
+  std::filesystem::path dir_;
+  std::string key_;
+};
+
+TEST_F(CompileCacheTest, FetchReturnsStoredOutputs) {
+  CompileCache cache(CacheDir());
+  StoreOutputs(cache, "cached");
+
+  EXPECT_THAT(cache.Fetch(key_, OutputDir(), kScriptNum), IsOkAndHolds(true));
+  EXPECT_EQ(ReadFile(OutputPath("hep")), "cachedhep");
+  EXPECT_EQ(ReadFile(OutputPath("scr")), "cachedscr");
+  EXPECT_EQ(ReadFile(OutputPath("sl")), "cachedsl");
+}
+
+TEST_F(CompileCacheTest, DifferentKeyMisses) {
+  CompileCache cache(CacheDir());
+  StoreOutputs(cache, "cached");
+
+  auto other_key = ComputeCacheKey(
+      "tokens",
+      codegen::CodeGenerator::Options{
+          .target = codegen::SciTarget::SCI_2,
+          .opt = codegen::Optimization::NO_OPTIMIZE,
+      },
+      "fingerprint");
+  ASSERT_NE(other_key, key_);
+  EXPECT_THAT(cache.Fetch(other_key, OutputDir(), kScriptNum),
+              IsOkAndHolds(false));
+  EXPECT_EQ(ReadFile(OutputPath("hep")), "stalehep");
+}
+
+TEST_F(CompileCacheTest, CorruptEntryMisses) {
+  CompileCache cache(CacheDir());
+  StoreOutputs(cache, "cached");
+  auto entry_path = EntryPath();
+  ASSERT_FALSE(entry_path.empty());
+
+  WriteFile(entry_path / "script.scr", "garbage");
+  EXPECT_THAT(cache.Fetch(key_, OutputDir(), kScriptNum), IsOkAndHolds(false));
+  // None of the outputs are overwritten by a corrupt entry.
+  EXPECT_EQ(ReadFile(OutputPath("hep")), "stalehep");
+  EXPECT_EQ(ReadFile(OutputPath("scr")), "stalescr");
+
+  // The corrupt entry is replaced by the next store.
+  StoreOutputs(cache, "rebuilt");
+  EXPECT_THAT(cache.Fetch(key_, OutputDir(), kScriptNum), IsOkAndHolds(true));
+  EXPECT_EQ(ReadFile(OutputPath("scr")), "rebuiltscr");
+}
+
+TEST_F(CompileCacheTest, IncompleteEntryMisses) {
+  CompileCache cache(CacheDir());
+  StoreOutputs(cache, "cached");
+  auto entry_path = EntryPath();
+  ASSERT_FALSE(entry_path.empty());
+
+  std::filesystem::remove(entry_path / "script.sl");
+  EXPECT_THAT(cache.Fetch(key_, OutputDir(), kScriptNum), IsOkAndHolds(false));
+  EXPECT_EQ(ReadFile(OutputPath("hep")), "stalehep");
+}
+
+}  // namespace
+}  // namespace frontend
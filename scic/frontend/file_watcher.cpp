@@ -0,0 +1,164 @@
+#include "scic/frontend/file_watcher.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "scic/status/status.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace frontend {
+namespace {
+
+#ifdef __linux__
+
+class InotifyFileWatcher : public FileWatcher {
+ public:
+  explicit InotifyFileWatcher(int fd) : fd_(fd) {}
+  ~InotifyFileWatcher() override { close(fd_); }
+
+  status::Status AddDirectory(std::filesystem::path const& directory) {
+    int wd = inotify_add_watch(
+        fd_, directory.c_str(),
+        IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+    if (wd < 0) {
+      return status::FailedPreconditionError(absl::StrFormat(
+          "Could not watch %s: %s", directory, std::strerror(errno)));
+    }
+    directories_.emplace(wd, directory);
+    return status::OkStatus();
+  }
+
+  status::StatusOr<std::vector<std::filesystem::path>> WaitForChanges(
+      std::optional<std::chrono::milliseconds> timeout) override {
+    pollfd poll_fd = {.fd = fd_, .events = POLLIN, .revents = 0};
+    int result = poll(&poll_fd, 1, timeout ? int(timeout->count()) : -1);
+    if (result < 0 && errno != EINTR) {
+      return status::FailedPreconditionError(absl::StrFormat(
+          "Could not wait for file changes: %s", std::strerror(errno)));
+    }
+    if (result <= 0) {
+      return std::vector<std::filesystem::path>();
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    auto count = read(fd_, buffer, sizeof(buffer));
+    if (count < 0) {
+      return status::FailedPreconditionError(absl::StrFormat(
+          "Could not read file changes: %s", std::strerror(errno)));
+    }
+
+    std::vector<std::filesystem::path> changes;
+    for (char* ptr = buffer; ptr < buffer + count;) {
+      auto const* event = reinterpret_cast<inotify_event const*>(ptr);
+      auto it = directories_.find(event->wd);
+      if (it != directories_.end() && event->len > 0) {
+        changes.push_back(it->second / event->name);
+      }
+      ptr += sizeof(inotify_event) + event->len;
+    }
+    return changes;
+  }
+
+ private:
+  int fd_;
+  std::map<int, std::filesystem::path> directories_;
+};
+
+#endif
+
+// Finds changes by comparing the modification times of the files in each
+// directory, once per interval.
+class PollingFileWatcher : public FileWatcher {
+ public:
+  explicit PollingFileWatcher(std::vector<std::filesystem::path> directories)
+      : directories_(std::move(directories)), snapshot_(TakeSnapshot()) {}
+
+  status::StatusOr<std::vector<std::filesystem::path>> WaitForChanges(
+      std::optional<std::chrono::milliseconds> timeout) override {
+    auto deadline =
+        timeout ? std::optional(std::chrono::steady_clock::now() + *timeout)
+                : std::nullopt;
+    while (true) {
+      auto snapshot = TakeSnapshot();
+      std::vector<std::filesystem::path> changes;
+      for (auto const& [path, time] : snapshot) {
+        auto it = snapshot_.find(path);
+        if (it == snapshot_.end() || it->second != time) {
+          changes.push_back(path);
+        }
+      }
+      for (auto const& [path, time] : snapshot_) {
+        if (!snapshot.contains(path)) {
+          changes.push_back(path);
+        }
+      }
+      snapshot_ = std::move(snapshot);
+
+      if (!changes.empty() ||
+          (deadline && std::chrono::steady_clock::now() >= *deadline)) {
+        return changes;
+      }
+      std::this_thread::sleep_for(kPollInterval);
+    }
+  }
+
+ private:
+  static constexpr std::chrono::milliseconds kPollInterval{250};
+
+  std::map<std::filesystem::path, std::filesystem::file_time_type>
+  TakeSnapshot() const {
+    std::map<std::filesystem::path, std::filesystem::file_time_type> snapshot;
+    for (auto const& directory : directories_) {
+      std::error_code error;
+      for (auto const& entry :
+           std::filesystem::directory_iterator(directory, error)) {
+        auto time = entry.last_write_time(error);
+        if (!error) {
+          snapshot.emplace(entry.path(), time);
+        }
+      }
+    }
+    return snapshot;
+  }
+
+  std::vector<std::filesystem::path> directories_;
+  std::map<std::filesystem::path, std::filesystem::file_time_type> snapshot_;
+};
+
+}  // namespace
+
+status::StatusOr<std::unique_ptr<FileWatcher>> FileWatcher::Create(
+    std::vector<std::filesystem::path> directories) {
+#ifdef __linux__
+  int fd = inotify_init1(IN_CLOEXEC);
+  if (fd >= 0) {
+    auto watcher = std::make_unique<InotifyFileWatcher>(fd);
+    for (auto const& directory : directories) {
+      auto status = watcher->AddDirectory(directory);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return watcher;
+  }
+#endif
+  return std::make_unique<PollingFileWatcher>(std::move(directories));
+}
+
+}  // namespace frontend
@@ -0,0 +1,32 @@
+#ifndef FRONTEND_FILE_WATCHER_HPP
+#define FRONTEND_FILE_WATCHER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "scic/status/status.hpp"
+
+namespace frontend {
+
+// Watches a set of directories for changes to the files directly in them.
+class FileWatcher {
+ public:
+  // Uses inotify where it is available, and polls modification times
+  // otherwise.
+  static status::StatusOr<std::unique_ptr<FileWatcher>> Create(
+      std::vector<std::filesystem::path> directories);
+
+  virtual ~FileWatcher() = default;
+
+  // Waits until files change, or until the timeout passes if one is given.
+  // Returns the paths of the changed files, which is empty on a timeout.
+  virtual status::StatusOr<std::vector<std::filesystem::path>> WaitForChanges(
+      std::optional<std::chrono::milliseconds> timeout) = 0;
+};
+
+}  // namespace frontend
+
+#endif
@@ -1,6 +1,8 @@
 #include "scic/frontend/flags.hpp"
 
 #include <algorithm>
+#include <charconv>
+#include <cstddef>
 #include <exception>
 #include <filesystem>
 #include <iostream>
@@ -9,6 +11,7 @@
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <vector>
 
 #include "argparse/argparse.hpp"
@@ -23,9 +26,33 @@ inline constexpr std::string_view kProgramBanner =
     ")\n"
     "(c) 2024 by Brian Chin and Digital Alchemy Studios, LLC. Released under "
     "the MIT License.";
+
+// Parses a shard specification of the form "i/N".
+void ParseShard(std::string_view shard, CompilerFlags* flags) {
+  auto slash = shard.find('/');
+  if (slash == std::string_view::npos) {
+    throw std::runtime_error("Invalid shard: expected i/N");
+  }
+  auto index_str = shard.substr(0, slash);
+  auto count_str = shard.substr(slash + 1);
+  auto index_result = std::from_chars(
+      index_str.data(), index_str.data() + index_str.size(),
+      flags->shard_index);
+  auto count_result = std::from_chars(
+      count_str.data(), count_str.data() + count_str.size(),
+      flags->shard_count);
+  if (index_result.ec != std::errc() ||
+      index_result.ptr != index_str.data() + index_str.size() ||
+      count_result.ec != std::errc() ||
+      count_result.ptr != count_str.data() + count_str.size() ||
+      flags->shard_count == 0 || flags->shard_index >= flags->shard_count) {
+    throw std::runtime_error("Invalid shard: expected i/N with 0 <= i < N");
+  }
 }
 
-CompilerFlags ExtractFlags(int argc, char** argv) {
+}  // namespace
+
+CompilerFlags ExtractFlags(int argc, char** argv, FlagSource source) {
   CompilerFlags flags;
 
   auto InstallCommandLineDefine = [&flags](std::string define) {
@@ -37,8 +64,10 @@ CompilerFlags ExtractFlags(int argc, char** argv) {
           define.substr(pos + 1);
     }
   };
-  argparse::ArgumentParser program("scic",
-                                   std::string(frontend::kProgramBanner));
+  argparse::ArgumentParser program(
+      "scic", std::string(frontend::kProgramBanner),
+      source == FlagSource::WORK_REQUEST ? argparse::default_arguments::none
+                                         : argparse::default_arguments::all);
   program.add_argument("-a")
       .help("abort compile if database locked")
       .default_value(false)
@@ -110,6 +139,45 @@ CompilerFlags ExtractFlags(int argc, char** argv) {
       .default_value(std::vector<std::string>())
       .append()
       .nargs(1);
+  program.add_argument("--parse_threads")
+      .help("number of threads to use when parsing top-level items")
+      .default_value(std::size_t{1})
+      .scan<'u', std::size_t>();
+  program.add_argument("--env_threads")
+      .help("number of threads to use when building module environments")
+      .default_value(std::size_t{1})
+      .scan<'u', std::size_t>();
+  program.add_argument("--summary")
+      .help("module summary file for a script that is not being compiled")
+      .default_value(std::vector<std::string>())
+      .append()
+      .nargs(1);
+  program.add_argument("--emit_summaries")
+      .help("write a module summary (.sum) for each compiled script")
+      .default_value(false)
+      .flag();
+  program.add_argument("--incremental")
+      .help("only recompile scripts whose inputs changed since the last build")
+      .default_value(false)
+      .flag();
+  program.add_argument("--emit_dep_files")
+      .help("write a make-style dependency file (.d) for each compiled script")
+      .default_value(false)
+      .flag();
+  program.add_argument("--cache_dir")
+      .help("directory for caching compiled scripts between builds")
+      .default_value("");
+  program.add_argument("--shard")
+      .help("only compile shard i of N of the scripts, given as i/N")
+      .default_value("");
+  program.add_argument("--watch")
+      .help("recompile whenever a source file, include, or header changes")
+      .default_value(false)
+      .flag();
+  program.add_argument("--stream")
+      .help("compile one script at a time to reduce peak memory use")
+      .default_value(false)
+      .flag();
   program.add_argument("files")
       .default_value(std::vector<std::string>())
       .remaining();
@@ -165,6 +233,21 @@ CompilerFlags ExtractFlags(int argc, char** argv) {
     flags.include_paths =
         program.get<std::vector<std::string>>("--include_path");
     flags.files = program.get<std::vector<std::string>>("files");
+    flags.parse_threads = program.get<std::size_t>("--parse_threads");
+    flags.env_threads = program.get<std::size_t>("--env_threads");
+    flags.summary_files = program.get<std::vector<std::string>>("--summary");
+    flags.emit_summaries = program.get<bool>("--emit_summaries");
+    flags.incremental = program.get<bool>("--incremental");
+    flags.emit_dep_files = program.get<bool>("--emit_dep_files");
+    flags.cache_directory = program.get<std::string>("--cache_dir");
+    flags.watch = program.get<bool>("--watch");
+    flags.stream = program.get<bool>("--stream");
+    if (flags.stream && flags.incremental) {
+      throw std::runtime_error("--stream can't be used with --incremental");
+    }
+    if (auto shard = program.get<std::string>("--shard"); !shard.empty()) {
+      ParseShard(shard, &flags);
+    }
     return flags;
   } catch (const std::exception& err) {
     std::cerr << err.what() << std::endl;
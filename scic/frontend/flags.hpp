@@ -1,6 +1,7 @@
 #ifndef FRONTEND_FLAGS_HPP
 #define FRONTEND_FLAGS_HPP
 
+#include <cstddef>
 #include <filesystem>
 #include <map>
 #include <string>
@@ -22,9 +23,47 @@ class CompilerFlags {
   std::vector<std::filesystem::path> global_includes;
   std::vector<std::string> include_paths;
   std::vector<std::string> files;
+  // The number of threads to use when parsing the top-level items of a file.
+  std::size_t parse_threads = 1;
+  // The number of threads to use when building the per-module environments.
+  std::size_t env_threads = 1;
+  // Summaries of scripts that are not being compiled in this run.
+  std::vector<std::string> summary_files;
+  // If true, writes a summary of each compiled script to the output
+  // directory.
+  bool emit_summaries = false;
+  // If true, only recompiles scripts whose inputs have changed since the
+  // last build into the output directory.
+  bool incremental = false;
+  // If true, writes a make-style dependency file (.d) for each compiled
+  // script to the output directory.
+  bool emit_dep_files = false;
+  // If set, script outputs are looked up in and stored to this cache
+  // directory.
+  std::filesystem::path cache_directory;
+  // Only generates code for shard `shard_index` of `shard_count`. The other
+  // scripts are still read, to build the global environment.
+  std::size_t shard_index = 0;
+  std::size_t shard_count = 1;
+  // If true, keeps running and recompiles whenever an input changes.
+  bool watch = false;
+  // If true, compiles one script at a time, freeing each script's parse
+  // tree and environment once its output is written. Scripts are parsed
+  // twice: once to build the global environment, and once to compile them.
+  bool stream = false;
 };
 
-CompilerFlags ExtractFlags(int argc, char** argv);
+// Where the arguments being parsed came from.
+enum class FlagSource {
+  COMMAND_LINE,
+  // A request to a persistent worker or compile server. The process is
+  // shared between requests, so the arguments can't print the help or
+  // version text to stdout and exit, as --help and --version do.
+  WORK_REQUEST,
+};
+
+CompilerFlags ExtractFlags(int argc, char** argv,
+                           FlagSource source = FlagSource::COMMAND_LINE);
 
 }  // namespace frontend
 #endif
\ No newline at end of file
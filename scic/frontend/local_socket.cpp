@@ -0,0 +1,210 @@
+#include "scic/frontend/local_socket.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/strings/str_format.h"
+#include "scic/status/status.hpp"
+
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__linux__)
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace frontend {
+namespace {
+
+status::Status ErrnoError(std::string_view action,
+                          std::filesystem::path const& path) {
+  return status::FailedPreconditionError(absl::StrFormat(
+      "Could not %s %s: %s", action, path, std::strerror(errno)));
+}
+
+// Fills in the address for a socket path, which must fit in sun_path.
+status::StatusOr<sockaddr_un> MakeAddress(std::filesystem::path const& path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  auto const& native_path = path.native();
+  if (native_path.size() >= sizeof(address.sun_path)) {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Socket path is too long: %s", path));
+  }
+  std::memcpy(address.sun_path, native_path.c_str(), native_path.size() + 1);
+  return address;
+}
+
+// A client going away mid-response must not kill the server with SIGPIPE.
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+class LocalConnectionImpl : public LocalConnection {
+ public:
+  explicit LocalConnectionImpl(int fd) : fd_(fd) {
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+  }
+  ~LocalConnectionImpl() override { close(fd_); }
+
+  status::StatusOr<std::string> ReadLine() override {
+    while (true) {
+      auto newline = buffer_.find('\n');
+      if (newline != std::string::npos) {
+        auto line = buffer_.substr(0, newline);
+        buffer_.erase(0, newline + 1);
+        return line;
+      }
+
+      char chunk[4096];
+      auto count = read(fd_, chunk, sizeof(chunk));
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return status::FailedPreconditionError(absl::StrFormat(
+            "Could not read from socket: %s", std::strerror(errno)));
+      }
+      if (count == 0) {
+        return status::NotFoundError("Connection closed");
+      }
+      buffer_.append(chunk, count);
+    }
+  }
+
+  status::Status WriteLine(std::string_view line) override {
+    std::string message(line);
+    message.push_back('\n');
+    std::string_view remaining = message;
+    while (!remaining.empty()) {
+      auto count = send(fd_, remaining.data(), remaining.size(), kSendFlags);
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return status::FailedPreconditionError(absl::StrFormat(
+            "Could not write to socket: %s", std::strerror(errno)));
+      }
+      remaining.remove_prefix(count);
+    }
+    return status::OkStatus();
+  }
+
+ private:
+  int fd_;
+  // Data read past the end of the last line.
+  std::string buffer_;
+};
+
+class LocalListenerImpl : public LocalListener {
+ public:
+  LocalListenerImpl(std::filesystem::path path, int fd)
+      : path_(std::move(path)), fd_(fd) {}
+  ~LocalListenerImpl() override {
+    close(fd_);
+    unlink(path_.c_str());
+  }
+
+  status::StatusOr<std::unique_ptr<LocalConnection>> Accept() override {
+    while (true) {
+      int client_fd = accept(fd_, nullptr, nullptr);
+      if (client_fd >= 0) {
+        return std::make_unique<LocalConnectionImpl>(client_fd);
+      }
+      if (errno != EINTR) {
+        return ErrnoError("accept connections on", path_);
+      }
+    }
+  }
+
+ private:
+  std::filesystem::path path_;
+  int fd_;
+};
+
+}  // namespace
+
+status::StatusOr<std::unique_ptr<LocalConnection>> LocalConnection::Connect(
+    std::filesystem::path const& path) {
+  auto address = MakeAddress(path);
+  if (!address.ok()) {
+    return address.status();
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return ErrnoError("create socket for", path);
+  }
+  if (connect(fd, reinterpret_cast<sockaddr const*>(&address.value()),
+              sizeof(sockaddr_un)) != 0) {
+    auto error = ErrnoError("connect to", path);
+    close(fd);
+    return error;
+  }
+  return std::make_unique<LocalConnectionImpl>(fd);
+}
+
+status::StatusOr<std::unique_ptr<LocalListener>> LocalListener::Listen(
+    std::filesystem::path const& path) {
+  auto address = MakeAddress(path);
+  if (!address.ok()) {
+    return address.status();
+  }
+
+  if (std::filesystem::exists(path)) {
+    if (LocalConnection::Connect(path).ok()) {
+      return status::FailedPreconditionError(
+          absl::StrFormat("A server is already listening on %s", path));
+    }
+    unlink(path.c_str());
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return ErrnoError("create socket for", path);
+  }
+  if (bind(fd, reinterpret_cast<sockaddr const*>(&address.value()),
+           sizeof(sockaddr_un)) != 0) {
+    auto error = ErrnoError("bind to", path);
+    close(fd);
+    return error;
+  }
+  if (listen(fd, SOMAXCONN) != 0) {
+    auto error = ErrnoError("listen on", path);
+    close(fd);
+    unlink(path.c_str());
+    return error;
+  }
+  return std::make_unique<LocalListenerImpl>(path, fd);
+}
+
+}  // namespace frontend
+
+#else
+
+namespace frontend {
+
+status::StatusOr<std::unique_ptr<LocalConnection>> LocalConnection::Connect(
+    std::filesystem::path const& path) {
+  return status::FailedPreconditionError(
+      "Local sockets are not supported on this platform");
+}
+
+status::StatusOr<std::unique_ptr<LocalListener>> LocalListener::Listen(
+    std::filesystem::path const& path) {
+  return status::FailedPreconditionError(
+      "Local sockets are not supported on this platform");
+}
+
+}  // namespace frontend
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef FRONTEND_LOCAL_SOCKET_HPP
+#define FRONTEND_LOCAL_SOCKET_HPP
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "scic/status/status.hpp"
+
+namespace frontend {
+
+// A connection over a local (Unix domain) socket, carrying newline-delimited
+// messages.
+class LocalConnection {
+ public:
+  // Connects to a socket that a LocalListener is listening on.
+  static status::StatusOr<std::unique_ptr<LocalConnection>> Connect(
+      std::filesystem::path const& path);
+
+  virtual ~LocalConnection() = default;
+
+  // Reads the next message, without its newline. Returns a NotFound error if
+  // the other side closed the connection.
+  virtual status::StatusOr<std::string> ReadLine() = 0;
+
+  // Writes a message. The message must not contain a newline.
+  virtual status::Status WriteLine(std::string_view line) = 0;
+};
+
+class LocalListener {
+ public:
+  // Starts listening on the given path. A stale socket file left behind by a
+  // server that has exited is replaced, but it is an error if another server
+  // is still listening on it.
+  static status::StatusOr<std::unique_ptr<LocalListener>> Listen(
+      std::filesystem::path const& path);
+
+  virtual ~LocalListener() = default;
+
+  // Waits for the next client to connect.
+  virtual status::StatusOr<std::unique_ptr<LocalConnection>> Accept() = 0;
+};
+
+}  // namespace frontend
+
+#endif
@@ -1,37 +1,60 @@
 #include <algorithm>
 #include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "absl/container/btree_map.h"
 #include "absl/debugging/failure_signal_handler.h"
 #include "absl/debugging/symbolize.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "scic/codegen/code_generator.hpp"
 #include "scic/codegen/output.hpp"
 #include "scic/codegen/text_sink.hpp"
+#include "scic/frontend/build_state.hpp"
+#include "scic/frontend/compile_cache.hpp"
+#include "scic/frontend/file_watcher.hpp"
 #include "scic/frontend/flags.hpp"
+#include "scic/frontend/local_socket.hpp"
+#include "scic/frontend/worker_protocol.hpp"
 #include "scic/parsers/include_context.hpp"
 #include "scic/parsers/list_tree/parser.hpp"
 #include "scic/parsers/sci/parser.hpp"
 #include "scic/sem/code_builder.hpp"
 #include "scic/sem/input.hpp"
+#include "scic/sem/item_index.hpp"
 #include "scic/sem/module_env.hpp"
+#include "scic/sem/module_summary.hpp"
 #include "scic/status/status.hpp"
 #include "scic/text/text_range.hpp"
 #include "scic/tokens/token.hpp"
 #include "scic/tokens/token_readers.hpp"
+#include "util/hash/sha256.hpp"
 #include "util/status/status_macros.hpp"
 #include "util/strings/ref_str.hpp"
 
@@ -64,23 +87,46 @@ status::StatusOr<text::TextRange> LoadFile(std::filesystem::path path) {
                                        buffer.str());
 }
 
-status::StatusOr<std::vector<tokens::Token>> TokenizeFile(
-    std::filesystem::path const& path) {
-  ASSIGN_OR_RETURN(auto text, LoadFile(std::move(path)));
-  return tokens::TokenizeText(std::move(text));
-}
+// Loads the source files read by the compiler.
+class SourceLoader {
+ public:
+  virtual ~SourceLoader() = default;
+
+  virtual status::StatusOr<text::TextRange> Load(
+      std::filesystem::path const& path) const = 0;
+
+  // Returns a digest of the file's current contents.
+  virtual status::StatusOr<std::string> Digest(
+      std::filesystem::path const& path) const = 0;
+};
+
+class DiskSourceLoader : public SourceLoader {
+ public:
+  status::StatusOr<text::TextRange> Load(
+      std::filesystem::path const& path) const override {
+    return LoadFile(path);
+  }
+
+  status::StatusOr<std::string> Digest(
+      std::filesystem::path const& path) const override {
+    return HashFile(path);
+  }
+};
 
 class ToolIncludeContext : public parsers::IncludeContext {
  public:
-  ToolIncludeContext(std::vector<std::filesystem::path> include_paths)
-      : include_paths_(std::move(include_paths)) {}
+  ToolIncludeContext(SourceLoader const* loader,
+                     std::vector<std::filesystem::path> include_paths)
+      : loader_(loader), include_paths_(std::move(include_paths)) {}
+
+  SourceLoader const* loader() const { return loader_; }
 
   status::StatusOr<text::TextRange> LoadTextFromIncludePath(
       std::string_view path) const override {
-    std::ifstream file;
     for (auto const& include_path : include_paths_) {
-      auto result = LoadFile(include_path / path);
+      auto result = loader_->Load(include_path / path);
       if (result.ok()) {
+        loaded_files_.push_back(include_path / path);
         return std::move(result).value();
       }
 
@@ -93,8 +139,16 @@ class ToolIncludeContext : public parsers::IncludeContext {
         absl::StrFormat("Could not find include file: %s", path));
   }
 
+  // Returns the resolved paths of the files included since the last call, in
+  // the order they were loaded.
+  std::vector<std::filesystem::path> TakeLoadedFiles() {
+    return std::exchange(loaded_files_, {});
+  }
+
  private:
+  SourceLoader const* loader_;
   std::vector<std::filesystem::path> include_paths_;
+  mutable std::vector<std::filesystem::path> loaded_files_;
 };
 
 class StreamOutputWriter : public codegen::OutputWriter {
@@ -172,30 +226,160 @@ std::unique_ptr<codegen::OutputFiles> CreateOutputFilesForScript(
   return std::make_unique<StreamOutputFiles>(std::move(heap), std::move(hunk));
 }
 
-status::Status RunMain(const CompilerFlags& flags) {
-  std::vector<tokens::Token> global_tokens;
+// Escapes a path for use in a makefile rule.
+std::string EscapeMakePath(std::string_view path) {
+  std::string result;
+  for (char c : path) {
+    switch (c) {
+      case ' ':
+      case '#':
+        result.push_back('\\');
+        break;
+      case '$':
+        result.push_back('$');
+        break;
+    }
+    result.push_back(c);
+  }
+  return result;
+}
 
-  for (auto const& global_include : flags.global_includes) {
-    ASSIGN_OR_RETURN(auto global_include_tokens, TokenizeFile(global_include));
-    std::ranges::move(std::move(global_include_tokens),
-                      std::back_inserter(global_tokens));
+// Writes a make-style dependency file for a script, listing every file its
+// outputs were built from.
+status::Status WriteDepFile(std::filesystem::path const& root_path,
+                            std::size_t script_num,
+                            absl::Span<std::filesystem::path const> deps) {
+  auto path = root_path / absl::StrFormat("%d.d", script_num);
+  std::ofstream file;
+  file.open(path, std::ios::out | std::ios::trunc);
+  if (!file.good()) {
+    return status::FailedPreconditionError(
+        absl::StrFormat("Could not open file: %s", path));
   }
-  // Load our files into memory.
 
-  std::vector<std::vector<tokens::Token>> source_file_tokens;
-  for (const auto& file : flags.files) {
-    ASSIGN_OR_RETURN(auto source_text, TokenizeFile(file));
-    source_file_tokens.push_back(std::move(source_text));
+  for (auto const* extension : {"hep", "scr", "sl"}) {
+    file << EscapeMakePath(
+                (root_path / absl::StrFormat("%d.%s", script_num, extension))
+                    .string())
+         << " ";
   }
+  file << ":";
 
-  std::vector<std::filesystem::path> include_paths;
-  for (auto include_path_str : flags.include_paths) {
-    include_paths.push_back(std::filesystem::path(include_path_str));
+  std::set<std::filesystem::path> seen;
+  for (auto const& dep : deps) {
+    if (seen.insert(dep).second) {
+      file << " \\\n  " << EscapeMakePath(dep.string());
+    }
+  }
+  file << "\n";
+
+  // Add an empty rule for each dependency, so that make doesn't fail if one
+  // of them is deleted.
+  for (auto const& dep : seen) {
+    file << "\n" << EscapeMakePath(dep.string()) << ":\n";
+  }
+  return status::OkStatus();
+}
+
+void CollectIdentifiers(parsers::list_tree::Expr const& expr,
+                        std::set<std::string>* identifiers) {
+  expr.visit(
+      [&](parsers::list_tree::TokenExpr const& token_expr) {
+        if (auto const* ident = token_expr.token().AsIdent()) {
+          identifiers->emplace(ident->name);
+        }
+      },
+      [&](parsers::list_tree::ListExpr const& list_expr) {
+        for (auto const& element : list_expr.elements()) {
+          CollectIdentifiers(element, identifiers);
+        }
+      });
+}
+
+// A source file that has been parsed into a module, along with the
+// information needed to record it in the build manifest.
+struct ParsedModule {
+  std::string source_file;
+  std::string source_hash;
+  // The hash of the module's tokens after preprocessing.
+  std::string token_hash;
+  std::vector<parsers::sci::Item> items;
+  std::vector<std::filesystem::path> includes;
+  std::set<std::string> identifiers;
+};
+
+status::StatusOr<ParsedModule> ParseModule(
+    std::ostream& err, std::string const& source_file,
+    ToolIncludeContext* include_context,
+    absl::btree_map<std::string, std::vector<tokens::Token>> const&
+        global_defines,
+    parsers::sci::ParseItemsOptions const& parse_options) {
+  ASSIGN_OR_RETURN(auto source_text,
+                   include_context->loader()->Load(source_file));
+  auto source_hash = util::Sha256Hex(source_text.contents());
+  ASSIGN_OR_RETURN(auto source_tokens,
+                   tokens::TokenizeText(std::move(source_text)));
+
+  parsers::list_tree::Parser source_parser(include_context);
+  for (auto const& entry : global_defines) {
+    source_parser.AddDefine(entry.first, entry.second);
   }
 
-  ToolIncludeContext include_context(std::move(include_paths));
+  ASSIGN_OR_RETURN(auto source_list_tree,
+                   source_parser.ParseTree(std::move(source_tokens)));
 
-  parsers::list_tree::Parser global_parser(&include_context);
+  auto source_items_result =
+      parsers::sci::ParseItems(source_list_tree, parse_options);
+
+  if (!source_items_result.ok()) {
+    err << source_items_result.status() << std::endl;
+    return status::FailedPreconditionError("Failed to parse source items");
+  }
+
+  std::set<std::string> identifiers;
+  std::vector<tokens::Token> preprocessed_tokens;
+  for (auto const& expr : source_list_tree) {
+    CollectIdentifiers(expr, &identifiers);
+    expr.WriteTokens(&preprocessed_tokens);
+  }
+
+  return ParsedModule{
+      .source_file = source_file,
+      .source_hash = std::move(source_hash),
+      .token_hash = HashTokens(preprocessed_tokens),
+      .items = std::move(source_items_result).value(),
+      .includes = include_context->TakeLoadedFiles(),
+      .identifiers = std::move(identifiers),
+  };
+}
+
+// The result of parsing the global includes, which is shared by every
+// module.
+struct GlobalState {
+  std::vector<parsers::sci::Item> items;
+  // The defines from the global includes and the command line, which are
+  // visible in every module.
+  absl::btree_map<std::string, std::vector<tokens::Token>> defines;
+  // The global includes, and every file they included, with the digests of
+  // their contents when they were parsed.
+  std::vector<std::pair<std::filesystem::path, std::string>> files;
+};
+
+status::StatusOr<GlobalState> ParseGlobals(
+    std::ostream& err, CompilerFlags const& flags,
+    ToolIncludeContext* include_context) {
+  std::vector<tokens::Token> global_tokens;
+
+  for (auto const& global_include : flags.global_includes) {
+    ASSIGN_OR_RETURN(auto global_include_text,
+                     include_context->loader()->Load(global_include));
+    ASSIGN_OR_RETURN(auto global_include_tokens,
+                     tokens::TokenizeText(std::move(global_include_text)));
+    std::ranges::move(std::move(global_include_tokens),
+                      std::back_inserter(global_tokens));
+  }
+
+  parsers::list_tree::Parser global_parser(include_context);
 
   for (auto const& define : flags.command_line_defines) {
     // Tokenize each command-line define and add it to the parser.
@@ -208,65 +392,1018 @@ status::Status RunMain(const CompilerFlags& flags) {
   ASSIGN_OR_RETURN(auto global_list_tree,
                    global_parser.ParseTree(std::move(global_tokens)));
 
-  // Keep the defines from the global parser for the individual files.
-  auto global_defines = global_parser.defines();
+  parsers::sci::ParseItemsOptions parse_options{
+      .num_threads = flags.parse_threads,
+  };
 
   // Parse the global trees, and add it to the global AST.
-  auto global_items_result = parsers::sci::ParseItems(global_list_tree);
+  auto global_items_result =
+      parsers::sci::ParseItems(global_list_tree, parse_options);
 
   if (!global_items_result.ok()) {
-    std::cerr << global_items_result.status() << std::endl;
+    err << global_items_result.status() << std::endl;
     return status::FailedPreconditionError("Failed to parse global items");
   }
 
+  GlobalState globals{
+      .items = std::move(global_items_result).value(),
+      // Keep the defines from the global parser for the individual files.
+      .defines = global_parser.defines(),
+  };
+  for (auto const& file : ConcatVectors(flags.global_includes,
+                                        include_context->TakeLoadedFiles())) {
+    ASSIGN_OR_RETURN(auto digest, include_context->loader()->Digest(file));
+    globals.files.emplace_back(file, std::move(digest));
+  }
+  return globals;
+}
+
+// State kept between the requests handled by a persistent worker or compile
+// server. Source files, parsed global includes, and parsed modules are reused
+// as long as the digests of the files they came from are unchanged.
+//
+// All methods are thread-safe.
+class WorkerCache {
+ public:
+  // Returns the contents of the file, if they were loaded before with the
+  // same digest.
+  std::optional<text::TextRange> FindFile(std::filesystem::path const& path,
+                                          std::string_view digest) const {
+    std::scoped_lock lock(mutex_);
+    auto it = files_.find(path);
+    if (it == files_.end() || it->second.first != digest) {
+      return std::nullopt;
+    }
+    return it->second.second;
+  }
+
+  void StoreFile(std::filesystem::path const& path, std::string digest,
+                 text::TextRange contents) {
+    std::scoped_lock lock(mutex_);
+    files_.insert_or_assign(path,
+                            std::make_pair(std::move(digest), contents));
+  }
+
+  // Returns the parsed global includes for the flags, parsing them if they
+  // have not been parsed yet or any of their files have changed.
+  status::StatusOr<std::shared_ptr<GlobalState const>> GetGlobals(
+      std::ostream& err, CompilerFlags const& flags,
+      ToolIncludeContext* include_context) {
+    auto key = GlobalsKey(flags);
+    std::shared_ptr<GlobalState const> globals;
+    {
+      std::scoped_lock lock(mutex_);
+      auto it = globals_.find(key);
+      if (it != globals_.end()) {
+        globals = it->second;
+      }
+    }
+
+    if (globals) {
+      bool up_to_date = true;
+      for (auto const& [file, digest] : globals->files) {
+        auto current_digest = include_context->loader()->Digest(file);
+        if (!current_digest.ok() || current_digest.value() != digest) {
+          up_to_date = false;
+          break;
+        }
+      }
+      if (up_to_date) {
+        return globals;
+      }
+    }
+
+    ASSIGN_OR_RETURN(auto parsed_globals,
+                     ParseGlobals(err, flags, include_context));
+    globals = std::make_shared<GlobalState const>(std::move(parsed_globals));
+    std::scoped_lock lock(mutex_);
+    globals_.insert_or_assign(std::move(key), globals);
+    return globals;
+  }
+
+  // Returns the parsed module for the source file, parsing it if it has not
+  // been parsed yet with these globals, or any of its files have changed.
+  status::StatusOr<std::shared_ptr<ParsedModule const>> GetModule(
+      std::ostream& err, std::string const& source_file,
+      std::shared_ptr<GlobalState const> const& globals,
+      ToolIncludeContext* include_context,
+      parsers::sci::ParseItemsOptions const& parse_options) {
+    auto const* loader = include_context->loader();
+    std::optional<ModuleEntry> entry;
+    {
+      std::scoped_lock lock(mutex_);
+      auto it = modules_.find(source_file);
+      if (it != modules_.end()) {
+        entry = it->second;
+      }
+    }
+
+    if (entry && entry->globals == globals) {
+      bool up_to_date = true;
+      for (auto const& [file, digest] : entry->files) {
+        auto current_digest = loader->Digest(file);
+        if (!current_digest.ok() || current_digest.value() != digest) {
+          up_to_date = false;
+          break;
+        }
+      }
+      if (up_to_date) {
+        return entry->module;
+      }
+    }
+
+    ASSIGN_OR_RETURN(auto parsed,
+                     ParseModule(err, source_file, include_context,
+                                 globals->defines, parse_options));
+    ModuleEntry new_entry{
+        .globals = globals,
+        .module = std::make_shared<ParsedModule const>(std::move(parsed)),
+    };
+    for (auto const& file :
+         ConcatVectors(std::vector<std::filesystem::path>{source_file},
+                       new_entry.module->includes)) {
+      ASSIGN_OR_RETURN(auto digest, loader->Digest(file));
+      new_entry.files.emplace_back(file, std::move(digest));
+    }
+
+    auto module = new_entry.module;
+    std::scoped_lock lock(mutex_);
+    modules_.insert_or_assign(source_file, std::move(new_entry));
+    return module;
+  }
+
+ private:
+  struct ModuleEntry {
+    // The globals the module was parsed with. Modules are parsed with the
+    // global defines, so they are reparsed when the globals change.
+    std::shared_ptr<GlobalState const> globals;
+    std::shared_ptr<ParsedModule const> module;
+    // The module's source and includes, with their digests.
+    std::vector<std::pair<std::filesystem::path, std::string>> files;
+  };
+
+  // The flags that affect how the global includes are parsed.
+  static std::string GlobalsKey(CompilerFlags const& flags) {
+    std::string key;
+    for (auto const& global_include : flags.global_includes) {
+      absl::StrAppendFormat(&key, "global %s\n", global_include);
+    }
+    for (auto const& include_path : flags.include_paths) {
+      absl::StrAppendFormat(&key, "include_path %s\n", include_path);
+    }
+    for (auto const& [name, value] : flags.command_line_defines) {
+      absl::StrAppendFormat(&key, "define %d:%s=%s\n", name.size(), name,
+                            value);
+    }
+    return key;
+  }
+
+  mutable std::mutex mutex_;
+  std::map<std::filesystem::path, std::pair<std::string, text::TextRange>>
+      files_;
+  std::map<std::string, std::shared_ptr<GlobalState const>> globals_;
+  std::map<std::string, ModuleEntry> modules_;
+};
+
+// Loads files for a single worker request. Files with a digest from Bazel are
+// shared through the worker cache.
+class WorkerSourceLoader : public SourceLoader {
+ public:
+  WorkerSourceLoader(WorkerCache* cache,
+                     std::map<std::filesystem::path, std::string> digests)
+      : cache_(cache), digests_(std::move(digests)) {}
+
+  status::StatusOr<text::TextRange> Load(
+      std::filesystem::path const& path) const override {
+    auto it = digests_.find(path);
+    if (it == digests_.end()) {
+      return LoadFile(path);
+    }
+    if (auto contents = cache_->FindFile(path, it->second)) {
+      return *std::move(contents);
+    }
+    ASSIGN_OR_RETURN(auto contents, LoadFile(path));
+    cache_->StoreFile(path, it->second, contents);
+    return contents;
+  }
+
+  status::StatusOr<std::string> Digest(
+      std::filesystem::path const& path) const override {
+    auto it = digests_.find(path);
+    if (it == digests_.end()) {
+      return HashFile(path);
+    }
+    return it->second;
+  }
+
+ private:
+  WorkerCache* cache_;
+  std::map<std::filesystem::path, std::string> digests_;
+};
+
+// The environment a compilation runs in.
+struct RunContext {
+  // Where progress messages and diagnostics are written.
+  std::ostream* out;
+  std::ostream* err;
+  SourceLoader const* loader;
+  // When running as a persistent worker, the state shared between requests.
+  WorkerCache* worker_cache = nullptr;
+  // If set, the paths of the generated script files are added to it.
+  std::vector<std::filesystem::path>* output_files = nullptr;
+};
+
+// The dependencies shared by every compiled module: the global files, and the
+// modules that are not being compiled.
+std::vector<std::filesystem::path> SharedDeps(
+    CompilerFlags const& flags,
+    std::vector<std::filesystem::path> const& global_files,
+    std::vector<std::filesystem::path> const& other_shard_deps) {
+  std::vector<std::filesystem::path> shared_deps = global_files;
+  for (auto const& summary_file : flags.summary_files) {
+    shared_deps.push_back(summary_file);
+  }
+  std::ranges::copy(other_shard_deps, std::back_inserter(shared_deps));
+  return shared_deps;
+}
+
+// What is kept of a module between the two passes of a streaming build.
+struct StreamedModule {
+  std::string source_file;
+  std::vector<std::filesystem::path> includes;
+  sem::ModuleSummary summary;
+  // Only needed to compute the cache key, so only kept when using a cache.
+  std::string token_hash;
+  std::set<std::string> identifiers;
+};
+
+// Compiles the modules one at a time. The first pass parses each module only
+// to summarize it, and the global environment is built from the summaries.
+// The second pass parses each module again, and generates and writes its code
+// before moving on to the next, so that only one module's parse tree and
+// environment are alive at a time.
+status::Status RunStreaming(
+    CompilerFlags const& flags, RunContext const& context,
+    GlobalState const& globals, ToolIncludeContext* include_context,
+    parsers::sci::ParseItemsOptions const& parse_options,
+    std::vector<std::string> const& files,
+    std::vector<sem::ModuleSummary> const& other_summaries,
+    std::vector<std::filesystem::path> const& shared_deps) {
+  auto& out = *context.out;
+  auto& err = *context.err;
+  bool use_cache = !flags.cache_directory.empty();
+
+  std::vector<StreamedModule> modules;
+  for (auto const& file : files) {
+    ASSIGN_OR_RETURN(auto parsed, ParseModule(err, file, include_context,
+                                              globals.defines, parse_options));
+    ASSIGN_OR_RETURN(auto summary, sem::ModuleSummary::Build(
+                                       sem::ItemIndex::Build(parsed.items)));
+    StreamedModule module{
+        .source_file = std::move(parsed.source_file),
+        .includes = std::move(parsed.includes),
+        .summary = std::move(summary),
+    };
+    if (use_cache) {
+      module.token_hash = std::move(parsed.token_hash);
+      module.identifiers = std::move(parsed.identifiers);
+    }
+    modules.push_back(std::move(module));
+  }
+
+  // Generate code in script order, as the non-streaming build does.
+  std::ranges::stable_sort(modules, {}, [](StreamedModule const& module) {
+    return module.summary.script_num;
+  });
+
+  std::vector<sem::ModuleSummary> compiled_summaries;
+  for (auto const& module : modules) {
+    compiled_summaries.push_back(module.summary);
+  }
+  ASSIGN_OR_RETURN(auto env, sem::BuildStreamingCompilationEnvironment(
+                                 flags.codegen_options, globals.items,
+                                 compiled_summaries, other_summaries));
+  compiled_summaries.clear();
+
+  std::optional<CompileCache> compile_cache;
+  if (use_cache) {
+    compile_cache.emplace(flags.cache_directory);
+  }
+
+  for (auto& module : modules) {
+    auto script_num = module.summary.script_num;
+    if (context.output_files) {
+      for (auto const* extension : {"hep", "scr", "sl"}) {
+        context.output_files->push_back(
+            flags.output_directory /
+            absl::StrFormat("%d.%s", script_num.value(), extension));
+      }
+    }
+
+    std::string cache_key;
+    if (compile_cache) {
+      cache_key = ComputeCacheKey(
+          module.token_hash, flags.codegen_options,
+          HashGlobalInterface(env.global_env(), module.identifiers));
+      ASSIGN_OR_RETURN(bool hit,
+                       compile_cache->Fetch(cache_key, flags.output_directory,
+                                            script_num.value()));
+      if (hit) {
+        if (flags.verbose_output) {
+          out << absl::StrFormat("Script %d: cached", script_num.value())
+              << std::endl;
+        }
+        continue;
+      }
+    }
+
+    {
+      ASSIGN_OR_RETURN(auto parsed,
+                       ParseModule(err, module.source_file, include_context,
+                                   globals.defines, parse_options));
+      ASSIGN_OR_RETURN(auto module_env,
+                       env.BuildModuleEnvironment(script_num, parsed.items));
+
+      RETURN_IF_ERROR(sem::BuildCode(module_env.get()));
+
+      auto output_files = CreateOutputFilesForScript(flags.output_directory,
+                                                     script_num.value());
+      auto list_sink = codegen::TextSink::FileTrunc(
+          flags.output_directory /
+          absl::StrFormat("%d.sl", script_num.value()));
+      module_env->codegen()->Assemble("<unknown>", script_num.value(),
+                                      list_sink.get(), output_files.get());
+    }
+
+    // The output files are closed by now, so they can be copied.
+    if (compile_cache) {
+      RETURN_IF_ERROR(compile_cache->Store(cache_key, flags.output_directory,
+                                           script_num.value()));
+    }
+  }
+
+  for (auto const& module : modules) {
+    if (flags.emit_dep_files) {
+      auto deps = ConcatVectors(
+          std::vector<std::filesystem::path>{module.source_file},
+          module.includes, shared_deps);
+      RETURN_IF_ERROR(WriteDepFile(flags.output_directory,
+                                   module.summary.script_num.value(), deps));
+    }
+    if (flags.emit_summaries) {
+      RETURN_IF_ERROR(
+          WriteModuleSummary(flags.output_directory, module.summary));
+    }
+  }
+
+  return status::OkStatus();
+}
+
+status::Status RunMain(const CompilerFlags& flags, RunContext const& context) {
+  auto& out = *context.out;
+  auto& err = *context.err;
+
+  std::vector<std::filesystem::path> include_paths;
+  for (auto include_path_str : flags.include_paths) {
+    include_paths.push_back(std::filesystem::path(include_path_str));
+  }
+
+  ToolIncludeContext include_context(context.loader, std::move(include_paths));
+
+  std::shared_ptr<GlobalState const> globals;
+  if (context.worker_cache) {
+    ASSIGN_OR_RETURN(globals, context.worker_cache->GetGlobals(
+                                  err, flags, &include_context));
+  } else {
+    ASSIGN_OR_RETURN(auto parsed_globals,
+                     ParseGlobals(err, flags, &include_context));
+    globals = std::make_shared<GlobalState const>(std::move(parsed_globals));
+  }
+
+  auto const& global_defines = globals->defines;
+
+  parsers::sci::ParseItemsOptions parse_options{
+      .num_threads = flags.parse_threads,
+  };
+
   sem::Input input;
 
-  input.global_items = std::move(global_items_result).value();
+  input.global_items = globals->items;
+
+  // The global files are shared by every module, so they are part of the
+  // build configuration rather than of any one module.
+  std::vector<std::filesystem::path> global_files;
+  for (auto const& [file, digest] : globals->files) {
+    global_files.push_back(file);
+  }
+
+  // Scripts outside of this process's shard are only summarized, to build
+  // the global environment.
+  std::vector<std::string> files;
+  std::vector<std::string> other_shard_files;
+  std::vector<std::filesystem::path> other_shard_deps;
+  auto in_shard =
+      AssignShard(flags.files, flags.shard_index, flags.shard_count);
+  for (std::size_t i = 0; i < flags.files.size(); ++i) {
+    (in_shard[i] ? files : other_shard_files).push_back(flags.files[i]);
+  }
+
+  // Parses a module. A persistent worker or server reuses the module from an
+  // earlier request if none of its inputs have changed.
+  auto parse_module = [&](std::string const& file)
+      -> status::StatusOr<std::shared_ptr<ParsedModule const>> {
+    if (context.worker_cache) {
+      return context.worker_cache->GetModule(err, file, globals,
+                                             &include_context, parse_options);
+    }
+    ASSIGN_OR_RETURN(auto parsed, ParseModule(err, file, &include_context,
+                                              global_defines, parse_options));
+    return std::make_shared<ParsedModule const>(std::move(parsed));
+  };
+
+  std::vector<sem::ModuleSummary> flag_summaries;
+  for (auto const& summary_file : flags.summary_files) {
+    ASSIGN_OR_RETURN(auto summary, LoadModuleSummary(summary_file));
+    flag_summaries.push_back(std::move(summary));
+  }
+  for (auto const& file : other_shard_files) {
+    ASSIGN_OR_RETURN(auto parsed, parse_module(file));
+    ASSIGN_OR_RETURN(auto summary, sem::ModuleSummary::Build(
+                                       sem::ItemIndex::Build(parsed->items)));
+    flag_summaries.push_back(std::move(summary));
+    other_shard_deps.push_back(file);
+    std::ranges::copy(parsed->includes, std::back_inserter(other_shard_deps));
+  }
+
+  if (flags.stream) {
+    return RunStreaming(flags, context, *globals, &include_context,
+                        parse_options, files, flag_summaries,
+                        SharedDeps(flags, global_files, other_shard_deps));
+  }
+
+  // In incremental mode, modules whose inputs are unchanged since the last
+  // build are not parsed. Their summaries from the last build stand in for
+  // them in the global environment.
+  BuildManifest manifest;
+  std::string config_hash;
+  // Each shard keeps its own manifest, so that concurrent shards don't
+  // overwrite each other's.
+  auto manifest_path = flags.output_directory / BuildManifest::kFileName;
+  if (flags.shard_count > 1) {
+    manifest_path += absl::StrFormat(".%dof%d", flags.shard_index,
+                                     flags.shard_count);
+  }
+  if (flags.incremental) {
+    ASSIGN_OR_RETURN(config_hash, HashBuildConfig(flags, global_files));
+    ASSIGN_OR_RETURN(manifest, BuildManifest::Load(manifest_path));
+  }
+
+  RebuildPlan plan;
+  if (flags.incremental) {
+    ASSIGN_OR_RETURN(plan, PlanRebuild(manifest, config_hash, files,
+                                       flags.output_directory));
+  } else {
+    plan.dirty_files = files;
+  }
+
+  sem::CompilationEnvironmentOptions env_options{
+      .num_threads = flags.env_threads,
+  };
+
+  // Builds the compilation environment from the dirty modules, parsing any
+  // that haven't been parsed yet, and the summaries of the clean ones.
+  std::map<std::string, std::shared_ptr<ParsedModule const>> parsed_by_file;
+  std::vector<std::shared_ptr<ParsedModule const>> parsed_modules;
+  std::optional<sem::CompilationEnvironment> compilation_env;
+  auto build_env = [&]() -> status::Status {
+    parsed_modules.clear();
+    for (auto const& file : plan.dirty_files) {
+      auto it = parsed_by_file.find(file);
+      if (it == parsed_by_file.end()) {
+        ASSIGN_OR_RETURN(auto parsed, parse_module(file));
+        it = parsed_by_file.emplace(file, std::move(parsed)).first;
+      }
+      parsed_modules.push_back(it->second);
+    }
 
-  for (auto& source_tokens : source_file_tokens) {
-    parsers::list_tree::Parser source_parser(&include_context);
-    for (auto const& entry : global_defines) {
-      source_parser.AddDefine(entry.first, entry.second);
+    input.modules.clear();
+    for (auto const& parsed : parsed_modules) {
+      input.modules.push_back(sem::Input::Module{
+          .module_items = parsed->items,
+      });
+    }
+    input.module_summaries = flag_summaries;
+    for (auto const& [file, summary] : plan.clean_summaries) {
+      input.module_summaries.push_back(summary);
     }
 
-    ASSIGN_OR_RETURN(auto source_list_tree,
-                     source_parser.ParseTree(std::move(source_tokens)));
+    ASSIGN_OR_RETURN(auto env,
+                     sem::BuildCompilationEnvironment(flags.codegen_options,
+                                                      input, env_options));
+    compilation_env.emplace(std::move(env));
+    return status::OkStatus();
+  };
 
-    auto source_items_result = parsers::sci::ParseItems(source_list_tree);
+  RETURN_IF_ERROR(build_env());
 
-    if (!source_items_result.ok()) {
-      std::cerr << source_items_result.status() << std::endl;
-      return status::FailedPreconditionError("Failed to parse source items");
+  // A module whose inputs are unchanged still has to be rebuilt if what its
+  // identifiers refer to in the global environment has changed. Finding that
+  // out requires the new environment, so those modules are parsed and the
+  // environment is built again. Their summaries match their sources, and
+  // numbering doesn't depend on which modules are summarized, so the global
+  // environment comes out the same and no further modules can go stale.
+  if (flags.incremental &&
+      MarkStaleModules(manifest, compilation_env->global_env(), files,
+                       &plan)) {
+    RETURN_IF_ERROR(build_env());
+  }
+
+  if (flags.incremental) {
+    for (auto const& file : plan.dirty_files) {
+      out << absl::StrFormat("Rebuilding %s: %s", file,
+                             plan.rebuild_reasons.at(file))
+          << std::endl;
+    }
+    if (flags.verbose_output) {
+      for (auto const& [file, summary] : plan.clean_summaries) {
+        out << absl::StrFormat("Up to date: %s", file) << std::endl;
+      }
     }
+  }
 
-    input.modules.push_back(sem::Input::Module{
-        .module_items = std::move(source_items_result).value(),
-    });
+  std::vector<sem::ModuleSummary> parsed_summaries;
+  for (auto const& parsed : parsed_modules) {
+    ASSIGN_OR_RETURN(auto summary, sem::ModuleSummary::Build(
+                                       sem::ItemIndex::Build(parsed->items)));
+    parsed_summaries.push_back(std::move(summary));
   }
 
-  ASSIGN_OR_RETURN(auto compilation_env, sem::BuildCompilationEnvironment(
-                                             flags.codegen_options, input));
+  // With a cache, modules whose outputs are already in the cache are copied
+  // from there rather than generated.
+  std::optional<CompileCache> compile_cache;
+  std::map<sem::ScriptNum, std::string> cache_keys;
+  std::set<sem::ScriptNum> cached_scripts;
+  if (!flags.cache_directory.empty()) {
+    compile_cache.emplace(flags.cache_directory);
+    for (std::size_t i = 0; i < parsed_modules.size(); ++i) {
+      auto script_num = parsed_summaries[i].script_num;
+      auto key = ComputeCacheKey(
+          parsed_modules[i]->token_hash, flags.codegen_options,
+          HashGlobalInterface(compilation_env->global_env(),
+                              parsed_modules[i]->identifiers));
+      ASSIGN_OR_RETURN(bool hit,
+                       compile_cache->Fetch(key, flags.output_directory,
+                                            script_num.value()));
+      if (hit) {
+        cached_scripts.insert(script_num);
+      }
+      cache_keys.emplace(script_num, std::move(key));
+    }
+  }
 
   // Perform code generation.
-  for (auto const* module : compilation_env.module_envs()) {
+  for (auto const* module : compilation_env->module_envs()) {
+    if (cached_scripts.contains(module->script_num())) {
+      continue;
+    }
     RETURN_IF_ERROR(sem::BuildCode(module));
   }
 
-  for (auto const* module : compilation_env.module_envs()) {
-    auto output_files = CreateOutputFilesForScript(
-        flags.output_directory, module->script_num().value());
+  for (auto const* module : compilation_env->module_envs()) {
+    if (context.output_files) {
+      for (auto const* extension : {"hep", "scr", "sl"}) {
+        context.output_files->push_back(
+            flags.output_directory /
+            absl::StrFormat("%d.%s", module->script_num().value(), extension));
+      }
+    }
+
+    if (cached_scripts.contains(module->script_num())) {
+      if (flags.verbose_output) {
+        out << absl::StrFormat("Script %d: cached",
+                               module->script_num().value())
+            << std::endl;
+      }
+      continue;
+    }
+
+    {
+      auto output_files = CreateOutputFilesForScript(
+          flags.output_directory, module->script_num().value());
+
+      auto list_sink = codegen::TextSink::FileTrunc(
+          flags.output_directory /
+          absl::StrFormat("%d.sl", module->script_num().value()));
+
+      module->codegen()->Assemble("<unknown>", module->script_num().value(),
+                                  list_sink.get(), output_files.get());
+    }
 
-    auto list_sink = codegen::TextSink::FileTrunc(
-        flags.output_directory /
-        absl::StrFormat("%d.sl", module->script_num().value()));
+    // The output files are closed by now, so they can be copied.
+    if (compile_cache) {
+      RETURN_IF_ERROR(compile_cache->Store(cache_keys.at(module->script_num()),
+                                           flags.output_directory,
+                                           module->script_num().value()));
+    }
+  }
 
-    module->codegen()->Assemble("<unknown>", module->script_num().value(),
-                                list_sink.get(), output_files.get());
+  if (flags.emit_dep_files) {
+    // Every module depends on the global files and on the modules not being
+    // compiled, as well as on its own source and includes.
+    auto shared_deps = SharedDeps(flags, global_files, other_shard_deps);
+    for (std::size_t i = 0; i < parsed_modules.size(); ++i) {
+      auto const& parsed = *parsed_modules[i];
+      auto deps = ConcatVectors(
+          std::vector<std::filesystem::path>{parsed.source_file},
+          parsed.includes, shared_deps);
+      RETURN_IF_ERROR(WriteDepFile(flags.output_directory,
+                                   parsed_summaries[i].script_num.value(),
+                                   deps));
+    }
+  }
+
+  if (!flags.emit_summaries && !flags.incremental) {
+    return status::OkStatus();
+  }
+
+  manifest.config_hash = config_hash;
+  for (std::size_t i = 0; i < parsed_modules.size(); ++i) {
+    auto const& parsed = *parsed_modules[i];
+    auto const& summary = parsed_summaries[i];
+    RETURN_IF_ERROR(WriteModuleSummary(flags.output_directory, summary));
+
+    if (flags.incremental) {
+      ModuleBuildState module_state{
+          .script_num = summary.script_num.value(),
+          .source_hash = parsed.source_hash,
+          .identifiers = parsed.identifiers,
+          .interface_hash = HashGlobalInterface(
+              compilation_env->global_env(), parsed.identifiers),
+      };
+      for (auto const& include : parsed.includes) {
+        ASSIGN_OR_RETURN(auto include_hash, HashFile(include));
+        module_state.include_hashes.emplace(include.string(),
+                                            std::move(include_hash));
+      }
+      manifest.modules[parsed.source_file] = std::move(module_state);
+    }
+  }
+
+  if (flags.incremental) {
+    RETURN_IF_ERROR(manifest.Save(manifest_path));
   }
 
   return status::OkStatus();
 }
 
+// Runs a single compilation for a persistent worker or compile server,
+// returning its exit code.
+int RunWorkRequest(WorkRequest const& request, WorkerCache* cache,
+                   std::ostream& out,
+                   std::vector<std::filesystem::path>* output_files = nullptr) {
+  std::vector<std::string> args = {"scic"};
+  args.insert(args.end(), request.arguments.begin(), request.arguments.end());
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(arg.data());
+  }
+
+  CompilerFlags flags;
+  try {
+    flags = ExtractFlags(argv.size(), argv.data(), FlagSource::WORK_REQUEST);
+  } catch (const std::exception& err) {
+    out << err.what() << std::endl;
+    return 1;
+  }
+
+  std::map<std::filesystem::path, std::string> digests;
+  for (auto const& input : request.inputs) {
+    if (!input.digest.empty()) {
+      digests.emplace(input.path, input.digest);
+    }
+  }
+  WorkerSourceLoader loader(cache, std::move(digests));
+
+  auto status = RunMain(flags, RunContext{
+                                   .out = &out,
+                                   .err = &out,
+                                   .loader = &loader,
+                                   .worker_cache = cache,
+                                   .output_files = output_files,
+                               });
+  if (!status.ok()) {
+    out << status << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Serves work requests from Bazel over stdin and stdout until stdin is
+// closed. Multiplex requests (those with a nonzero id) run in parallel on a
+// fixed pool of `num_threads` threads, and wait in a queue while every
+// thread is busy.
+int RunPersistentWorker(std::size_t num_threads) {
+  WorkerCache cache;
+  std::mutex response_mutex;
+
+  auto handle_request = [&](WorkRequest request) {
+    std::ostringstream output;
+    int exit_code = RunWorkRequest(request, &cache, output);
+    auto response = SerializeWorkResponse(WorkResponse{
+        .exit_code = exit_code,
+        .output = output.str(),
+        .request_id = request.request_id,
+    });
+    std::scoped_lock lock(response_mutex);
+    std::cout << response << std::endl;
+  };
+
+  std::mutex queue_mutex;
+  std::condition_variable queue_ready;
+  std::deque<WorkRequest> queue;
+  bool closed = false;
+
+  auto worker = [&] {
+    while (true) {
+      WorkRequest request;
+      {
+        std::unique_lock lock(queue_mutex);
+        queue_ready.wait(lock, [&] { return closed || !queue.empty(); });
+        if (queue.empty()) {
+          return;
+        }
+        request = std::move(queue.front());
+        queue.pop_front();
+      }
+      handle_request(std::move(request));
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  int exit_code = 0;
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    auto request = ParseWorkRequest(line);
+    if (!request.ok()) {
+      std::cerr << request.status() << std::endl;
+      exit_code = 1;
+      break;
+    }
+
+    // Cancellation isn't supported, so Bazel won't send cancel requests.
+    if (request->cancel) {
+      continue;
+    }
+
+    if (request->request_id == 0) {
+      handle_request(std::move(request).value());
+    } else {
+      std::scoped_lock lock(queue_mutex);
+      queue.push_back(std::move(request).value());
+      queue_ready.notify_one();
+    }
+  }
+
+  // Finish the queued requests before exiting.
+  {
+    std::scoped_lock lock(queue_mutex);
+    closed = true;
+  }
+  queue_ready.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return exit_code;
+}
+
+// Handles the requests on one compile server connection until the client
+// disconnects.
+void ServeConnection(LocalConnection* connection, WorkerCache* cache,
+                     std::filesystem::path const& working_directory) {
+  while (true) {
+    auto line = connection->ReadLine();
+    if (!line.ok()) {
+      return;
+    }
+
+    WorkResponse response;
+    std::ostringstream output;
+    auto request = ParseWorkRequest(line.value());
+    if (!request.ok()) {
+      output << request.status() << std::endl;
+      response.exit_code = 1;
+    } else if (!request->working_directory.empty() &&
+               std::filesystem::path(request->working_directory) !=
+                   working_directory) {
+      // Relative paths in the arguments would resolve differently here.
+      output << absl::StrFormat(
+                    "The server is running in %s, but the client is in %s",
+                    working_directory, request->working_directory)
+             << std::endl;
+      response.exit_code = 1;
+    } else {
+      std::vector<std::filesystem::path> output_files;
+      response.request_id = request->request_id;
+      response.exit_code =
+          RunWorkRequest(request.value(), cache, output, &output_files);
+      for (auto const& output_file : output_files) {
+        response.output_files.push_back(output_file.string());
+      }
+    }
+    response.output = output.str();
+
+    if (!connection->WriteLine(SerializeWorkResponse(response)).ok()) {
+      return;
+    }
+  }
+}
+
+// Serves compile requests on a local socket until the process is killed.
+// Requests use the same messages as the persistent worker, and connections
+// are handled in parallel.
+int RunCompileServer(std::filesystem::path const& socket_path) {
+  auto listener = LocalListener::Listen(socket_path);
+  if (!listener.ok()) {
+    std::cerr << listener.status() << std::endl;
+    return 1;
+  }
+  std::cout << absl::StrFormat("Listening on %s", socket_path) << std::endl;
+
+  WorkerCache cache;
+  auto working_directory = std::filesystem::current_path();
+  std::list<std::future<void>> pending;
+  while (true) {
+    auto connection = listener.value()->Accept();
+    if (!connection.ok()) {
+      std::cerr << connection.status() << std::endl;
+      return 1;
+    }
+
+    std::erase_if(pending, [](std::future<void> const& future) {
+      return future.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready;
+    });
+
+    pending.push_back(std::async(
+        std::launch::async,
+        [&cache, &working_directory](
+            std::unique_ptr<LocalConnection> connection) {
+          ServeConnection(connection.get(), &cache, working_directory);
+        },
+        std::move(connection).value()));
+  }
+}
+
+// Sends a compile request to a server. Diagnostics are written to stderr,
+// and the generated files to stdout, one per line.
+int RunCompileClient(std::filesystem::path const& socket_path,
+                     std::vector<std::string> arguments) {
+  auto connection = LocalConnection::Connect(socket_path);
+  if (!connection.ok()) {
+    std::cerr << connection.status() << std::endl;
+    return 1;
+  }
+
+  WorkRequest request{
+      .arguments = std::move(arguments),
+      .working_directory = std::filesystem::current_path().string(),
+  };
+  auto status =
+      connection.value()->WriteLine(SerializeWorkRequest(request));
+  if (!status.ok()) {
+    std::cerr << status << std::endl;
+    return 1;
+  }
+
+  auto line = connection.value()->ReadLine();
+  if (!line.ok()) {
+    std::cerr << line.status() << std::endl;
+    return 1;
+  }
+  auto response = ParseWorkResponse(line.value());
+  if (!response.ok()) {
+    std::cerr << response.status() << std::endl;
+    return 1;
+  }
+
+  std::cerr << response->output;
+  for (auto const& output_file : response->output_files) {
+    std::cout << output_file << std::endl;
+  }
+  return response->exit_code;
+}
+
+// Returns whether the file is one the compiler writes, so that the compiler's
+// own output doesn't trigger rebuilds when it is in a watched directory.
+bool IsCompilerOutput(std::filesystem::path const& path) {
+  static constexpr std::string_view kOutputExtensions[] = {
+      ".hep", ".scr", ".sl", ".sum", ".d", ".tmp"};
+  auto extension = path.extension().string();
+  return std::ranges::find(kOutputExtensions, extension) !=
+             std::end(kOutputExtensions) ||
+         path.filename().string().starts_with(BuildManifest::kFileName);
+}
+
+// Compiles, then recompiles whenever a source file, include, or global
+// header changes, until the process is killed. Parsed files are kept in
+// memory between builds, so only changed files are parsed again.
+int RunWatch(CompilerFlags const& flags) {
+  // Editors often write several files, or one file several times, when
+  // saving. Wait for changes to settle before rebuilding.
+  constexpr std::chrono::milliseconds kDebounce{100};
+
+  WorkerCache cache;
+  // With no digests, files are loaded from disk and hashed each build, so
+  // cached state is only reused for files whose contents are unchanged.
+  WorkerSourceLoader loader(&cache, {});
+
+  auto build = [&] {
+    auto start = std::chrono::steady_clock::now();
+    auto status = RunMain(flags, RunContext{
+                                     .out = &std::cout,
+                                     .err = &std::cerr,
+                                     .loader = &loader,
+                                     .worker_cache = &cache,
+                                 });
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (!status.ok()) {
+      std::cerr << status << std::endl;
+    }
+    std::cout << absl::StrFormat("Build %s in %d ms",
+                                 status.ok() ? "succeeded" : "failed",
+                                 elapsed.count())
+              << std::endl;
+  };
+
+  std::set<std::filesystem::path> directories;
+  auto add_directory = [&](std::filesystem::path const& file) {
+    auto directory = file.parent_path();
+    directories.insert(directory.empty() ? std::filesystem::path(".")
+                                         : directory);
+  };
+  for (auto const& file : flags.files) {
+    add_directory(file);
+  }
+  for (auto const& file : flags.global_includes) {
+    add_directory(file);
+  }
+  for (auto const& include_path : flags.include_paths) {
+    directories.insert(include_path);
+  }
+
+  auto watcher = FileWatcher::Create(
+      std::vector<std::filesystem::path>(directories.begin(),
+                                         directories.end()));
+  if (!watcher.ok()) {
+    std::cerr << watcher.status() << std::endl;
+    return 1;
+  }
+
+  build();
+  while (true) {
+    std::set<std::filesystem::path> changes;
+    auto add_changes = [&](std::vector<std::filesystem::path> const& paths) {
+      for (auto const& path : paths) {
+        if (!IsCompilerOutput(path)) {
+          changes.insert(path);
+        }
+      }
+    };
+
+    while (changes.empty()) {
+      auto paths = watcher.value()->WaitForChanges(std::nullopt);
+      if (!paths.ok()) {
+        std::cerr << paths.status() << std::endl;
+        return 1;
+      }
+      add_changes(paths.value());
+    }
+
+    while (true) {
+      auto paths = watcher.value()->WaitForChanges(kDebounce);
+      if (!paths.ok()) {
+        std::cerr << paths.status() << std::endl;
+        return 1;
+      }
+      if (paths->empty()) {
+        break;
+      }
+      add_changes(paths.value());
+    }
+
+    for (auto const& path : changes) {
+      std::cout << absl::StrFormat("Changed: %s", path) << std::endl;
+    }
+    build();
+  }
+}
+
 }  // namespace frontend
 
 int main(int argc, char** argv) {
@@ -275,6 +1412,45 @@ int main(int argc, char** argv) {
   absl::FailureSignalHandlerOptions options;
   absl::InstallFailureSignalHandler(options);
 
+  // A persistent worker takes its compile flags from each request. Only the
+  // size of its thread pool is given on the command line.
+  bool persistent_worker = false;
+  std::size_t worker_threads = std::thread::hardware_concurrency();
+  if (worker_threads == 0) {
+    worker_threads = 1;
+  }
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--persistent_worker") {
+      persistent_worker = true;
+    } else if (arg.starts_with("--worker_threads=")) {
+      auto value = arg.substr(17);
+      auto result = std::from_chars(value.data(), value.data() + value.size(),
+                                    worker_threads);
+      if (result.ec != std::errc() ||
+          result.ptr != value.data() + value.size() || worker_threads == 0) {
+        std::cerr << "Invalid --worker_threads: expected a positive number"
+                  << std::endl;
+        return 1;
+      }
+    }
+  }
+  if (persistent_worker) {
+    return frontend::RunPersistentWorker(worker_threads);
+  }
+
+  // The compile server and client take over the command line.
+  if (argc >= 2) {
+    std::string_view mode = argv[1];
+    if (mode.starts_with("--serve=")) {
+      return frontend::RunCompileServer(mode.substr(8));
+    }
+    if (mode.starts_with("--client=")) {
+      return frontend::RunCompileClient(
+          mode.substr(9), std::vector<std::string>(argv + 2, argv + argc));
+    }
+  }
+
   frontend::CompilerFlags flags;
   try {
     flags = frontend::ExtractFlags(argc, argv);
@@ -282,7 +1458,16 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  auto status = frontend::RunMain(flags);
+  if (flags.watch) {
+    return frontend::RunWatch(flags);
+  }
+
+  frontend::DiskSourceLoader loader;
+  auto status = frontend::RunMain(flags, frontend::RunContext{
+                                             .out = &std::cout,
+                                             .err = &std::cerr,
+                                             .loader = &loader,
+                                         });
   if (!status.ok()) {
     std::cerr << status << std::endl;
     return 1;
@@ -0,0 +1,451 @@
+#include "scic/frontend/worker_protocol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "scic/status/status.hpp"
+#include "util/status/status_macros.hpp"
+
+namespace frontend {
+namespace {
+
+// A minimal JSON reader, covering what the worker protocol needs. Values
+// that aren't needed are validated and skipped.
+class JsonReader {
+ public:
+  explicit JsonReader(std::string_view input) : input_(input) {}
+
+  status::Status ExpectEnd() {
+    SkipWhitespace();
+    if (pos_ != input_.size()) {
+      return Error("unexpected trailing characters");
+    }
+    return status::OkStatus();
+  }
+
+  // Reads an object, calling `on_field(key)` for each field. The callback
+  // must consume the field's value.
+  template <class F>
+  status::Status ReadObject(F&& on_field) {
+    RETURN_IF_ERROR(Expect('{'));
+    if (Consume('}')) {
+      return status::OkStatus();
+    }
+    do {
+      ASSIGN_OR_RETURN(auto key, ReadString());
+      RETURN_IF_ERROR(Expect(':'));
+      RETURN_IF_ERROR(on_field(key));
+    } while (Consume(','));
+    return Expect('}');
+  }
+
+  // Reads an array, calling `on_element()` for each element. The callback
+  // must consume the element.
+  template <class F>
+  status::Status ReadArray(F&& on_element) {
+    RETURN_IF_ERROR(Expect('['));
+    if (Consume(']')) {
+      return status::OkStatus();
+    }
+    do {
+      RETURN_IF_ERROR(on_element());
+    } while (Consume(','));
+    return Expect(']');
+  }
+
+  status::StatusOr<std::string> ReadString() {
+    RETURN_IF_ERROR(Expect('"'));
+    std::string result;
+    while (true) {
+      if (pos_ >= input_.size()) {
+        return Error("unterminated string");
+      }
+      char c = input_[pos_++];
+      if (c == '"') {
+        return result;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return Error("control character in string");
+      }
+      if (c != '\\') {
+        result.push_back(c);
+        continue;
+      }
+      if (pos_ >= input_.size()) {
+        return Error("unterminated string");
+      }
+      char escape = input_[pos_++];
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          result.push_back(escape);
+          break;
+        case 'b':
+          result.push_back('\b');
+          break;
+        case 'f':
+          result.push_back('\f');
+          break;
+        case 'n':
+          result.push_back('\n');
+          break;
+        case 'r':
+          result.push_back('\r');
+          break;
+        case 't':
+          result.push_back('\t');
+          break;
+        case 'u': {
+          ASSIGN_OR_RETURN(auto code_point, ReadCodePoint());
+          AppendUtf8(code_point, &result);
+          break;
+        }
+        default:
+          return Error("invalid escape sequence");
+      }
+    }
+  }
+
+  status::StatusOr<int> ReadInt() {
+    SkipWhitespace();
+    bool negative = Consume('-');
+    std::int64_t value = 0;
+    std::size_t start = pos_;
+    while (pos_ < input_.size() && input_[pos_] >= '0' &&
+           input_[pos_] <= '9') {
+      value = value * 10 + (input_[pos_++] - '0');
+      if (value > INT32_MAX) {
+        return Error("integer out of range");
+      }
+    }
+    if (pos_ == start) {
+      return Error("expected an integer");
+    }
+    return int(negative ? -value : value);
+  }
+
+  status::StatusOr<bool> ReadBool() {
+    SkipWhitespace();
+    if (ConsumeWord("true")) {
+      return true;
+    }
+    if (ConsumeWord("false")) {
+      return false;
+    }
+    return Error("expected a boolean");
+  }
+
+  // Skips over a value of any type.
+  status::Status SkipValue() {
+    SkipWhitespace();
+    if (pos_ >= input_.size()) {
+      return Error("expected a value");
+    }
+    switch (input_[pos_]) {
+      case '{':
+        return ReadObject([&](std::string_view) { return SkipValue(); });
+      case '[':
+        return ReadArray([&] { return SkipValue(); });
+      case '"': {
+        auto result = ReadString();
+        return result.ok() ? status::OkStatus() : result.status();
+      }
+      case 't':
+      case 'f': {
+        auto result = ReadBool();
+        return result.ok() ? status::OkStatus() : result.status();
+      }
+      case 'n':
+        if (ConsumeWord("null")) {
+          return status::OkStatus();
+        }
+        return Error("expected a value");
+      default:
+        return SkipNumber();
+    }
+  }
+
+ private:
+  status::Status Error(std::string_view message) const {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Invalid JSON at offset %d: %s", pos_, message));
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < input_.size() &&
+           (input_[pos_] == ' ' || input_[pos_] == '\t' ||
+            input_[pos_] == '\n' || input_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ < input_.size() && input_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeWord(std::string_view word) {
+    if (input_.substr(pos_, word.size()) == word) {
+      pos_ += word.size();
+      return true;
+    }
+    return false;
+  }
+
+  status::Status Expect(char c) {
+    if (!Consume(c)) {
+      return Error(absl::StrFormat("expected '%c'", c));
+    }
+    return status::OkStatus();
+  }
+
+  status::Status SkipNumber() {
+    std::size_t start = pos_;
+    while (pos_ < input_.size() &&
+           std::string_view("+-.eE0123456789").find(input_[pos_]) !=
+               std::string_view::npos) {
+      ++pos_;
+    }
+    if (pos_ == start) {
+      return Error("expected a value");
+    }
+    return status::OkStatus();
+  }
+
+  status::StatusOr<std::uint32_t> ReadHex4() {
+    if (pos_ + 4 > input_.size()) {
+      return Error("truncated unicode escape");
+    }
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = input_[pos_++];
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        value |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        value |= c - 'A' + 10;
+      } else {
+        return Error("invalid unicode escape");
+      }
+    }
+    return value;
+  }
+
+  // Reads the rest of a \u escape, including the second half of a surrogate
+  // pair.
+  status::StatusOr<std::uint32_t> ReadCodePoint() {
+    ASSIGN_OR_RETURN(auto high, ReadHex4());
+    if (high < 0xD800 || high > 0xDBFF) {
+      return high;
+    }
+    if (!ConsumeWord("\\u")) {
+      return Error("unpaired surrogate");
+    }
+    ASSIGN_OR_RETURN(auto low, ReadHex4());
+    if (low < 0xDC00 || low > 0xDFFF) {
+      return Error("unpaired surrogate");
+    }
+    return 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+  }
+
+  static void AppendUtf8(std::uint32_t code_point, std::string* out) {
+    if (code_point < 0x80) {
+      out->push_back(char(code_point));
+    } else if (code_point < 0x800) {
+      out->push_back(char(0xC0 | (code_point >> 6)));
+      out->push_back(char(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+      out->push_back(char(0xE0 | (code_point >> 12)));
+      out->push_back(char(0x80 | ((code_point >> 6) & 0x3F)));
+      out->push_back(char(0x80 | (code_point & 0x3F)));
+    } else {
+      out->push_back(char(0xF0 | (code_point >> 18)));
+      out->push_back(char(0x80 | ((code_point >> 12) & 0x3F)));
+      out->push_back(char(0x80 | ((code_point >> 6) & 0x3F)));
+      out->push_back(char(0x80 | (code_point & 0x3F)));
+    }
+  }
+
+  std::string_view input_;
+  std::size_t pos_ = 0;
+};
+
+void AppendJsonString(std::string_view value, std::string* out) {
+  out->push_back('"');
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out->append(absl::StrFormat("\\u%04x", int(c)));
+        } else {
+          out->push_back(c);
+        }
+    }
+  }
+  out->push_back('"');
+}
+
+}  // namespace
+
+status::StatusOr<WorkRequest> ParseWorkRequest(std::string_view json) {
+  JsonReader reader(json);
+  WorkRequest request;
+
+  auto read_input = [&]() -> status::Status {
+    WorkRequest::Input input;
+    RETURN_IF_ERROR(
+        reader.ReadObject([&](std::string_view key) -> status::Status {
+          if (key == "path") {
+            ASSIGN_OR_RETURN(input.path, reader.ReadString());
+          } else if (key == "digest") {
+            ASSIGN_OR_RETURN(input.digest, reader.ReadString());
+          } else {
+            RETURN_IF_ERROR(reader.SkipValue());
+          }
+          return status::OkStatus();
+        }));
+    request.inputs.push_back(std::move(input));
+    return status::OkStatus();
+  };
+
+  auto read_argument = [&]() -> status::Status {
+    ASSIGN_OR_RETURN(auto argument, reader.ReadString());
+    request.arguments.push_back(std::move(argument));
+    return status::OkStatus();
+  };
+
+  RETURN_IF_ERROR(
+      reader.ReadObject([&](std::string_view key) -> status::Status {
+        if (key == "arguments") {
+          RETURN_IF_ERROR(reader.ReadArray(read_argument));
+        } else if (key == "inputs") {
+          RETURN_IF_ERROR(reader.ReadArray(read_input));
+        } else if (key == "requestId") {
+          ASSIGN_OR_RETURN(request.request_id, reader.ReadInt());
+        } else if (key == "cancel") {
+          ASSIGN_OR_RETURN(request.cancel, reader.ReadBool());
+        } else if (key == "workingDirectory") {
+          ASSIGN_OR_RETURN(request.working_directory, reader.ReadString());
+        } else {
+          RETURN_IF_ERROR(reader.SkipValue());
+        }
+        return status::OkStatus();
+      }));
+  RETURN_IF_ERROR(reader.ExpectEnd());
+  return request;
+}
+
+status::StatusOr<WorkResponse> ParseWorkResponse(std::string_view json) {
+  JsonReader reader(json);
+  WorkResponse response;
+
+  auto read_output_file = [&]() -> status::Status {
+    ASSIGN_OR_RETURN(auto output_file, reader.ReadString());
+    response.output_files.push_back(std::move(output_file));
+    return status::OkStatus();
+  };
+
+  RETURN_IF_ERROR(
+      reader.ReadObject([&](std::string_view key) -> status::Status {
+        if (key == "exitCode") {
+          ASSIGN_OR_RETURN(response.exit_code, reader.ReadInt());
+        } else if (key == "output") {
+          ASSIGN_OR_RETURN(response.output, reader.ReadString());
+        } else if (key == "requestId") {
+          ASSIGN_OR_RETURN(response.request_id, reader.ReadInt());
+        } else if (key == "outputFiles") {
+          RETURN_IF_ERROR(reader.ReadArray(read_output_file));
+        } else {
+          RETURN_IF_ERROR(reader.SkipValue());
+        }
+        return status::OkStatus();
+      }));
+  RETURN_IF_ERROR(reader.ExpectEnd());
+  return response;
+}
+
+std::string SerializeWorkRequest(WorkRequest const& request) {
+  std::string result = "{\"arguments\":[";
+  for (std::size_t i = 0; i < request.arguments.size(); ++i) {
+    if (i > 0) {
+      result.push_back(',');
+    }
+    AppendJsonString(request.arguments[i], &result);
+  }
+  result.push_back(']');
+  if (!request.inputs.empty()) {
+    result.append(",\"inputs\":[");
+    for (std::size_t i = 0; i < request.inputs.size(); ++i) {
+      if (i > 0) {
+        result.push_back(',');
+      }
+      result.append("{\"path\":");
+      AppendJsonString(request.inputs[i].path, &result);
+      result.append(",\"digest\":");
+      AppendJsonString(request.inputs[i].digest, &result);
+      result.push_back('}');
+    }
+    result.push_back(']');
+  }
+  if (request.request_id != 0) {
+    absl::StrAppendFormat(&result, ",\"requestId\":%d", request.request_id);
+  }
+  if (request.cancel) {
+    result.append(",\"cancel\":true");
+  }
+  if (!request.working_directory.empty()) {
+    result.append(",\"workingDirectory\":");
+    AppendJsonString(request.working_directory, &result);
+  }
+  result.push_back('}');
+  return result;
+}
+
+std::string SerializeWorkResponse(WorkResponse const& response) {
+  std::string result = absl::StrFormat("{\"exitCode\":%d,\"output\":",
+                                       response.exit_code);
+  AppendJsonString(response.output, &result);
+  absl::StrAppendFormat(&result, ",\"requestId\":%d", response.request_id);
+  if (!response.output_files.empty()) {
+    result.append(",\"outputFiles\":[");
+    for (std::size_t i = 0; i < response.output_files.size(); ++i) {
+      if (i > 0) {
+        result.push_back(',');
+      }
+      AppendJsonString(response.output_files[i], &result);
+    }
+    result.push_back(']');
+  }
+  result.push_back('}');
+  return result;
+}
+
+}  // namespace frontend
@@ -0,0 +1,56 @@
+#ifndef FRONTEND_WORKER_PROTOCOL_HPP
+#define FRONTEND_WORKER_PROTOCOL_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scic/status/status.hpp"
+
+namespace frontend {
+
+// The messages of Bazel's persistent worker protocol, in its JSON form. Each
+// message is a single line of JSON. The compile server (--serve) speaks the
+// same protocol over a local socket, with a few extra fields Bazel doesn't
+// use.
+//
+// See https://bazel.build/remote/persistent for the protocol.
+
+struct WorkRequest {
+  struct Input {
+    std::string path;
+    // An opaque digest of the file's contents, if Bazel provided one.
+    std::string digest;
+  };
+
+  std::vector<std::string> arguments;
+  std::vector<Input> inputs;
+  // Zero for singleplex requests. Multiplex requests have distinct ids.
+  int request_id = 0;
+  bool cancel = false;
+  // The client's working directory, for compile server requests. Relative
+  // paths in the arguments are relative to it.
+  std::string working_directory;
+};
+
+struct WorkResponse {
+  int exit_code = 0;
+  std::string output;
+  int request_id = 0;
+  // The files written by the compilation, for compile server responses.
+  std::vector<std::string> output_files = {};
+};
+
+// Parses a work request. Fields that scic doesn't use are ignored.
+status::StatusOr<WorkRequest> ParseWorkRequest(std::string_view json);
+
+// Serializes a work request or response, without a trailing newline. Fields
+// with default values are left out.
+std::string SerializeWorkRequest(WorkRequest const& request);
+std::string SerializeWorkResponse(WorkResponse const& response);
+
+status::StatusOr<WorkResponse> ParseWorkResponse(std::string_view json);
+
+}  // namespace frontend
+
+#endif
@@ -0,0 +1,88 @@
+#include "scic/frontend/worker_protocol.hpp"
+
+#include "gtest/gtest.h"
+
+namespace frontend {
+namespace {
+
+TEST(WorkerProtocolTest, ParsesRequest) {
+  auto request = ParseWorkRequest(
+      R"({"arguments": ["-o", "out", "main.sc"],)"
+      R"( "inputs": [{"path": "main.sc", "digest": "abc="},)"
+      R"(            {"digest": "def=", "path": "game.sh"}],)"
+      R"( "requestId": 12})");
+  ASSERT_TRUE(request.ok());
+  ASSERT_EQ(request->arguments.size(), 3);
+  EXPECT_EQ(request->arguments[2], "main.sc");
+  ASSERT_EQ(request->inputs.size(), 2);
+  EXPECT_EQ(request->inputs[1].path, "game.sh");
+  EXPECT_EQ(request->inputs[1].digest, "def=");
+  EXPECT_EQ(request->request_id, 12);
+  EXPECT_FALSE(request->cancel);
+}
+
+TEST(WorkerProtocolTest, IgnoresUnknownFields) {
+  auto request = ParseWorkRequest(
+      R"({"verbosity": 10, "sandboxDir": "", "extra": {"a": [1.5e3, null]},)"
+      R"( "cancel": true, "arguments": []})");
+  ASSERT_TRUE(request.ok());
+  EXPECT_TRUE(request->arguments.empty());
+  EXPECT_EQ(request->request_id, 0);
+  EXPECT_TRUE(request->cancel);
+}
+
+TEST(WorkerProtocolTest, DecodesEscapes) {
+  auto request = ParseWorkRequest(
+      R"({"arguments": ["a\"b\\c\n", "\u00e9\ud83d\ude00"]})");
+  ASSERT_TRUE(request.ok());
+  EXPECT_EQ(request->arguments[0], "a\"b\\c\n");
+  EXPECT_EQ(request->arguments[1], "\xC3\xA9\xF0\x9F\x98\x80");
+}
+
+TEST(WorkerProtocolTest, RejectsMalformedRequests) {
+  EXPECT_FALSE(ParseWorkRequest("").ok());
+  EXPECT_FALSE(ParseWorkRequest(R"({"arguments": ["a")").ok());
+  EXPECT_FALSE(ParseWorkRequest(R"({"requestId": "1"})").ok());
+  EXPECT_FALSE(ParseWorkRequest(R"({} {})").ok());
+}
+
+TEST(WorkerProtocolTest, SerializesResponse) {
+  EXPECT_EQ(SerializeWorkResponse(WorkResponse{
+                .exit_code = 1,
+                .output = "error: \"x\"\n",
+                .request_id = 3,
+            }),
+            R"({"exitCode":1,"output":"error: \"x\"\n","requestId":3})");
+}
+
+TEST(WorkerProtocolTest, RequestRoundTrips) {
+  WorkRequest request{
+      .arguments = {"-o", "out dir", "a\tb.sc"},
+      .inputs = {{.path = "a.sc", .digest = "xyz"}},
+      .request_id = 4,
+      .working_directory = "/home/sci",
+  };
+  auto parsed = ParseWorkRequest(SerializeWorkRequest(request));
+  ASSERT_TRUE(parsed.ok());
+  EXPECT_EQ(parsed->arguments, request.arguments);
+  ASSERT_EQ(parsed->inputs.size(), 1);
+  EXPECT_EQ(parsed->inputs[0].digest, "xyz");
+  EXPECT_EQ(parsed->request_id, 4);
+  EXPECT_EQ(parsed->working_directory, "/home/sci");
+}
+
+TEST(WorkerProtocolTest, ResponseRoundTrips) {
+  WorkResponse response{
+      .exit_code = 0,
+      .output = "Script 1: cached\n",
+      .output_files = {"out/1.hep", "out/1.scr"},
+  };
+  auto parsed = ParseWorkResponse(SerializeWorkResponse(response));
+  ASSERT_TRUE(parsed.ok());
+  EXPECT_EQ(parsed->exit_code, 0);
+  EXPECT_EQ(parsed->output, response.output);
+  EXPECT_EQ(parsed->output_files, response.output_files);
+}
+
+}  // namespace
+}  // namespace frontend
@@ -9,6 +9,7 @@
 #include <ranges>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "scic/codegen/code_generator.hpp"
@@ -221,7 +222,7 @@ static void MakeLoadEffectiveAddr(FunctionBuilder* builder, PNode* pn) {
   uint16_t theAddr;
   pn_t varType;
 
-  std::optional<std::string> name;
+  std::optional<std::string_view> name;
 
   // Put a pointer to the referenced symbol in the assembly node,
   // so we can print its name in the listing.
@@ -231,13 +232,13 @@ static void MakeLoadEffectiveAddr(FunctionBuilder* builder, PNode* pn) {
     case PN_INDEX: {
       auto* index = pn->child_at(0)->sym;
       if (index) {
-        name = std::string(index->name());
+        name = index->name();
       }
       break;
     }
     default:
       if (pn->sym) {
-        name = std::string(pn->sym->name());
+        name = pn->sym->name();
       }
       break;
   }
@@ -274,7 +275,7 @@ static void MakeLoadEffectiveAddr(FunctionBuilder* builder, PNode* pn) {
       break;
   }
 
-  builder->AddLoadVarAddr(accType, theAddr, indexed, std::move(name));
+  builder->AddLoadVarAddr(accType, theAddr, indexed, name);
 }
 
 void MakePropAccess(FunctionBuilder* builder, PNode* target,
@@ -283,12 +284,12 @@ void MakePropAccess(FunctionBuilder* builder, PNode* target,
     throw std::runtime_error("Property accesses can't use dynamic indexing.");
   }
 
-  std::optional<std::string> name;
+  std::optional<std::string_view> name;
   if (target->sym) {
-    name = std::string(target->sym->name());
+    name = target->sym->name();
   }
 
-  builder->AddPropAccess(op, target->val, std::move(name));
+  builder->AddPropAccess(op, target->val, name);
 }
 
 static void MakeVarAccess(FunctionBuilder* builder, PNode* target,
@@ -325,13 +326,12 @@ static void MakeVarAccess(FunctionBuilder* builder, PNode* target,
       break;
   }
 
-  std::optional<std::string> name;
+  std::optional<std::string_view> name;
   if (target->sym) {
-    name = std::string(target->sym->name());
+    name = target->sym->name();
   }
 
-  builder->AddVarAccess(varType, op, target->val, index != nullptr,
-                        std::move(name));
+  builder->AddVarAccess(varType, op, target->val, index != nullptr, name);
 }
 
 static void MakeAccess(FunctionBuilder* builder, PNode* pn,
@@ -369,21 +369,20 @@ static void MakeCall(FunctionBuilder* builder, PNode* pn) {
   // Compile the call.
   Symbol* sym = pn->sym;
   if (pn->type == PN_CALL) {
-    builder->AddProcCall(std::string(sym->name()), numArgs, &sym->forwardRef);
+    builder->AddProcCall(sym->name(), numArgs, &sym->forwardRef);
   } else {
     Public* pub = sym->ext();
     if (pub->script < 0) {
-      builder->AddKernelCall(std::string(sym->name()), numArgs, pub->entry);
+      builder->AddKernelCall(sym->name(), numArgs, pub->entry);
     } else {
-      builder->AddExternCall(std::string(sym->name()), numArgs, pub->script,
-                             pub->entry);
+      builder->AddExternCall(sym->name(), numArgs, pub->script, pub->entry);
     }
   }
 }
 
 static void MakeClassID(FunctionBuilder* builder, PNode* pn) {
   // Compile a class ID.
-  builder->AddLoadClassOp(std::string(pn->sym->name()), pn->sym->obj()->num);
+  builder->AddLoadClassOp(pn->sym->name(), pn->sym->obj()->num);
 }
 
 static void MakeObjID(FunctionBuilder* builder, PNode* pn) {
@@ -397,7 +396,7 @@ static void MakeObjID(FunctionBuilder* builder, PNode* pn) {
       Error("Undefined object from line %u: %s", sym->lineNum, sym->name());
       return;
     }
-    builder->AddLoadOffsetTo(&sym->forwardRef, std::string(sym->name()));
+    builder->AddLoadOffsetTo(&sym->forwardRef, sym->name());
   }
 }
 
@@ -419,7 +418,7 @@ static void MakeSend(FunctionBuilder* builder, PNode* pn) {
   if (on->type == PN_OBJ && on->val == (int)OBJ_SELF)
     builder->AddSelfSend(numArgs);
   else if (on->type == PN_SUPER)
-    builder->AddSuperSend(std::string(on->sym->name()), numArgs, on->val);
+    builder->AddSuperSend(on->sym->name(), numArgs, on->val);
   else {
     CompileExpr(builder, on);  // compile the object/class id
     builder->AddSend(numArgs);
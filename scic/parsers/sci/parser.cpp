@@ -1,9 +1,17 @@
 #include "scic/parsers/sci/parser.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "absl/types/span.h"
 #include "scic/parsers/combinators/results.hpp"
+#include "scic/parsers/combinators/status.hpp"
 #include "scic/parsers/list_tree/ast.hpp"
 #include "scic/parsers/sci/ast.hpp"
 #include "scic/parsers/sci/item_parsers.hpp"
@@ -14,6 +22,77 @@ using TreeExpr = list_tree::Expr;
 using ::parsers::list_tree::ListExpr;
 using ::parsers::list_tree::TokenExpr;
 
+namespace {
+
+// The result of parsing a single top-level item on a worker thread. If the
+// parser threw, the exception is captured so that it can be rethrown on the
+// calling thread in source order.
+struct ItemSlot {
+  std::optional<ParseResult<Item>> result;
+  std::exception_ptr exception;
+};
+
+ParseResult<std::vector<Item>> ParseItemsInParallel(
+    absl::Span<TreeExpr const> exprs, std::size_t num_threads) {
+  auto parse_item = ParseListExpr(ParseItem);
+  std::vector<ItemSlot> slots(exprs.size());
+  std::atomic<std::size_t> next_index = 0;
+
+  auto worker = [&] {
+    while (true) {
+      std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+      if (index >= exprs.size()) {
+        return;
+      }
+      try {
+        slots[index].result.emplace(parse_item(exprs[index]));
+      } catch (...) {
+        slots[index].exception = std::current_exception();
+      }
+    }
+  };
+
+  {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (std::size_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(worker);
+    }
+    // The calling thread participates in the work as well.
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // Merge the results in source order. This mirrors ParseEachTreeExpr, so
+  // the diagnostics come out in the same order as a sequential parse.
+  std::optional<ParseStatus> curr_error;
+  std::vector<Item> results;
+  for (auto& slot : slots) {
+    if (slot.exception) {
+      std::rethrow_exception(slot.exception);
+    }
+    auto result = std::move(slot.result).value();
+    if (!result.ok()) {
+      results.clear();
+      if (!curr_error) {
+        curr_error = std::move(result).status();
+      } else {
+        curr_error = std::move(curr_error).value() | std::move(result).status();
+      }
+    } else if (!curr_error) {
+      results.push_back(std::move(result).value());
+    }
+  }
+  if (curr_error) {
+    return std::move(curr_error).value();
+  }
+  return results;
+}
+
+}  // namespace
+
 ParseResult<std::vector<Item>> ParseItems(
     absl::Span<TreeExpr const> exprs) {
   auto exprs_span = absl::MakeConstSpan(exprs);
@@ -21,4 +100,13 @@ ParseResult<std::vector<Item>> ParseItems(
   return ParseEachTreeExpr(ParseListExpr(ParseItem))(exprs_span);
 }
 
-}  // namespace parsers::sci
\ No newline at end of file
+ParseResult<std::vector<Item>> ParseItems(absl::Span<TreeExpr const> exprs,
+                                          ParseItemsOptions const& options) {
+  std::size_t num_threads = std::min(options.num_threads, exprs.size());
+  if (num_threads <= 1) {
+    return ParseItems(exprs);
+  }
+  return ParseItemsInParallel(exprs, num_threads);
+}
+
+}  // namespace parsers::sci
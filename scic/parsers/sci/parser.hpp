@@ -1,6 +1,7 @@
 #ifndef PARSERS_SCI_PARSER_HPP
 #define PARSERS_SCI_PARSER_HPP
 
+#include <cstddef>
 #include <vector>
 
 #include "absl/types/span.h"
@@ -10,8 +11,21 @@
 
 namespace parsers::sci {
 
+struct ParseItemsOptions {
+  // The maximum number of threads to use when parsing top-level items. Each
+  // top-level form is an independent subtree, so they can be parsed
+  // concurrently. A value of 0 or 1 parses sequentially on the calling thread.
+  std::size_t num_threads = 1;
+};
+
 ParseResult<std::vector<Item>> ParseItems(
     absl::Span<list_tree::Expr const> exprs);
 
+// As above, but with explicit options. The result (including the order of any
+// diagnostics) is identical to the sequential parse, regardless of the number
+// of threads used.
+ParseResult<std::vector<Item>> ParseItems(
+    absl::Span<list_tree::Expr const> exprs, ParseItemsOptions const& options);
+
 }  // namespace parsers::sci
-#endif
\ No newline at end of file
+#endif
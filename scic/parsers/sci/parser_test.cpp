@@ -1,5 +1,6 @@
 #include "scic/parsers/sci/parser.hpp"
 
+#include <cstddef>
 #include <string_view>
 #include <vector>
 
@@ -142,5 +143,45 @@ TEST(ParseItemsTest, Selectors) {
   EXPECT_THAT(result.value(), ElementsAre(util::ChoiceOf<SelectorsDecl>(_)));
 }
 
+TEST(ParseItemsTest, ParallelPreservesOrder) {
+  auto exprs = list_tree::ParseExprsOrDie(R"(
+        (script# 111)
+        (public foo 1 bar 2)
+        (procedure (foo) (= a 1) (return))
+        (local [foo 4] 0 = [1 2 "Hello"])
+        (procedure (bar) (return))
+    )");
+
+  auto result = ParseItems(exprs, ParseItemsOptions{.num_threads = 4});
+  ASSERT_TRUE(result.ok());
+  EXPECT_THAT(result.value(), ElementsAre(util::ChoiceOf<ScriptNumDef>(_),
+                                          util::ChoiceOf<PublicDef>(_),
+                                          util::ChoiceOf<ProcDef>(_),
+                                          util::ChoiceOf<ModuleVarsDef>(_),
+                                          util::ChoiceOf<ProcDef>(_)));
+}
+
+TEST(ParseItemsTest, ParallelMergesDiagnosticsInOrder) {
+  auto exprs = list_tree::ParseExprsOrDie(R"(
+        (script# 111)
+        foo
+        (procedure (foo) (return))
+        bar
+    )");
+
+  auto sequential = ParseItems(exprs);
+  auto parallel = ParseItems(exprs, ParseItemsOptions{.num_threads = 4});
+  ASSERT_FALSE(sequential.ok());
+  ASSERT_FALSE(parallel.ok());
+  auto const& seq_messages = sequential.status().messages();
+  auto const& par_messages = parallel.status().messages();
+  ASSERT_EQ(seq_messages.size(), 2);
+  ASSERT_EQ(par_messages.size(), seq_messages.size());
+  for (std::size_t i = 0; i < seq_messages.size(); ++i) {
+    EXPECT_EQ(par_messages[i].primary().message(),
+              seq_messages[i].primary().message());
+  }
+}
+
 }  // namespace
 }  // namespace parsers::sci
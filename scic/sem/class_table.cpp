@@ -1,8 +1,6 @@
 #include "scic/sem/class_table.hpp"
 
 #include <cstddef>
-#include <functional>
-#include <map>
 #include <memory>
 #include <optional>
 #include <set>
@@ -11,6 +9,7 @@
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_format.h"
 #include "scic/codegen/code_generator.hpp"
 #include "scic/parsers/sci/ast.hpp"
@@ -257,8 +256,8 @@ class ClassTableLayer {
  private:
   std::vector<std::unique_ptr<ClassImpl>> classes_;
 
-  std::map<std::string_view, ClassImpl*, std::less<>> name_table_;
-  std::map<ClassSpecies, ClassImpl*, std::less<>> species_table_;
+  NameMap<ClassImpl*> name_table_;
+  absl::flat_hash_map<ClassSpecies, ClassImpl*> species_table_;
 };
 
 class ClassTableImpl : public ClassTable {
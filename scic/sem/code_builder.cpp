@@ -1,8 +1,6 @@
 #include "scic/sem/code_builder.hpp"
 
 #include <cstddef>
-#include <functional>
-#include <map>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -30,12 +28,12 @@ namespace {
 using namespace ::util::ref_str_literals;
 
 status::Status BuildGenericProcedure(
-    ModuleEnvironment const* mod_env, PropertyList const* prop_list,
+    ModuleScope const* module_scope, PropertyList const* prop_list,
     std::optional<ExprEnvironment::SuperInfo> super_info,
     codegen::FuncName func_name, codegen::PtrRef* proc_ref,
     ast::ProcDef const& ast_node) {
   std::size_t curr_param_offset = 0;
-  std::map<util::RefStr, ExprEnvironment::ParamSym, std::less<>> param_map;
+  RefStrMap<ExprEnvironment::ParamSym> param_map;
 
   // "argc" is always the first parameter, giving a concrete number for the
   // number of parameters provided.
@@ -54,7 +52,7 @@ status::Status BuildGenericProcedure(
   }
 
   std::size_t curr_temp_offset = 0;
-  std::map<util::RefStr, ExprEnvironment::TempSym, std::less<>> temp_map;
+  RefStrMap<ExprEnvironment::TempSym> temp_map;
   for (auto const& local : ast_node.locals()) {
     local.visit(
         [&](ast::SingleVarDef const& var) {
@@ -72,9 +70,10 @@ status::Status BuildGenericProcedure(
         });
   }
   auto expr_env =
-      ExprEnvironment::Create(mod_env, prop_list, std::move(super_info),
+      ExprEnvironment::Create(module_scope, prop_list, std::move(super_info),
                               std::move(param_map), std::move(temp_map));
 
+  auto const* mod_env = module_scope->mod_env();
   auto* codegen = mod_env->codegen();
   auto func_builder = codegen->CreateFunction(
       std::move(func_name), std::nullopt, curr_temp_offset, proc_ref);
@@ -90,9 +89,10 @@ status::Status BuildGenericProcedure(
   return status::OkStatus();
 }
 
-status::Status BuildClass(ModuleEnvironment const* module_env,
+status::Status BuildClass(ModuleScope const* module_scope,
                           Class const* class_def,
                           ast::ClassDef const& ast_node) {
+  auto const* module_env = module_scope->mod_env();
   if (!class_def->class_ref()) {
     throw std::logic_error("Class reference is not set for class");
   }
@@ -136,7 +136,7 @@ status::Status BuildClass(ModuleEnvironment const* module_env,
     codegen::MethodName name(std::string(class_def->name()),
                              std::string(method.name().value()));
 
-    RETURN_IF_ERROR(BuildGenericProcedure(module_env, &class_def->prop_list(),
+    RETURN_IF_ERROR(BuildGenericProcedure(module_scope, &class_def->prop_list(),
                                           super_info, std::move(name),
                                           &meth_ptr_ref, method));
   }
@@ -144,9 +144,10 @@ status::Status BuildClass(ModuleEnvironment const* module_env,
   return status::OkStatus();
 }
 
-status::Status BuildObject(ModuleEnvironment const* module_env,
+status::Status BuildObject(ModuleScope const* module_scope,
                            Object const* obj_def,
                            ast::ClassDef const& ast_node) {
+  auto const* module_env = module_scope->mod_env();
   auto obj_gen = module_env->codegen()->CreateObject(
       std::string(obj_def->name()), obj_def->ptr_ref());
   for (auto const& prop : obj_def->prop_list().properties()) {
@@ -179,7 +180,7 @@ status::Status BuildObject(ModuleEnvironment const* module_env,
     codegen::MethodName name(std::string(obj_def->name()),
                              std::string(method.name().value()));
 
-    RETURN_IF_ERROR(BuildGenericProcedure(module_env, &obj_def->prop_list(),
+    RETURN_IF_ERROR(BuildGenericProcedure(module_scope, &obj_def->prop_list(),
                                           super_info, std::move(name),
                                           &meth_ptr_ref, method));
   }
@@ -187,12 +188,12 @@ status::Status BuildObject(ModuleEnvironment const* module_env,
   return status::OkStatus();
 }
 
-status::Status BuildProcedure(ModuleEnvironment const* module_env,
+status::Status BuildProcedure(ModuleScope const* module_scope,
                               Procedure const* proc_obj,
                               ast::ProcDef const& ast_node) {
   codegen::ProcedureName name(std::string(proc_obj->name()));
 
-  return BuildGenericProcedure(module_env, nullptr, std::nullopt,
+  return BuildGenericProcedure(module_scope, nullptr, std::nullopt,
                                std::move(name), proc_obj->ptr_ref(), ast_node);
 }
 
@@ -200,6 +201,7 @@ status::Status BuildProcedure(ModuleEnvironment const* module_env,
 
 status::Status BuildCode(ModuleEnvironment const* module_env) {
   auto* codegen = module_env->codegen();
+  auto module_scope = ModuleScope::Create(module_env);
   // Add variables to the current module based on the local table.
   for (auto const& local_var : module_env->local_table()->vars()) {
     auto initial_value = local_var.initial_value();
@@ -217,7 +219,7 @@ status::Status BuildCode(ModuleEnvironment const* module_env) {
         [&](ast::ProcDef const* proc) {
           auto const* proc_obj =
               module_env->proc_table()->LookupByName(proc->name().value());
-          return BuildProcedure(module_env, proc_obj, *proc);
+          return BuildProcedure(module_scope.get(), proc_obj, *proc);
         },
         [&](ast::ClassDef const* class_def) {
           switch (class_def->kind()) {
@@ -225,13 +227,13 @@ status::Status BuildCode(ModuleEnvironment const* module_env) {
               auto const* class_obj =
                   module_env->global_env()->class_table()->LookupByName(
                       class_def->name().value());
-              return BuildClass(module_env, class_obj, *class_def);
+              return BuildClass(module_scope.get(), class_obj, *class_def);
             }
 
             case ast::ClassDef::OBJECT: {
               auto const* obj = module_env->object_table()->LookupByName(
                   class_def->name().value());
-              return BuildObject(module_env, obj, *class_def);
+              return BuildObject(module_scope.get(), obj, *class_def);
             }
 
             default:
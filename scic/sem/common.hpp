@@ -7,6 +7,8 @@
 #include <string_view>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "scic/parsers/sci/ast.hpp"
@@ -59,6 +61,51 @@ auto GetElemsOfType(auto const& range) {
   return result;
 }
 
+// Hash tables used for symbol lookups throughout sem.
+//
+// NameMap is keyed by views of names that are owned elsewhere (typically by
+// the entry being mapped to), so the owner must outlive the map.
+template <class V>
+using NameMap = absl::flat_hash_map<std::string_view, V>;
+
+// Hashes RefStr keys by their string contents, allowing RefStr-keyed tables to
+// be looked up directly by std::string_view.
+struct RefStrHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view str) const {
+    return absl::Hash<std::string_view>{}(str);
+  }
+};
+
+struct RefStrEq {
+  using is_transparent = void;
+
+  bool operator()(std::string_view a, std::string_view b) const {
+    return a == b;
+  }
+};
+
+// A table that owns its RefStr keys, but can be looked up by
+// std::string_view.
+template <class V>
+using RefStrMap = absl::flat_hash_map<util::RefStr, V, RefStrHash, RefStrEq>;
+
+// Looks up each of the given names in a table with a LookupByName() method,
+// returning the results in the same order. Names that are not found result in
+// a nullptr.
+template <class Table>
+auto LookupAllByName(Table const& table,
+                     absl::Span<std::string_view const> names) {
+  using Result = decltype(table.LookupByName(std::string_view()));
+  std::vector<Result> results;
+  results.reserve(names.size());
+  for (auto name : names) {
+    results.push_back(table.LookupByName(name));
+  }
+  return results;
+}
+
 // Strong types for common concepts in the sem namespace.
 
 // A tag that contains a std::size_t value.
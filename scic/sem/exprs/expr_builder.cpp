@@ -1,7 +1,6 @@
 #include "scic/sem/exprs/expr_builder.hpp"
 
 #include <cstddef>
-#include <map>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -10,6 +9,7 @@
 #include <utility>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "scic/codegen/code_generator.hpp"
@@ -100,7 +100,7 @@ status::Status BuildAddrOfExpr(ExprContext* ctx,
   }
   ctx->func_builder()->AddLoadVarAddr(type_val.type, type_val.offset,
                                       /*add_accum_index=*/index != nullptr,
-                                      std::string(var_name->view()));
+                                      var_name->view());
   return status::OkStatus();
 }
 
@@ -152,7 +152,7 @@ status::Status BuildVarStoreExpr(ExprContext* ctx, NameToken const& var_name,
         ctx->func_builder()->AddVarAccess(var_type, FunctionBuilder::STORE,
                                           var_offset,
                                           /*add_accum_index=*/index != nullptr,
-                                          std::string(var_name->view()));
+                                          var_name->view());
         return status::OkStatus();
       },
       [&](ExprEnvironment::PropSym const& proc) -> status::Status {
@@ -165,7 +165,7 @@ status::Status BuildVarStoreExpr(ExprContext* ctx, NameToken const& var_name,
         // In property accesses, the offset is the index * 2.
         ctx->func_builder()->AddPropAccess(FunctionBuilder::STORE,
                                            proc.prop_offset * 2,
-                                           std::string(proc.selector->name()));
+                                           proc.selector->name());
         return status::OkStatus();
       },
       [&](ExprEnvironment::ObjectSym const& obj) -> status::Status {
@@ -197,7 +197,7 @@ status::Status BuildVarLoadExpr(ExprContext* ctx,
 
         ctx->func_builder()->AddVarAccess(var_type, val_op, var_offset,
                                           /*add_accum_index=*/index != nullptr,
-                                          std::string(var_name->view()));
+                                          var_name->view());
         return status::OkStatus();
       },
       [&](ExprEnvironment::PropSym const& proc) -> status::Status {
@@ -206,7 +206,7 @@ status::Status BuildVarLoadExpr(ExprContext* ctx,
               "Properties cannot be indexed.");
         }
         ctx->func_builder()->AddPropAccess(val_op, proc.prop_offset * 2,
-                                           std::string(proc.selector->name()));
+                                           proc.selector->name());
         return status::OkStatus();
       },
       [&](ExprEnvironment::ObjectSym const& obj) -> status::Status {
@@ -220,7 +220,7 @@ status::Status BuildVarLoadExpr(ExprContext* ctx,
         if (index) {
           return status::FailedPreconditionError("Classes cannot be indexed");
         }
-        ctx->func_builder()->AddLoadClassOp(std::string(cls.cls->name()),
+        ctx->func_builder()->AddLoadClassOp(cls.cls->name(),
                                             cls.cls->species().value());
         return status::OkStatus();
       });
@@ -459,8 +459,8 @@ status::Status BuildCompExpr(ExprContext* ctx, NameToken const& op_name,
 using CallFunc = status::Status (*)(ExprContext* ctx, NameToken const& op_name,
                                     ast::CallArgs const& call);
 
-std::map<std::string_view, CallFunc> const& GetCallBuiltins() {
-  static std::map<std::string_view, CallFunc> builtins = {
+absl::flat_hash_map<std::string_view, CallFunc> const& GetCallBuiltins() {
+  static absl::flat_hash_map<std::string_view, CallFunc> const builtins = {
       {"-", &BuildSubExpr},
       {"not", &BuildUnaryExpr<FunctionBuilder::NOT>},
       {"~", &BuildUnaryExpr<FunctionBuilder::BNOT>},
@@ -514,19 +514,19 @@ status::Status BuildCallExpr(ExprContext* ctx, ast::CallExpr const& call) {
   ASSIGN_OR_RETURN(auto proc, ctx->LookupProc(target_name.value()));
   return proc.visit(
       [&](ExprEnvironment::LocalProc const& local) -> status::Status {
-        ctx->func_builder()->AddProcCall(std::string(local.name.value()),
-                                         num_args, local.proc_ref);
+        ctx->func_builder()->AddProcCall(local.name.value(), num_args,
+                                         local.proc_ref);
         return status::OkStatus();
       },
       [&](ExprEnvironment::ExternProc const& ext) -> status::Status {
-        ctx->func_builder()->AddExternCall(std::string(ext.name.value()),
-                                           num_args, ext.script_num.value(),
+        ctx->func_builder()->AddExternCall(ext.name.value(), num_args,
+                                           ext.script_num.value(),
                                            ext.extern_offset);
         return status::OkStatus();
       },
       [&](ExprEnvironment::KernelProc const& kernel) -> status::Status {
-        ctx->func_builder()->AddKernelCall(std::string(kernel.name.value()),
-                                           num_args, kernel.kernel_offset);
+        ctx->func_builder()->AddKernelCall(kernel.name.value(), num_args,
+                                           kernel.kernel_offset);
         return status::OkStatus();
       });
 }
@@ -602,9 +602,9 @@ status::Status BuildSendExpr(ExprContext* ctx, ast::SendExpr const& send) {
               "Cannot send to super without a super class.");
         }
         auto super_info = *ctx->super_info();
-        ctx->func_builder()->AddSuperSend(
-            std::string(super_info.super_name.value()), num_args,
-            int(super_info.species.value()));
+        ctx->func_builder()->AddSuperSend(super_info.super_name.value(),
+                                          num_args,
+                                          int(super_info.species.value()));
         return status::OkStatus();
       },
       [&](ast::ExprSendTarget const& expr) -> status::Status {
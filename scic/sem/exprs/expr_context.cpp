@@ -1,8 +1,6 @@
 #include "scic/sem/exprs/expr_context.hpp"
 
 #include <cstddef>
-#include <functional>
-#include <map>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -35,20 +33,80 @@ auto GetOrNull(C& c, T&& key) -> std::decay_t<C>::mapped_type const* {
   }
 }
 
-template <class... Args>
-bool AreAllNull(Args&&... args) {
-  return ((args == nullptr) && ...);
+using Sym = ExprEnvironment::Sym;
+
+// Resolves a symbol against the module level tables: globals, module locals,
+// objects and classes. In script 0, a module local may share its name with
+// the global of the same index, as they refer to the same variable.
+status::StatusOr<Sym> ResolveModuleSym(ModuleEnvironment const* mod_env,
+                                       std::string_view name) {
+  auto const* global =
+      mod_env->global_env()->global_table()->LookupByName(name);
+  auto const* module_var = mod_env->local_table()->LookupByName(name);
+  auto const* obj = mod_env->object_table()->LookupByName(name);
+  auto const* cls = mod_env->global_env()->class_table()->LookupByName(name);
+
+  if (module_var && global && !obj && !cls) {
+    if (mod_env->script_num().value() == 0 &&
+        module_var->index().value() == global->index().value()) {
+      return ExprEnvironment::LocalSym{
+          .local_offset = module_var->index().value(),
+      };
+    } else {
+      return status::InvalidArgumentError("Ambiguous symbol");
+    }
+  }
+
+  std::size_t num_resolved = 0;
+  if (module_var) {
+    ++num_resolved;
+  }
+  if (global) {
+    ++num_resolved;
+  }
+  if (obj) {
+    ++num_resolved;
+  }
+  if (cls) {
+    ++num_resolved;
+  }
+
+  if (num_resolved > 1) {
+    return status::InvalidArgumentError("Ambiguous symbol");
+  }
+
+  if (module_var) {
+    return ExprEnvironment::LocalSym{
+        .local_offset = module_var->index().value(),
+    };
+  } else if (global) {
+    return ExprEnvironment::GlobalSym{
+        .global_offset = global->index().value(),
+    };
+  } else if (obj) {
+    return ExprEnvironment::ObjectSym{
+        .obj = obj,
+    };
+  } else if (cls) {
+    return ExprEnvironment::ClassSym{
+        .cls = cls,
+    };
+  } else {
+    return status::NotFoundError(
+        absl::StrFormat("Symbol not found: %s", name));
+  }
 }
 
 class ExprEnvironmentImpl : public ExprEnvironment {
  public:
   using LocalVar = util::Choice<ParamSym, TempSym>;
   ExprEnvironmentImpl(
-      ModuleEnvironment const* mod_env, PropertyList const* prop_list,
+      ModuleScope const* module_scope, PropertyList const* prop_list,
       std::optional<SuperInfo> super_info,
-      std::map<util::RefStr, ParamSym, std::less<>> proc_local_table,
-      std::map<util::RefStr, TempSym, std::less<>> proc_temp_table)
-      : mod_env_(mod_env),
+      RefStrMap<ParamSym> proc_local_table,
+      RefStrMap<TempSym> proc_temp_table)
+      : module_scope_(module_scope),
+        mod_env_(module_scope->mod_env()),
         prop_list_(prop_list),
         super_info_(std::move(super_info)),
         proc_local_table_(std::move(proc_local_table)),
@@ -68,101 +126,13 @@ class ExprEnvironmentImpl : public ExprEnvironment {
   }
 
   status::StatusOr<Sym> LookupSym(std::string_view name) const override {
-    // We use the following order of resolution, where the results are not
-    // ambiguous:
-    //
-    // - Params and Temps (no collision)
-    // - Properties (if it exists)
-    // - Globals and ModuleVars (if this is script0, check that indexes match).
-    {
-      auto const* param = GetOrNull(proc_local_table_, name);
-      auto const* temp = GetOrNull(proc_temp_table_, name);
-
-      if (param || temp) {
-        if (param && temp) {
-          return status::InvalidArgumentError("Ambiguous symbol");
-        }
-
-        if (param) {
-          return *param;
-        } else {
-          return *temp;
-        }
-      }
-    }
-
-    {
-      auto const* prop = prop_list_ ? prop_list_->LookupByName(name) : nullptr;
-
-      if (prop) {
-        return PropSym{
-            .prop_offset = prop->index().value(),
-            .selector = prop->selector(),
-        };
-      }
-    }
-
-    {
-      auto const* global =
-          mod_env_->global_env()->global_table()->LookupByName(name);
-      auto const* module_var = mod_env_->local_table()->LookupByName(name);
-      auto const* obj = mod_env_->object_table()->LookupByName(name);
-      auto const* cls =
-          mod_env_->global_env()->class_table()->LookupByName(name);
-
-      if (module_var || global || obj || cls) {
-        if (module_var && global && !obj && !cls) {
-          if (mod_env_->script_num().value() == 0 &&
-              module_var->index().value() == global->index().value()) {
-            return LocalSym{
-                .local_offset = module_var->index().value(),
-            };
-          } else {
-            return status::InvalidArgumentError("Ambiguous symbol");
-          }
-        }
-
-        std::size_t num_resolved = 0;
-        if (module_var) {
-          ++num_resolved;
-        }
-        if (global) {
-          ++num_resolved;
-        }
-        if (obj) {
-          ++num_resolved;
-        }
-        if (cls) {
-          ++num_resolved;
-        }
-
-        if (num_resolved > 1) {
-          return status::InvalidArgumentError("Ambiguous symbol");
-        }
-
-        if (module_var) {
-          return LocalSym{
-              .local_offset = module_var->index().value(),
-          };
-        } else if (global) {
-          return GlobalSym{
-              .global_offset = global->index().value(),
-          };
-        } else if (obj) {
-          return ObjectSym{
-              .obj = obj,
-          };
-        } else if (cls) {
-          return ClassSym{
-              .cls = cls,
-          };
-        } else {
-          throw std::logic_error("Unreachable");
-        }
-      }
+    // Identifiers tend to be referenced many times within a single
+    // procedure, so remember each resolution, including failures.
+    auto it = sym_cache_.find(name);
+    if (it == sym_cache_.end()) {
+      it = sym_cache_.emplace(util::RefStr(name), ResolveSym(name)).first;
     }
-
-    return status::NotFoundError(absl::StrFormat("Symbol not found: %s", name));
+    return it->second;
   }
 
   status::StatusOr<Proc> LookupProc(std::string_view name) const override {
@@ -204,21 +174,109 @@ class ExprEnvironmentImpl : public ExprEnvironment {
   }
 
  private:
+  status::StatusOr<Sym> ResolveSym(std::string_view name) const {
+    // We use the following order of resolution, where the results are not
+    // ambiguous:
+    //
+    // - Params and Temps (no collision)
+    // - Properties (if it exists)
+    // - Module level symbols (see ResolveModuleSym()).
+    {
+      auto const* param = GetOrNull(proc_local_table_, name);
+      auto const* temp = GetOrNull(proc_temp_table_, name);
+
+      if (param || temp) {
+        if (param && temp) {
+          return status::InvalidArgumentError("Ambiguous symbol");
+        }
+
+        if (param) {
+          return *param;
+        } else {
+          return *temp;
+        }
+      }
+    }
+
+    {
+      auto const* prop = prop_list_ ? prop_list_->LookupByName(name) : nullptr;
+
+      if (prop) {
+        return PropSym{
+            .prop_offset = prop->index().value(),
+            .selector = prop->selector(),
+        };
+      }
+    }
+
+    return module_scope_->LookupSym(name);
+  }
+
+  ModuleScope const* module_scope_;
   ModuleEnvironment const* mod_env_;
   PropertyList const* absl_nullable prop_list_;
   std::optional<SuperInfo> super_info_;
-  std::map<util::RefStr, ParamSym, std::less<>> proc_local_table_;
-  std::map<util::RefStr, TempSym, std::less<>> proc_temp_table_;
+  RefStrMap<ParamSym> proc_local_table_;
+  RefStrMap<TempSym> proc_temp_table_;
+  mutable RefStrMap<status::StatusOr<Sym>> sym_cache_;
+};
+
+class ModuleScopeImpl : public ModuleScope {
+ public:
+  explicit ModuleScopeImpl(ModuleEnvironment const* mod_env,
+                           RefStrMap<status::StatusOr<Sym>> sym_table)
+      : mod_env_(mod_env), sym_table_(std::move(sym_table)) {}
+
+  ModuleEnvironment const* mod_env() const override { return mod_env_; }
+
+  status::StatusOr<Sym> LookupSym(std::string_view name) const override {
+    auto const* sym = GetOrNull(sym_table_, name);
+    if (!sym) {
+      return status::NotFoundError(
+          absl::StrFormat("Symbol not found: %s", name));
+    }
+    return *sym;
+  }
+
+ private:
+  ModuleEnvironment const* mod_env_;
+  RefStrMap<status::StatusOr<Sym>> sym_table_;
 };
 }  // namespace
 
 std::unique_ptr<ExprEnvironment> ExprEnvironment::Create(
-    ModuleEnvironment const* mod_env, PropertyList const* prop_list,
+    ModuleScope const* module_scope, PropertyList const* prop_list,
     std::optional<SuperInfo> super_info,
-    std::map<util::RefStr, ParamSym, std::less<>> proc_local_table,
-    std::map<util::RefStr, TempSym, std::less<>> proc_temp_table) {
+    RefStrMap<ParamSym> proc_local_table,
+    RefStrMap<TempSym> proc_temp_table) {
   return std::make_unique<ExprEnvironmentImpl>(
-      mod_env, prop_list, std::move(super_info), std::move(proc_local_table),
-      std::move(proc_temp_table));
+      module_scope, prop_list, std::move(super_info),
+      std::move(proc_local_table), std::move(proc_temp_table));
+}
+
+std::unique_ptr<ModuleScope> ModuleScope::Create(
+    ModuleEnvironment const* mod_env) {
+  RefStrMap<status::StatusOr<Sym>> sym_table;
+  auto add_name = [&](util::RefStr const& name) {
+    if (!sym_table.contains(name)) {
+      sym_table.emplace(name, ResolveModuleSym(mod_env, name));
+    }
+  };
+
+  for (auto const& var : mod_env->global_env()->global_table()->vars()) {
+    add_name(var.name());
+  }
+  for (auto const& var : mod_env->local_table()->vars()) {
+    add_name(var.name());
+  }
+  for (auto const& obj :
+       mod_env->object_table()->objects(mod_env->script_num())) {
+    add_name(obj.name());
+  }
+  for (auto const& cls : mod_env->global_env()->class_table()->classes()) {
+    add_name(cls.name());
+  }
+
+  return std::make_unique<ModuleScopeImpl>(mod_env, std::move(sym_table));
 }
 }  // namespace sem
\ No newline at end of file
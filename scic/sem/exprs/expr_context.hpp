@@ -2,8 +2,6 @@
 #define SEM_EXPR_CONTEXT_HPP
 
 #include <cstddef>
-#include <functional>
-#include <map>
 #include <memory>
 #include <optional>
 #include <stdexcept>
@@ -24,6 +22,7 @@
 namespace sem {
 
 class Loop;
+class ModuleScope;
 
 class ExprEnvironment {
  public:
@@ -93,11 +92,14 @@ class ExprEnvironment {
     NameToken super_name;
   };
 
+  // Creates the environment for a single procedure or method. Symbols that
+  // are not bound by the procedure itself are resolved through module_scope,
+  // which must outlive the returned environment.
   static std::unique_ptr<ExprEnvironment> Create(
-      ModuleEnvironment const* mod_env, PropertyList const* prop_list,
+      ModuleScope const* module_scope, PropertyList const* prop_list,
       std::optional<SuperInfo> super_info,
-      std::map<util::RefStr, ParamSym, std::less<>> proc_local_table,
-      std::map<util::RefStr, TempSym, std::less<>> proc_temp_table);
+      RefStrMap<ParamSym> proc_local_table,
+      RefStrMap<TempSym> proc_temp_table);
 
   virtual ~ExprEnvironment() = default;
 
@@ -111,6 +113,24 @@ class ExprEnvironment {
   virtual status::StatusOr<Proc> LookupProc(std::string_view name) const = 0;
 };
 
+// The module-level symbols visible to all code in a module: globals, module
+// locals, objects and classes.
+//
+// Every name bound at module level is resolved once when the scope is created,
+// including any ambiguity between the tables, so that resolving a symbol takes
+// a single hash probe instead of a probe per table.
+class ModuleScope {
+ public:
+  static std::unique_ptr<ModuleScope> Create(ModuleEnvironment const* mod_env);
+
+  virtual ~ModuleScope() = default;
+
+  virtual ModuleEnvironment const* mod_env() const = 0;
+
+  virtual status::StatusOr<ExprEnvironment::Sym> LookupSym(
+      std::string_view name) const = 0;
+};
+
 class ExprContext {
  public:
   ExprContext(ExprEnvironment const* expr_env, codegen::CodeGenerator* codegen,
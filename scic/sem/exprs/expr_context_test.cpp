@@ -0,0 +1,190 @@
+#include "scic/sem/exprs/expr_context.hpp"
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/code_generator.hpp"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/common.hpp"
+#include "scic/sem/input.hpp"
+#include "scic/sem/module_env.hpp"
+#include "scic/sem/test_helpers.hpp"
+#include "scic/status/status.hpp"
+#include "util/status/status_matchers.hpp"
+#include "util/strings/ref_str.hpp"
+
+namespace sem {
+namespace {
+
+using util::ref_str_literals::operator""_rs;
+
+using VarSym = ExprEnvironment::VarSym;
+
+class ExprContextTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    global_items_ = ParseItemsOrDie(R"(
+        (selectors
+            -objID- 4096
+            -size- 4097
+            -propDict- 4098
+            -methDict- 4099
+            -classScript- 4100
+            -script- 4101
+            -super- 4102
+            -info- 4103
+            name 20)
+        (globaldecl
+            gScore 0
+            shared 1)
+    )");
+    module_items_ = ParseItemsOrDie(R"(
+        (script# 1)
+        (local
+            count 0
+            shared 1
+            Thing 2)
+        (class Thing
+            (properties
+                x 0
+                count 0))
+        (instance thing of Thing
+            (properties
+                x 1))
+        (procedure (thing) (return))
+    )");
+
+    Input input;
+    input.global_items = global_items_;
+    input.modules.push_back(Input::Module{.module_items = module_items_});
+    codegen::CodeGenerator::Options options{
+        .target = codegen::SciTarget::SCI_2,
+        .opt = codegen::Optimization::OPTIMIZE,
+    };
+    ASSERT_OK_AND_ASSIGN(auto env, BuildCompilationEnvironment(options, input));
+    env_ = std::make_unique<CompilationEnvironment>(std::move(env));
+    module_scope_ = ModuleScope::Create(
+        env_->FindModuleEnvironmentByScriptNum(ScriptNum::Create(1)));
+  }
+
+  std::unique_ptr<ExprEnvironment> CreateExprEnv(
+      PropertyList const* prop_list = nullptr,
+      RefStrMap<ExprEnvironment::ParamSym> params = {},
+      RefStrMap<ExprEnvironment::TempSym> temps = {}) const {
+    return ExprEnvironment::Create(module_scope_.get(), prop_list,
+                                   std::nullopt, std::move(params),
+                                   std::move(temps));
+  }
+
+  PropertyList const* ThingProps() const {
+    auto const* cls = env_->global_env()->class_table()->LookupByName("Thing");
+    return &cls->prop_list();
+  }
+
+  std::vector<ast::Item> global_items_;
+  std::vector<ast::Item> module_items_;
+  std::unique_ptr<CompilationEnvironment> env_;
+  std::unique_ptr<ModuleScope> module_scope_;
+};
+
+TEST_F(ExprContextTest, ResolvesModuleSymbols) {
+  auto expr_env = CreateExprEnv();
+
+  ASSERT_OK_AND_ASSIGN(auto global, expr_env->LookupSym("gScore"));
+  EXPECT_EQ(global.as<VarSym>().as<ExprEnvironment::GlobalSym>().global_offset,
+            0);
+
+  ASSERT_OK_AND_ASSIGN(auto local, expr_env->LookupSym("count"));
+  EXPECT_EQ(local.as<VarSym>().as<ExprEnvironment::LocalSym>().local_offset, 0);
+
+  ASSERT_OK_AND_ASSIGN(auto obj, expr_env->LookupSym("thing"));
+  EXPECT_EQ(obj.as<ExprEnvironment::ObjectSym>().obj->name(), "thing");
+}
+
+TEST_F(ExprContextTest, ProcedureLocalsShadowModuleSymbols) {
+  RefStrMap<ExprEnvironment::ParamSym> params;
+  params.emplace("gScore"_rs, ExprEnvironment::ParamSym{.param_offset = 1});
+  RefStrMap<ExprEnvironment::TempSym> temps;
+  temps.emplace("thing"_rs, ExprEnvironment::TempSym{.temp_offset = 2});
+  auto expr_env = CreateExprEnv(nullptr, std::move(params), std::move(temps));
+
+  ASSERT_OK_AND_ASSIGN(auto param, expr_env->LookupSym("gScore"));
+  EXPECT_EQ(param.as<VarSym>().as<ExprEnvironment::ParamSym>().param_offset, 1);
+
+  ASSERT_OK_AND_ASSIGN(auto temp, expr_env->LookupSym("thing"));
+  EXPECT_EQ(temp.as<VarSym>().as<ExprEnvironment::TempSym>().temp_offset, 2);
+
+  // The module scope itself is unaffected.
+  ASSERT_OK_AND_ASSIGN(auto global, module_scope_->LookupSym("gScore"));
+  EXPECT_TRUE(global.as<VarSym>().has<ExprEnvironment::GlobalSym>());
+}
+
+TEST_F(ExprContextTest, PropertiesShadowModuleSymbols) {
+  auto expr_env = CreateExprEnv(ThingProps());
+
+  ASSERT_OK_AND_ASSIGN(auto prop, expr_env->LookupSym("count"));
+  ASSERT_TRUE(prop.has<ExprEnvironment::PropSym>());
+  EXPECT_EQ(prop.as<ExprEnvironment::PropSym>().selector->name(), "count");
+
+  // Names that are not properties still resolve at module level.
+  ASSERT_OK_AND_ASSIGN(auto global, expr_env->LookupSym("gScore"));
+  EXPECT_TRUE(global.has<VarSym>());
+}
+
+TEST_F(ExprContextTest, ObjectAndProcedureNamesDoNotClash) {
+  auto expr_env = CreateExprEnv();
+
+  ASSERT_OK_AND_ASSIGN(auto sym, expr_env->LookupSym("thing"));
+  EXPECT_TRUE(sym.has<ExprEnvironment::ObjectSym>());
+
+  ASSERT_OK_AND_ASSIGN(auto proc, expr_env->LookupProc("thing"));
+  ASSERT_TRUE(proc.has<ExprEnvironment::LocalProc>());
+  EXPECT_EQ(proc.as<ExprEnvironment::LocalProc>().name.value(), "thing");
+}
+
+TEST_F(ExprContextTest, ModuleLevelClashesAreAmbiguous) {
+  auto expr_env = CreateExprEnv();
+
+  // A module local with the same name as a class.
+  auto cls = expr_env->LookupSym("Thing");
+  ASSERT_FALSE(cls.ok());
+  EXPECT_FALSE(status::IsNotFound(cls.status()));
+  EXPECT_EQ(cls.status().message(), "Ambiguous symbol");
+
+  // A module local with the same name as a global, outside of script 0.
+  auto var = expr_env->LookupSym("shared");
+  ASSERT_FALSE(var.ok());
+  EXPECT_EQ(var.status().message(), "Ambiguous symbol");
+}
+
+TEST_F(ExprContextTest, UnknownSymbolsAreNotFound) {
+  auto expr_env = CreateExprEnv(ThingProps());
+
+  for (auto const& result :
+       {expr_env->LookupSym("unknown"), module_scope_->LookupSym("unknown")}) {
+    ASSERT_FALSE(result.ok());
+    EXPECT_TRUE(status::IsNotFound(result.status()));
+    EXPECT_EQ(result.status().message(), "Symbol not found: unknown");
+  }
+}
+
+TEST_F(ExprContextTest, RepeatedLookupsGiveTheSameResult) {
+  auto expr_env = CreateExprEnv();
+
+  ASSERT_OK_AND_ASSIGN(auto first, expr_env->LookupSym("thing"));
+  ASSERT_OK_AND_ASSIGN(auto second, expr_env->LookupSym("thing"));
+  EXPECT_EQ(first.as<ExprEnvironment::ObjectSym>().obj,
+            second.as<ExprEnvironment::ObjectSym>().obj);
+
+  // Failures are remembered as well.
+  auto first_error = expr_env->LookupSym("unknown");
+  auto second_error = expr_env->LookupSym("unknown");
+  ASSERT_FALSE(second_error.ok());
+  EXPECT_EQ(first_error.status().message(), second_error.status().message());
+}
+
+}  // namespace
+}  // namespace sem
@@ -1,7 +1,5 @@
 #include "scic/sem/extern_table.hpp"
 
-#include <functional>
-#include <map>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -41,7 +39,7 @@ class ExternTableImpl : public ExternTable {
  public:
   ExternTableImpl(
       std::vector<std::unique_ptr<ExternImpl>> externs,
-      std::map<std::string_view, ExternImpl const*, std::less<>> name_map)
+      NameMap<ExternImpl const*> name_map)
       : externs_(std::move(externs)), name_map_(std::move(name_map)) {}
 
   util::Seq<Extern const&> externs() const override {
@@ -58,7 +56,7 @@ class ExternTableImpl : public ExternTable {
 
  private:
   std::vector<std::unique_ptr<ExternImpl>> externs_;
-  std::map<std::string_view, ExternImpl const*, std::less<>> name_map_;
+  NameMap<ExternImpl const*> name_map_;
 };
 
 class ExternTableBuilderImpl : public ExternTableBuilder {
@@ -84,7 +82,7 @@ class ExternTableBuilderImpl : public ExternTableBuilder {
 
  private:
   std::vector<std::unique_ptr<ExternImpl>> externs_;
-  std::map<std::string_view, ExternImpl const*, std::less<>> name_map_;
+  NameMap<ExternImpl const*> name_map_;
 };
 
 }  // namespace
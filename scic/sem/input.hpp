@@ -3,17 +3,24 @@
 
 #include <vector>
 
-#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/common.hpp"
+#include "scic/sem/module_summary.hpp"
 namespace sem {
 
+// The items to compile. The items are not owned by the input, and must
+// outlive the compilation environment built from it.
 struct Input {
-  std::vector<parsers::sci::Item> global_items;
+  Items global_items;
 
   struct Module {
-    std::vector<parsers::sci::Item> module_items;
+    Items module_items;
   };
 
   std::vector<Module> modules;
+
+  // Summaries of modules that are not being compiled, but still contribute
+  // classes and selectors to the global environment.
+  std::vector<ModuleSummary> module_summaries;
 };
 
 }  // namespace sem
@@ -0,0 +1,21 @@
+#include "scic/sem/item_index.hpp"
+
+#include <tuple>
+#include <vector>
+
+#include "scic/sem/common.hpp"
+
+namespace sem {
+
+ItemIndex ItemIndex::Build(Items items) {
+  ItemIndex index;
+  index.items_ = items;
+  for (auto const& item : items) {
+    item.visit([&]<class T>(T const& elem) {
+      std::get<std::vector<T const*>>(index.buckets_).push_back(&elem);
+    });
+  }
+  return index;
+}
+
+}  // namespace sem
@@ -0,0 +1,49 @@
+#ifndef SEM_ITEM_INDEX_HPP
+#define SEM_ITEM_INDEX_HPP
+
+#include <tuple>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "scic/sem/common.hpp"
+
+namespace sem {
+
+// An index over a list of items, bucketing them by kind.
+//
+// The index is built in a single pass over the items, so that each of the
+// table builders can find the items it cares about without rescanning the
+// whole list. Within each bucket, the items are kept in source order.
+//
+// The index holds pointers into the original items, which must outlive it.
+class ItemIndex {
+ public:
+  static ItemIndex Build(Items items);
+
+  ItemIndex() = default;
+
+  Items items() const { return items_; }
+
+  // Returns all of the items of type T, in source order.
+  template <class T>
+  absl::Span<T const* const> Get() const {
+    return std::get<std::vector<T const*>>(buckets_);
+  }
+
+ private:
+  Items items_;
+  std::tuple<std::vector<ast::ScriptNumDef const*>,
+             std::vector<ast::PublicDef const*>,
+             std::vector<ast::ExternDef const*>,
+             std::vector<ast::GlobalDeclDef const*>,
+             std::vector<ast::ModuleVarsDef const*>,
+             std::vector<ast::ProcDef const*>,
+             std::vector<ast::ClassDef const*>,
+             std::vector<ast::ClassDecl const*>,
+             std::vector<ast::SelectorsDecl const*>>
+      buckets_;
+};
+
+}  // namespace sem
+
+#endif
@@ -0,0 +1,48 @@
+#include "scic/sem/item_index.hpp"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/common.hpp"
+#include "scic/sem/test_helpers.hpp"
+
+namespace sem {
+namespace {
+
+TEST(ItemIndexTest, Empty) {
+  auto index = ItemIndex::Build({});
+  EXPECT_TRUE(index.items().empty());
+  EXPECT_TRUE(index.Get<ast::ProcDef>().empty());
+  EXPECT_TRUE(index.Get<ast::ClassDef>().empty());
+}
+
+TEST(ItemIndexTest, BucketsByKindInSourceOrder) {
+  auto items = ParseItemsOrDie(R"(
+      (script# 10)
+      (procedure (foo) (return))
+      (local [a 4] 0 = [1 2 3 4])
+      (procedure (bar) (return))
+      (instance Baz of Quux
+          (properties x 1)
+          (methods y))
+      (procedure (qux) (return))
+  )");
+  auto index = ItemIndex::Build(items);
+
+  EXPECT_EQ(index.items().size(), items.size());
+  ASSERT_EQ(index.Get<ast::ScriptNumDef>().size(), 1);
+  EXPECT_EQ(index.Get<ast::ScriptNumDef>()[0]->script_num().value(), 10);
+  EXPECT_EQ(index.Get<ast::ModuleVarsDef>().size(), 1);
+  EXPECT_EQ(index.Get<ast::ClassDef>().size(), 1);
+  EXPECT_TRUE(index.Get<ast::PublicDef>().empty());
+
+  auto procs = index.Get<ast::ProcDef>();
+  ASSERT_EQ(procs.size(), 3);
+  EXPECT_EQ(procs[0]->name().value(), "foo");
+  EXPECT_EQ(procs[1]->name().value(), "bar");
+  EXPECT_EQ(procs[2]->name().value(), "qux");
+}
+
+}  // namespace
+}  // namespace sem
@@ -1,20 +1,27 @@
 #include "scic/sem/module_env.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <exception>
 #include <map>
 #include <memory>
 #include <optional>
+#include <set>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "absl/strings/str_format.h"
-#include "absl/types/span.h"
 #include "scic/codegen/code_generator.hpp"
 #include "scic/parsers/sci/ast.hpp"
 #include "scic/sem/class_table.hpp"
 #include "scic/sem/common.hpp"
 #include "scic/sem/extern_table.hpp"
 #include "scic/sem/input.hpp"
+#include "scic/sem/item_index.hpp"
+#include "scic/sem/module_summary.hpp"
 #include "scic/sem/object_table.hpp"
 #include "scic/sem/proc_table.hpp"
 #include "scic/sem/public_table.hpp"
@@ -31,23 +38,11 @@ namespace {
 
 using codegen::CodeGenerator;
 
-status::StatusOr<ScriptNum> GetScriptId(Items items) {
-  auto result = GetElemsOfType<ast::ScriptNumDef>(items);
-
-  if (result.size() == 0) {
-    return status::InvalidArgumentError("No script number defined");
-  } else if (result.size() > 1) {
-    return status::InvalidArgumentError("Multiple script numbers defined");
-  }
-
-  return ScriptNum::Create(result[0]->script_num().value());
-}
-
 status::Status AddItemsToSelectorTable(SelectorTable::Builder* builder,
-                                       absl::Span<ast::Item const> items) {
+                                       ItemIndex const& items) {
   {
     // First, gather declared selectors.
-    auto classes = GetElemsOfType<ast::SelectorsDecl>(items);
+    auto classes = items.Get<ast::SelectorsDecl>();
     for (auto const* class_decl : classes) {
       auto const& selectors = class_decl->selectors();
       for (auto const& selector : selectors) {
@@ -58,8 +53,7 @@ status::Status AddItemsToSelectorTable(SelectorTable::Builder* builder,
   }
 
   {
-    auto classes = GetElemsOfType<ast::ClassDef>(items);
-    std::vector<ast::TokenNode<util::RefStr>> result;
+    auto classes = items.Get<ast::ClassDef>();
     for (auto const* class_def : classes) {
       for (auto const& prop : class_def->properties()) {
         RETURN_IF_ERROR(builder->AddNewSelector(prop.name));
@@ -93,8 +87,8 @@ status::StatusOr<codegen::LiteralValue> AstConstValueToLiteralValue(
 status::Status AddItemsToClassTable(ClassTableBuilder* builder,
                                     codegen::CodeGenerator* codegen,
                                     std::optional<ScriptNum> script_num,
-                                    Items items) {
-  for (auto const* class_decl : GetElemsOfType<ast::ClassDecl>(items)) {
+                                    ItemIndex const& items) {
+  for (auto const* class_decl : items.Get<ast::ClassDecl>()) {
     std::vector<ClassTableBuilder::Property> properties;
     for (auto const& prop : class_decl->properties()) {
       ASSIGN_OR_RETURN(auto value,
@@ -118,7 +112,7 @@ status::Status AddItemsToClassTable(ClassTableBuilder* builder,
         std::move(properties), std::move(methods)));
   }
 
-  for (auto const* classdef : GetElemsOfType<ast::ClassDef>(items)) {
+  for (auto const* classdef : items.Get<ast::ClassDef>()) {
     if (classdef->kind() != ast::ClassDef::CLASS) {
       continue;
     }
@@ -156,48 +150,122 @@ status::Status AddItemsToClassTable(ClassTableBuilder* builder,
   return status::OkStatus();
 }
 
+status::Status AddSummaryToSelectorTable(SelectorTable::Builder* builder,
+                                         ModuleSummary const& summary) {
+  for (auto const& selector : summary.declared_selectors) {
+    RETURN_IF_ERROR(
+        builder->DeclareSelector(selector.name, selector.selector_num));
+  }
+  for (auto const& name : summary.new_selectors) {
+    RETURN_IF_ERROR(builder->AddNewSelector(name));
+  }
+  return status::OkStatus();
+}
+
+// As AstConstValueToLiteralValue, but for a property value from a summary.
+status::StatusOr<codegen::LiteralValue> SummaryValueToLiteralValue(
+    CodeGenerator* codegen, ModuleSummary::PropertyValue const& value) {
+  return value.visit(
+      [&](int num) -> status::StatusOr<codegen::LiteralValue> { return num; },
+      [&](std::string const& str) -> status::StatusOr<codegen::LiteralValue> {
+        if (!codegen) {
+          return status::InvalidArgumentError(
+              "String constants cannot be used in this context");
+        }
+        return codegen->AddTextNode(str);
+      });
+}
+
+status::StatusOr<std::vector<ClassTableBuilder::Property>>
+SummaryToClassProperties(
+    CodeGenerator* codegen,
+    std::vector<ModuleSummary::Property> const& properties) {
+  std::vector<ClassTableBuilder::Property> result;
+  for (auto const& prop : properties) {
+    ASSIGN_OR_RETURN(auto value,
+                     SummaryValueToLiteralValue(codegen, prop.value));
+    result.push_back(ClassTableBuilder::Property{
+        .name = prop.name,
+        .value = value,
+    });
+  }
+  return result;
+}
+
+// Adds the classes from a module summary. If the module is being compiled,
+// codegen is its code generator, and string property values become text nodes
+// in it, as they do when the classes are added from the module's items.
+// Otherwise it is null, as no code will be generated for the module's classes.
+status::Status AddSummaryToClassTable(ClassTableBuilder* builder,
+                                      codegen::CodeGenerator* codegen,
+                                      ModuleSummary const& summary) {
+  for (auto const& decl : summary.class_decls) {
+    ASSIGN_OR_RETURN(auto properties,
+                     SummaryToClassProperties(codegen, decl.properties));
+    RETURN_IF_ERROR(builder->AddClassDecl(
+        decl.name, decl.script_num, decl.species, decl.super_species,
+        std::move(properties), decl.methods));
+  }
+
+  for (auto const& def : summary.class_defs) {
+    ASSIGN_OR_RETURN(auto properties,
+                     SummaryToClassProperties(codegen, def.properties));
+    RETURN_IF_ERROR(builder->AddClassDef(
+        def.name, summary.script_num, def.super_name, std::move(properties),
+        def.methods, codegen ? codegen->CreatePtrRef() : codegen::PtrRef()));
+  }
+
+  return status::OkStatus();
+}
+
 // Do initial processing, to get the script number from each module
 // and create the appropriate codegens.
 struct ModuleLocal {
-  ScriptNum script_num;
+  ModuleSummary summary;
   std::unique_ptr<codegen::CodeGenerator> codegen;
-  Items items;
+  ItemIndex items;
+};
+
+// A module that contributes to the global environment. The codegen is null
+// if the module is only known through its summary.
+struct SummaryEntry {
+  ModuleSummary const* summary;
+  codegen::CodeGenerator* codegen;
 };
 
 status::StatusOr<std::unique_ptr<SelectorTable>> BuildSelectorTable(
-    Items global_items, util::SeqView<ModuleLocal const> modules) {
+    ItemIndex const& global_items, util::SeqView<SummaryEntry const> modules) {
   auto selector_builder = SelectorTable::CreateBuilder();
 
   RETURN_IF_ERROR(
       AddItemsToSelectorTable(selector_builder.get(), global_items));
   for (auto const& module : modules) {
     RETURN_IF_ERROR(
-        AddItemsToSelectorTable(selector_builder.get(), module.items));
+        AddSummaryToSelectorTable(selector_builder.get(), *module.summary));
   }
 
   return selector_builder->Build();
 }
 
 status::StatusOr<std::unique_ptr<ClassTable>> BuildClassTable(
-    SelectorTable const* selector_table, Items global_items,
-    util::SeqView<ModuleLocal const> modules) {
+    SelectorTable const* selector_table, ItemIndex const& global_items,
+    util::SeqView<SummaryEntry const> modules) {
   auto class_builder = ClassTableBuilder::Create(selector_table);
   RETURN_IF_ERROR(AddItemsToClassTable(class_builder.get(), nullptr,
                                        std::nullopt, global_items));
   for (auto const& module : modules) {
-    RETURN_IF_ERROR(AddItemsToClassTable(class_builder.get(),
-                                         module.codegen.get(),
-                                         module.script_num, module.items));
+    RETURN_IF_ERROR(AddSummaryToClassTable(class_builder.get(), module.codegen,
+                                           *module.summary));
   }
 
   return class_builder->Build();
 }
 
 status::StatusOr<std::unique_ptr<ExternTable>> BuildExternTable(
-    absl::Span<ast::Item const> items) {
+    ItemIndex const& items) {
   auto builder = ExternTableBuilder::Create();
 
-  for (auto const* extern_def : GetElemsOfType<ast::ExternDef>(items)) {
+  for (auto const* extern_def : items.Get<ast::ExternDef>()) {
     for (auto const& entry : extern_def->entries()) {
       auto module_num = entry.module_num.value();
       if (module_num < -1) {
@@ -224,10 +292,10 @@ status::StatusOr<std::unique_ptr<ExternTable>> BuildExternTable(
 }
 
 status::StatusOr<std::unique_ptr<VarDeclTable>> BuildGlobalTable(
-    absl::Span<ast::Item const> items) {
+    ItemIndex const& items) {
   auto builder = VarDeclTableBuilder::Create();
 
-  for (auto const* var_decl : GetElemsOfType<ast::GlobalDeclDef>(items)) {
+  for (auto const* var_decl : items.Get<ast::GlobalDeclDef>()) {
     for (auto const& entry : var_decl->entries()) {
       auto name = entry.name.visit(
           [&](ast::SingleVarDef const& single_var) {
@@ -245,10 +313,10 @@ status::StatusOr<std::unique_ptr<VarDeclTable>> BuildGlobalTable(
 status::StatusOr<std::unique_ptr<ObjectTable>> BuildObjectTable(
     codegen::CodeGenerator* codegen, SelectorTable const* selector,
     ClassTable const* class_table, ScriptNum script_num,
-    absl::Span<ast::Item const> items) {
+    ItemIndex const& items) {
   auto builder = ObjectTableBuilder::Create(codegen, selector, class_table);
 
-  for (auto const* object : GetElemsOfType<ast::ClassDef>(items)) {
+  for (auto const* object : items.Get<ast::ClassDef>()) {
     if (object->kind() != ast::ClassDef::OBJECT) {
       continue;
     }
@@ -279,10 +347,10 @@ status::StatusOr<std::unique_ptr<ObjectTable>> BuildObjectTable(
 }
 
 status::StatusOr<std::unique_ptr<ProcTable>> BuildProcTable(
-    codegen::CodeGenerator* codegen, absl::Span<ast::Item const> items) {
+    codegen::CodeGenerator* codegen, ItemIndex const& items) {
   auto builder = ProcTableBuilder::Create(codegen);
 
-  for (auto const* proc : GetElemsOfType<ast::ProcDef>(items)) {
+  for (auto const* proc : items.Get<ast::ProcDef>()) {
     RETURN_IF_ERROR(builder->AddProcedure(proc->name()));
   }
 
@@ -292,10 +360,10 @@ status::StatusOr<std::unique_ptr<ProcTable>> BuildProcTable(
 status::StatusOr<std::unique_ptr<PublicTable>> BuildPublicTable(
     ScriptNum script_num, ProcTable const* proc_table,
     ObjectTable const* object_table, ClassTable const* class_table,
-    absl::Span<ast::Item const> items) {
+    ItemIndex const& items) {
   auto builder = PublicTableBuilder::Create();
 
-  auto elems = GetElemsOfType<ast::PublicDef>(items);
+  auto elems = items.Get<ast::PublicDef>();
 
   if (elems.size() == 0) {
     // It's okay to have no public table. Just return an empty public object.
@@ -381,10 +449,10 @@ AstConstValuesToLiteralValues(codegen::CodeGenerator* codegen,
 }
 
 status::StatusOr<std::unique_ptr<VarTable>> BuildLocalTable(
-    CodeGenerator* codegen, absl::Span<ast::Item const> items) {
+    CodeGenerator* codegen, ItemIndex const& items) {
   auto builder = VarTableBuilder::Create();
 
-  for (auto const* var_decl : GetElemsOfType<ast::ModuleVarsDef>(items)) {
+  for (auto const* var_decl : items.Get<ast::ModuleVarsDef>()) {
     for (auto const& entry : var_decl->entries()) {
       using VisitResult = status::StatusOr<std::pair<NameToken, std::size_t>>;
       ASSIGN_OR_RETURN(
@@ -430,7 +498,7 @@ status::StatusOr<std::unique_ptr<VarTable>> BuildLocalTable(
 }
 
 status::StatusOr<std::unique_ptr<GlobalEnvironment>> BuildGlobalEnvironment(
-    Items global_items, util::SeqView<ModuleLocal const> modules) {
+    ItemIndex const& global_items, util::SeqView<SummaryEntry const> modules) {
   ASSIGN_OR_RETURN(auto selector_table,
                    BuildSelectorTable(global_items, modules));
   ASSIGN_OR_RETURN(auto class_table, BuildClassTable(selector_table.get(),
@@ -442,12 +510,12 @@ status::StatusOr<std::unique_ptr<GlobalEnvironment>> BuildGlobalEnvironment(
 
   return std::make_unique<GlobalEnvironment>(
       std::move(selector_table), std::move(class_table),
-      std::move(extern_table), std::move(global_table), global_items);
+      std::move(extern_table), std::move(global_table), global_items.items());
 }
 
 status::StatusOr<std::unique_ptr<ModuleEnvironment>> BuildModuleEnvironment(
     GlobalEnvironment const* global_env, ScriptNum script_num,
-    std::unique_ptr<CodeGenerator> codegen, Items module_items) {
+    std::unique_ptr<CodeGenerator> codegen, ItemIndex const& module_items) {
   ASSIGN_OR_RETURN(
       auto object_table,
       BuildObjectTable(codegen.get(), global_env->selector_table(),
@@ -467,41 +535,207 @@ status::StatusOr<std::unique_ptr<ModuleEnvironment>> BuildModuleEnvironment(
   return std::make_unique<ModuleEnvironment>(
       global_env, script_num, std::move(codegen), std::move(object_table),
       std::move(proc_table), std::move(public_table), std::move(locals_table),
-      module_items);
+      module_items.items());
+}
+
+// The global environment is built from the summaries of every module,
+// whether it is being compiled or not. A module being compiled takes
+// precedence over a summary given for the same script.
+std::vector<SummaryEntry> MergeSummaries(
+    std::vector<SummaryEntry> compiled,
+    std::vector<ModuleSummary> const& module_summaries) {
+  std::set<ScriptNum> compiled_scripts;
+  for (auto const& entry : compiled) {
+    compiled_scripts.insert(entry.summary->script_num);
+  }
+
+  std::vector<SummaryEntry> summaries = std::move(compiled);
+  for (auto const& summary : module_summaries) {
+    if (compiled_scripts.contains(summary.script_num)) {
+      continue;
+    }
+    summaries.push_back(SummaryEntry{
+        .summary = &summary,
+        .codegen = nullptr,
+    });
+  }
+
+  // New selectors and classes are numbered in the order they are added, so
+  // always process the modules in script order, whatever order they were
+  // given in. This keeps the numbering the same regardless of the order of
+  // the inputs, and of which modules are compiled and which are summarized.
+  std::ranges::stable_sort(summaries, {}, [](SummaryEntry const& entry) {
+    return entry.summary->script_num;
+  });
+  return summaries;
+}
+
+// The result of building a single module environment on a worker thread. If
+// the builder threw, the exception is captured so that it can be rethrown on
+// the calling thread in module order.
+struct ModuleEnvSlot {
+  std::optional<status::StatusOr<std::unique_ptr<ModuleEnvironment>>> result;
+  std::exception_ptr exception;
+};
+
+// Builds the environment for each module. The modules only read from the
+// global environment, and each writes only to its own code generator, so they
+// can be built independently of each other.
+//
+// Results are merged in module order, so the first error reported is the same
+// one that a sequential build would report.
+status::StatusOr<std::vector<std::unique_ptr<ModuleEnvironment>>>
+BuildModuleEnvironments(GlobalEnvironment const* global_env,
+                        std::vector<ModuleLocal>& modules,
+                        std::size_t num_threads) {
+  std::vector<ModuleEnvSlot> slots(modules.size());
+  std::atomic<std::size_t> next_index = 0;
+
+  auto worker = [&] {
+    while (true) {
+      std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+      if (index >= modules.size()) {
+        return;
+      }
+      auto& module = modules[index];
+      try {
+        slots[index].result.emplace(BuildModuleEnvironment(
+            global_env, module.summary.script_num, std::move(module.codegen),
+            module.items));
+      } catch (...) {
+        slots[index].exception = std::current_exception();
+      }
+    }
+  };
+
+  {
+    std::vector<std::thread> threads;
+    if (num_threads > 1) {
+      threads.reserve(num_threads - 1);
+      for (std::size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+      }
+    }
+    // The calling thread participates in the work as well.
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::vector<std::unique_ptr<ModuleEnvironment>> module_envs;
+  module_envs.reserve(slots.size());
+  for (auto& slot : slots) {
+    if (slot.exception) {
+      std::rethrow_exception(slot.exception);
+    }
+    ASSIGN_OR_RETURN(auto module_env, std::move(slot.result).value());
+    module_envs.push_back(std::move(module_env));
+  }
+  return module_envs;
 }
 
 }  // namespace
 
 status::StatusOr<CompilationEnvironment> BuildCompilationEnvironment(
     codegen::CodeGenerator::Options codegen_options, Input const& input) {
-  Items global_items = input.global_items;
+  return BuildCompilationEnvironment(std::move(codegen_options), input,
+                                     CompilationEnvironmentOptions());
+}
+
+status::StatusOr<CompilationEnvironment> BuildCompilationEnvironment(
+    codegen::CodeGenerator::Options codegen_options, Input const& input,
+    CompilationEnvironmentOptions const& options) {
+  // Index each module's items once up front. All of the table builders below
+  // work from these indexes rather than rescanning the item lists.
+  auto global_items = ItemIndex::Build(input.global_items);
   std::vector<ModuleLocal> modules;
   for (auto const& module : input.modules) {
-    ASSIGN_OR_RETURN(auto script_num, GetScriptId(module.module_items));
+    auto items = ItemIndex::Build(module.module_items);
+    ASSIGN_OR_RETURN(auto summary, ModuleSummary::Build(items));
 
     auto codegen = codegen::CodeGenerator::Create(codegen_options);
 
     modules.emplace_back(ModuleLocal{
-        .script_num = script_num,
+        .summary = std::move(summary),
         .codegen = std::move(codegen),
-        .items = module.module_items,
+        .items = std::move(items),
+    });
+  }
+
+  std::vector<SummaryEntry> compiled;
+  for (auto const& module : modules) {
+    compiled.push_back(SummaryEntry{
+        .summary = &module.summary,
+        .codegen = module.codegen.get(),
     });
   }
 
+  auto summaries = MergeSummaries(std::move(compiled), input.module_summaries);
   ASSIGN_OR_RETURN(auto global_env,
-                   BuildGlobalEnvironment(global_items, modules));
+                   BuildGlobalEnvironment(global_items, summaries));
 
   // Now build the module environments.
+  ASSIGN_OR_RETURN(
+      auto built_module_envs,
+      BuildModuleEnvironments(global_env.get(), modules,
+                              std::min(options.num_threads, modules.size())));
   std::map<ScriptNum, std::unique_ptr<ModuleEnvironment>> module_envs;
-  for (auto& module : modules) {
-    ASSIGN_OR_RETURN(
-        auto module_env,
-        BuildModuleEnvironment(global_env.get(), module.script_num,
-                               std::move(module.codegen), module.items));
+  for (auto& module_env : built_module_envs) {
     module_envs.emplace(module_env->script_num(), std::move(module_env));
   }
 
   return CompilationEnvironment(std::move(global_env), std::move(module_envs));
 }
 
-}  // namespace sem
\ No newline at end of file
+status::StatusOr<std::unique_ptr<ModuleEnvironment>>
+StreamingCompilationEnvironment::BuildModuleEnvironment(ScriptNum script_num,
+                                                        Items module_items) {
+  auto it = codegens_.find(script_num);
+  if (it == codegens_.end()) {
+    return status::InvalidArgumentError(absl::StrFormat(
+        "Script %d is not being compiled, or was already built",
+        script_num.value()));
+  }
+  auto codegen = std::move(it->second);
+  codegens_.erase(it);
+
+  return sem::BuildModuleEnvironment(global_env_.get(), script_num,
+                                     std::move(codegen),
+                                     ItemIndex::Build(module_items));
+}
+
+status::StatusOr<StreamingCompilationEnvironment>
+BuildStreamingCompilationEnvironment(
+    codegen::CodeGenerator::Options codegen_options, Items global_items,
+    std::vector<ModuleSummary> const& compiled_modules,
+    std::vector<ModuleSummary> const& module_summaries) {
+  // Each compiled module needs its code generator before the global
+  // environment is built, as the class table refers to the classes a module
+  // defines through it.
+  std::map<ScriptNum, std::unique_ptr<CodeGenerator>> codegens;
+  std::vector<SummaryEntry> compiled;
+  for (auto const& summary : compiled_modules) {
+    auto [it, inserted] = codegens.emplace(
+        summary.script_num, codegen::CodeGenerator::Create(codegen_options));
+    if (!inserted) {
+      return status::InvalidArgumentError(
+          absl::StrFormat("Multiple modules with script number %d",
+                          summary.script_num.value()));
+    }
+    compiled.push_back(SummaryEntry{
+        .summary = &summary,
+        .codegen = it->second.get(),
+    });
+  }
+
+  auto summaries = MergeSummaries(std::move(compiled), module_summaries);
+  ASSIGN_OR_RETURN(auto global_env,
+                   BuildGlobalEnvironment(ItemIndex::Build(global_items),
+                                          summaries));
+
+  return StreamingCompilationEnvironment(std::move(global_env),
+                                         std::move(codegens));
+}
+
+}  // namespace sem
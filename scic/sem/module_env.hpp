@@ -12,6 +12,7 @@
 #include "scic/sem/common.hpp"
 #include "scic/sem/extern_table.hpp"
 #include "scic/sem/input.hpp"
+#include "scic/sem/module_summary.hpp"
 #include "scic/sem/object_table.hpp"
 #include "scic/sem/proc_table.hpp"
 #include "scic/sem/public_table.hpp"
@@ -114,6 +115,35 @@ class CompilationEnvironment {
   std::map<ScriptNum, std::unique_ptr<ModuleEnvironment>> module_envs_;
 };
 
+// A compilation environment that builds its module environments one at a
+// time, on request.
+//
+// The global environment is built up front from the summaries of the modules,
+// so a module's items only need to be available while its own environment is
+// built and its code generated. This lets the caller drop each module's items
+// and environment as soon as its output is written, rather than keeping every
+// module alive until the end of the build.
+class StreamingCompilationEnvironment {
+ public:
+  StreamingCompilationEnvironment(
+      std::unique_ptr<GlobalEnvironment> global_env,
+      std::map<ScriptNum, std::unique_ptr<codegen::CodeGenerator>> codegens)
+      : global_env_(std::move(global_env)), codegens_(std::move(codegens)) {}
+
+  GlobalEnvironment const* global_env() const { return global_env_.get(); }
+
+  // Builds the environment of one of the modules being compiled. The module
+  // environment takes ownership of the module's code generator, so each
+  // module can only be built once. The items must outlive the result.
+  status::StatusOr<std::unique_ptr<ModuleEnvironment>> BuildModuleEnvironment(
+      ScriptNum script_num, Items module_items);
+
+ private:
+  std::unique_ptr<GlobalEnvironment> global_env_;
+  // The code generators of the modules that have not been built yet.
+  std::map<ScriptNum, std::unique_ptr<codegen::CodeGenerator>> codegens_;
+};
+
 // The environment of code compilation within a specific procedure.
 class ProcedureEnvironment {
  public:
@@ -151,9 +181,33 @@ class ProcedureEnvironment {
   ProcName proc_context_;
 };
 
+struct CompilationEnvironmentOptions {
+  // The maximum number of threads to use when building the per-module
+  // environments. A value of 0 or 1 builds them sequentially on the calling
+  // thread.
+  std::size_t num_threads = 1;
+};
+
 status::StatusOr<CompilationEnvironment> BuildCompilationEnvironment(
     codegen::CodeGenerator::Options codegen_options, Input const& input);
 
+// As above, but with explicit options. The result (including which error is
+// reported, if any) is identical to the sequential build, regardless of the
+// number of threads used.
+status::StatusOr<CompilationEnvironment> BuildCompilationEnvironment(
+    codegen::CodeGenerator::Options codegen_options, Input const& input,
+    CompilationEnvironmentOptions const& options);
+
+// Builds a streaming environment for the modules summarized by
+// `compiled_modules`. The modules in `module_summaries` only contribute to the
+// global environment, as with Input::module_summaries. The global items must
+// outlive the result.
+status::StatusOr<StreamingCompilationEnvironment>
+BuildStreamingCompilationEnvironment(
+    codegen::CodeGenerator::Options codegen_options, Items global_items,
+    std::vector<ModuleSummary> const& compiled_modules,
+    std::vector<ModuleSummary> const& module_summaries);
+
 }  // namespace sem
 
 #endif
\ No newline at end of file
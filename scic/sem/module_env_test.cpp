@@ -0,0 +1,152 @@
+#include "scic/sem/module_env.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/codegen/code_generator.hpp"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/input.hpp"
+#include "scic/sem/item_index.hpp"
+#include "scic/sem/module_summary.hpp"
+#include "scic/sem/test_helpers.hpp"
+
+namespace sem {
+namespace {
+
+// The selector and species numbers assigned by a global environment, by name.
+struct Numbering {
+  std::map<std::string, int> selectors;
+  std::map<std::string, int> species;
+};
+
+class ModuleEnvTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    global_items_ = ParseItemsOrDie(R"(
+        (selectors
+            -objID- 4096
+            -size- 4097
+            -propDict- 4098
+            -methDict- 4099
+            -classScript- 4100
+            -script- 4101
+            -super- 4102
+            -info- 4103
+            name 20
+            init 21
+            dispose 22)
+    )");
+    // Each module adds selectors and classes of its own. The scripts are
+    // deliberately given out of order.
+    modules_.push_back(ParseItemsOrDie(R"(
+        (script# 3)
+        (class Third of First
+            (properties
+                third 0)
+            (method (thirdMethod) (return)))
+    )"));
+    modules_.push_back(ParseItemsOrDie(R"(
+        (script# 1)
+        (class First
+            (properties
+                first 0
+                shared 0)
+            (method (init) (return))
+            (method (firstMethod) (return)))
+    )"));
+    modules_.push_back(ParseItemsOrDie(R"(
+        (script# 4)
+        (class Fourth of Second
+            (properties
+                fourth 0
+                shared 0)
+            (method (fourthMethod) (return)))
+    )"));
+    modules_.push_back(ParseItemsOrDie(R"(
+        (script# 2)
+        (class Second
+            (properties
+                second 0)
+            (method (dispose) (return))
+            (method (secondMethod) (return)))
+    )"));
+  }
+
+  // Builds the environment, compiling the modules at the given indexes and
+  // summarizing the rest, and returns the numbers it assigned.
+  Numbering BuildNumbering(std::vector<std::size_t> const& compiled) {
+    Input input;
+    input.global_items = global_items_;
+    for (std::size_t i = 0; i < modules_.size(); ++i) {
+      if (std::ranges::find(compiled, i) != compiled.end()) {
+        input.modules.push_back(Input::Module{.module_items = modules_[i]});
+      } else {
+        auto summary = ModuleSummary::Build(ItemIndex::Build(modules_[i]));
+        EXPECT_TRUE(summary.ok());
+        input.module_summaries.push_back(std::move(summary).value());
+      }
+    }
+
+    codegen::CodeGenerator::Options options{
+        .target = codegen::SciTarget::SCI_2,
+        .opt = codegen::Optimization::OPTIMIZE,
+    };
+    auto env = BuildCompilationEnvironment(options, input);
+    EXPECT_TRUE(env.ok());
+    if (!env.ok()) {
+      return {};
+    }
+
+    Numbering numbering;
+    auto const* global_env = env.value().global_env();
+    for (auto const& entry : global_env->selector_table()->entries()) {
+      numbering.selectors.emplace(entry.name(), entry.selector_num().value());
+    }
+    for (auto const* name : {"First", "Second", "Third", "Fourth"}) {
+      auto const* cls = global_env->class_table()->LookupByName(name);
+      EXPECT_NE(cls, nullptr) << name;
+      if (cls) {
+        numbering.species.emplace(name, cls->species().value());
+      }
+    }
+    return numbering;
+  }
+
+  std::vector<ast::Item> global_items_;
+  std::vector<std::vector<ast::Item>> modules_;
+};
+
+TEST_F(ModuleEnvTest, NumberingIsTheSameWhenModulesAreSummarized) {
+  auto full = BuildNumbering({0, 1, 2, 3});
+  ASSERT_EQ(full.species.size(), 4);
+
+  // Compile half of the modules and summarize the others, each way round,
+  // and then compile fewer still.
+  std::vector<std::vector<std::size_t>> compiled_sets = {
+      {1, 3}, {0, 2}, {2}, {}};
+  for (auto const& compiled : compiled_sets) {
+    auto numbering = BuildNumbering(compiled);
+    EXPECT_EQ(numbering.selectors, full.selectors);
+    EXPECT_EQ(numbering.species, full.species);
+  }
+}
+
+TEST_F(ModuleEnvTest, NumberingFollowsScriptOrder) {
+  auto full = BuildNumbering({0, 1, 2, 3});
+
+  EXPECT_LT(full.species["First"], full.species["Second"]);
+  EXPECT_LT(full.species["Second"], full.species["Third"]);
+  EXPECT_LT(full.species["Third"], full.species["Fourth"]);
+
+  EXPECT_LT(full.selectors["firstMethod"], full.selectors["secondMethod"]);
+  EXPECT_LT(full.selectors["secondMethod"], full.selectors["thirdMethod"]);
+  EXPECT_LT(full.selectors["thirdMethod"], full.selectors["fourthMethod"]);
+}
+
+}  // namespace
+}  // namespace sem
@@ -0,0 +1,445 @@
+#include "scic/sem/module_summary.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/common.hpp"
+#include "scic/sem/item_index.hpp"
+#include "scic/status/status.hpp"
+#include "scic/text/text_range.hpp"
+#include "scic/tokens/token_source.hpp"
+#include "util/status/status_macros.hpp"
+#include "util/strings/ref_str.hpp"
+
+namespace sem {
+namespace {
+
+// The serialized form starts with this magic string, followed by a version
+// number. The version must be bumped whenever the layout changes.
+constexpr std::string_view kSummaryMagic = "SCMS";
+constexpr std::uint32_t kSummaryVersion = 2;
+
+// Tags for the kind of a property value.
+constexpr std::uint8_t kNumPropertyTag = 0;
+constexpr std::uint8_t kStringPropertyTag = 1;
+
+status::StatusOr<ScriptNum> GetScriptNum(ItemIndex const& items) {
+  auto result = items.Get<ast::ScriptNumDef>();
+
+  if (result.size() == 0) {
+    return status::InvalidArgumentError("No script number defined");
+  } else if (result.size() > 1) {
+    return status::InvalidArgumentError("Multiple script numbers defined");
+  }
+
+  return ScriptNum::Create(result[0]->script_num().value());
+}
+
+std::vector<ModuleSummary::Property> SummarizeProperties(
+    absl::Span<ast::PropertyDef const> properties) {
+  std::vector<ModuleSummary::Property> result;
+  for (auto const& prop : properties) {
+    auto value = prop.value.visit(
+        [](ast::NumConstValue const& num) -> ModuleSummary::PropertyValue {
+          return num.value().value();
+        },
+        [](ast::StringConstValue const& str) -> ModuleSummary::PropertyValue {
+          return std::string(str.value().value().view());
+        });
+    result.push_back(ModuleSummary::Property{
+        .name = prop.name,
+        .value = std::move(value),
+    });
+  }
+  return result;
+}
+
+// Little-endian, fixed width encoding. Lengths precede strings and lists.
+class SummaryWriter {
+ public:
+  void WriteU8(std::uint8_t value) { out_.push_back(char(value)); }
+
+  void WriteU32(std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      WriteU8(value & 0xFF);
+      value >>= 8;
+    }
+  }
+
+  void WriteInt(int value) { WriteU32(std::uint32_t(value)); }
+
+  void WriteString(std::string_view str) {
+    WriteU32(str.size());
+    out_.append(str);
+  }
+
+  void WriteName(NameToken const& name) { WriteString(name.value()); }
+
+  void WriteNames(std::vector<NameToken> const& names) {
+    WriteU32(names.size());
+    for (auto const& name : names) {
+      WriteName(name);
+    }
+  }
+
+  void WriteProperties(std::vector<ModuleSummary::Property> const& props) {
+    WriteU32(props.size());
+    for (auto const& prop : props) {
+      WriteName(prop.name);
+      prop.value.visit(
+          [&](int num) {
+            WriteU8(kNumPropertyTag);
+            WriteInt(num);
+          },
+          [&](std::string const& str) {
+            WriteU8(kStringPropertyTag);
+            WriteString(str);
+          });
+    }
+  }
+
+  std::string Finish() && { return std::move(out_); }
+
+ private:
+  std::string out_;
+};
+
+class SummaryReader {
+ public:
+  SummaryReader(std::string_view data, util::RefStr source_name)
+      : data_(data), source_name_(std::move(source_name)) {}
+
+  bool AtEnd() const { return data_.empty(); }
+
+  status::StatusOr<std::uint8_t> ReadU8() {
+    if (data_.empty()) {
+      return Truncated();
+    }
+    auto value = std::uint8_t(data_[0]);
+    data_.remove_prefix(1);
+    return value;
+  }
+
+  status::StatusOr<std::uint32_t> ReadU32() {
+    if (data_.size() < 4) {
+      return Truncated();
+    }
+    std::uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+      value = (value << 8) | std::uint8_t(data_[i]);
+    }
+    data_.remove_prefix(4);
+    return value;
+  }
+
+  status::StatusOr<int> ReadInt() {
+    ASSIGN_OR_RETURN(auto value, ReadU32());
+    return int(std::int32_t(value));
+  }
+
+  status::StatusOr<std::string_view> ReadString() {
+    ASSIGN_OR_RETURN(auto size, ReadU32());
+    if (data_.size() < size) {
+      return Truncated();
+    }
+    auto str = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return str;
+  }
+
+  status::StatusOr<NameToken> ReadName() {
+    ASSIGN_OR_RETURN(auto name, ReadString());
+    return NameToken(util::RefStr(name),
+                     tokens::TokenSource(text::TextRange::WithFilename(
+                         source_name_, std::string(name))));
+  }
+
+  status::StatusOr<std::vector<NameToken>> ReadNames() {
+    ASSIGN_OR_RETURN(auto count, ReadU32());
+    std::vector<NameToken> names;
+    for (std::uint32_t i = 0; i < count; ++i) {
+      ASSIGN_OR_RETURN(auto name, ReadName());
+      names.push_back(std::move(name));
+    }
+    return names;
+  }
+
+  status::StatusOr<std::vector<ModuleSummary::Property>> ReadProperties() {
+    ASSIGN_OR_RETURN(auto count, ReadU32());
+    std::vector<ModuleSummary::Property> props;
+    for (std::uint32_t i = 0; i < count; ++i) {
+      ASSIGN_OR_RETURN(auto name, ReadName());
+      ASSIGN_OR_RETURN(auto tag, ReadU8());
+      ModuleSummary::PropertyValue value;
+      switch (tag) {
+        case kNumPropertyTag: {
+          ASSIGN_OR_RETURN(value, ReadInt());
+          break;
+        }
+        case kStringPropertyTag: {
+          ASSIGN_OR_RETURN(auto str, ReadString());
+          value = std::string(str);
+          break;
+        }
+        default:
+          return status::InvalidArgumentError(absl::StrFormat(
+              "Invalid property kind %d in module summary: %s", tag,
+              source_name_));
+      }
+      props.push_back(ModuleSummary::Property{
+          .name = std::move(name),
+          .value = std::move(value),
+      });
+    }
+    return props;
+  }
+
+ private:
+  status::Status Truncated() const {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Truncated module summary: %s", source_name_));
+  }
+
+  std::string_view data_;
+  util::RefStr source_name_;
+};
+
+}  // namespace
+
+status::StatusOr<ModuleSummary> ModuleSummary::Build(ItemIndex const& items) {
+  ASSIGN_OR_RETURN(auto script_num, GetScriptNum(items));
+
+  std::vector<DeclaredSelector> declared_selectors;
+  for (auto const* selectors_decl : items.Get<ast::SelectorsDecl>()) {
+    for (auto const& selector : selectors_decl->selectors()) {
+      declared_selectors.push_back(DeclaredSelector{
+          .name = selector.name,
+          .selector_num = SelectorNum::Create(selector.id.value()),
+      });
+    }
+  }
+
+  std::vector<NameToken> new_selectors;
+  std::vector<ClassDef> class_defs;
+  for (auto const* class_def : items.Get<ast::ClassDef>()) {
+    for (auto const& prop : class_def->properties()) {
+      new_selectors.push_back(prop.name);
+    }
+    for (auto const& method : class_def->methods()) {
+      new_selectors.push_back(method.name());
+    }
+
+    if (class_def->kind() != ast::ClassDef::CLASS) {
+      continue;
+    }
+
+    auto properties = SummarizeProperties(class_def->properties());
+    std::vector<NameToken> methods;
+    for (auto const& method : class_def->methods()) {
+      methods.push_back(method.name());
+    }
+    class_defs.push_back(ClassDef{
+        .name = class_def->name(),
+        .super_name = class_def->parent(),
+        .properties = std::move(properties),
+        .methods = std::move(methods),
+    });
+  }
+
+  std::vector<ClassDecl> class_decls;
+  for (auto const* class_decl : items.Get<ast::ClassDecl>()) {
+    auto properties = SummarizeProperties(class_decl->properties());
+    std::optional<ClassSpecies> super_species;
+    if (class_decl->parent_num()) {
+      super_species = ClassSpecies::Create(class_decl->parent_num()->value());
+    }
+    class_decls.push_back(ClassDecl{
+        .name = class_decl->name(),
+        .script_num = ScriptNum::Create(class_decl->script_num().value()),
+        .species = ClassSpecies::Create(class_decl->class_num().value()),
+        .super_species = super_species,
+        .properties = std::move(properties),
+        .methods = class_decl->method_names().names,
+    });
+  }
+
+  std::vector<PublicEntry> publics;
+  for (auto const* public_def : items.Get<ast::PublicDef>()) {
+    for (auto const& entry : public_def->entries()) {
+      if (entry.index.value() < 0) {
+        return status::InvalidArgumentError(
+            "Public index must be 0 or greater");
+      }
+      publics.push_back(PublicEntry{
+          .name = entry.name,
+          .index = PublicIndex::Create(entry.index.value()),
+      });
+    }
+  }
+
+  return ModuleSummary{
+      .script_num = script_num,
+      .declared_selectors = std::move(declared_selectors),
+      .new_selectors = std::move(new_selectors),
+      .class_decls = std::move(class_decls),
+      .class_defs = std::move(class_defs),
+      .publics = std::move(publics),
+  };
+}
+
+std::string ModuleSummary::Serialize() const {
+  SummaryWriter writer;
+  for (char c : kSummaryMagic) {
+    writer.WriteU8(c);
+  }
+  writer.WriteU32(kSummaryVersion);
+  writer.WriteU32(script_num.value());
+
+  writer.WriteU32(declared_selectors.size());
+  for (auto const& selector : declared_selectors) {
+    writer.WriteName(selector.name);
+    writer.WriteU32(selector.selector_num.value());
+  }
+
+  writer.WriteNames(new_selectors);
+
+  writer.WriteU32(class_decls.size());
+  for (auto const& decl : class_decls) {
+    writer.WriteName(decl.name);
+    writer.WriteU32(decl.script_num.value());
+    writer.WriteU32(decl.species.value());
+    writer.WriteU8(decl.super_species.has_value());
+    if (decl.super_species) {
+      writer.WriteU32(decl.super_species->value());
+    }
+    writer.WriteProperties(decl.properties);
+    writer.WriteNames(decl.methods);
+  }
+
+  writer.WriteU32(class_defs.size());
+  for (auto const& def : class_defs) {
+    writer.WriteName(def.name);
+    writer.WriteU8(def.super_name.has_value());
+    if (def.super_name) {
+      writer.WriteName(*def.super_name);
+    }
+    writer.WriteProperties(def.properties);
+    writer.WriteNames(def.methods);
+  }
+
+  writer.WriteU32(publics.size());
+  for (auto const& entry : publics) {
+    writer.WriteName(entry.name);
+    writer.WriteU32(entry.index.value());
+  }
+
+  return std::move(writer).Finish();
+}
+
+status::StatusOr<ModuleSummary> ModuleSummary::Deserialize(
+    std::string_view data, util::RefStr const& source_name) {
+  if (!data.starts_with(kSummaryMagic)) {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Not a module summary: %s", source_name));
+  }
+  SummaryReader reader(data.substr(kSummaryMagic.size()), source_name);
+
+  ASSIGN_OR_RETURN(auto version, reader.ReadU32());
+  if (version != kSummaryVersion) {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Unsupported module summary version %d: %s", version,
+                        source_name));
+  }
+
+  ASSIGN_OR_RETURN(auto script_num, reader.ReadU32());
+
+  ASSIGN_OR_RETURN(auto num_declared_selectors, reader.ReadU32());
+  std::vector<DeclaredSelector> declared_selectors;
+  for (std::uint32_t i = 0; i < num_declared_selectors; ++i) {
+    ASSIGN_OR_RETURN(auto name, reader.ReadName());
+    ASSIGN_OR_RETURN(auto selector_num, reader.ReadU32());
+    declared_selectors.push_back(DeclaredSelector{
+        .name = std::move(name),
+        .selector_num = SelectorNum::Create(selector_num),
+    });
+  }
+
+  ASSIGN_OR_RETURN(auto new_selectors, reader.ReadNames());
+
+  ASSIGN_OR_RETURN(auto num_class_decls, reader.ReadU32());
+  std::vector<ClassDecl> class_decls;
+  for (std::uint32_t i = 0; i < num_class_decls; ++i) {
+    ASSIGN_OR_RETURN(auto name, reader.ReadName());
+    ASSIGN_OR_RETURN(auto decl_script_num, reader.ReadU32());
+    ASSIGN_OR_RETURN(auto species, reader.ReadU32());
+    ASSIGN_OR_RETURN(auto has_super, reader.ReadU8());
+    std::optional<ClassSpecies> super_species;
+    if (has_super) {
+      ASSIGN_OR_RETURN(auto super_num, reader.ReadU32());
+      super_species = ClassSpecies::Create(super_num);
+    }
+    ASSIGN_OR_RETURN(auto properties, reader.ReadProperties());
+    ASSIGN_OR_RETURN(auto methods, reader.ReadNames());
+    class_decls.push_back(ClassDecl{
+        .name = std::move(name),
+        .script_num = ScriptNum::Create(decl_script_num),
+        .species = ClassSpecies::Create(species),
+        .super_species = super_species,
+        .properties = std::move(properties),
+        .methods = std::move(methods),
+    });
+  }
+
+  ASSIGN_OR_RETURN(auto num_class_defs, reader.ReadU32());
+  std::vector<ClassDef> class_defs;
+  for (std::uint32_t i = 0; i < num_class_defs; ++i) {
+    ASSIGN_OR_RETURN(auto name, reader.ReadName());
+    ASSIGN_OR_RETURN(auto has_super, reader.ReadU8());
+    std::optional<NameToken> super_name;
+    if (has_super) {
+      ASSIGN_OR_RETURN(super_name, reader.ReadName());
+    }
+    ASSIGN_OR_RETURN(auto properties, reader.ReadProperties());
+    ASSIGN_OR_RETURN(auto methods, reader.ReadNames());
+    class_defs.push_back(ClassDef{
+        .name = std::move(name),
+        .super_name = std::move(super_name),
+        .properties = std::move(properties),
+        .methods = std::move(methods),
+    });
+  }
+
+  ASSIGN_OR_RETURN(auto num_publics, reader.ReadU32());
+  std::vector<PublicEntry> publics;
+  for (std::uint32_t i = 0; i < num_publics; ++i) {
+    ASSIGN_OR_RETURN(auto name, reader.ReadName());
+    ASSIGN_OR_RETURN(auto index, reader.ReadU32());
+    publics.push_back(PublicEntry{
+        .name = std::move(name),
+        .index = PublicIndex::Create(index),
+    });
+  }
+
+  if (!reader.AtEnd()) {
+    return status::InvalidArgumentError(
+        absl::StrFormat("Trailing data in module summary: %s", source_name));
+  }
+
+  return ModuleSummary{
+      .script_num = ScriptNum::Create(script_num),
+      .declared_selectors = std::move(declared_selectors),
+      .new_selectors = std::move(new_selectors),
+      .class_decls = std::move(class_decls),
+      .class_defs = std::move(class_defs),
+      .publics = std::move(publics),
+  };
+}
+
+}  // namespace sem
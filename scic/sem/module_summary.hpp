@@ -0,0 +1,87 @@
+#ifndef SEM_MODULE_SUMMARY_HPP
+#define SEM_MODULE_SUMMARY_HPP
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scic/sem/common.hpp"
+#include "scic/sem/item_index.hpp"
+#include "scic/status/status.hpp"
+#include "util/strings/ref_str.hpp"
+#include "util/types/choice.hpp"
+
+namespace sem {
+
+// A summary of everything a module contributes to the global environment.
+//
+// The global environment (selectors and classes) depends on every module in
+// the game, but only on a small part of each one. A summary captures just that
+// part, so that a module can be compiled against the summaries of the other
+// modules, rather than having to parse all of them.
+//
+// Summaries can be written to and read from a compact binary form.
+struct ModuleSummary {
+  struct DeclaredSelector {
+    NameToken name;
+    SelectorNum selector_num;
+  };
+
+  // A property's initial value. Strings are kept as text, as they only become
+  // text nodes in the code generator of the module being compiled.
+  using PropertyValue = util::Choice<int, std::string>;
+
+  struct Property {
+    NameToken name;
+    PropertyValue value;
+  };
+
+  // A (classdef) declaration that appeared in the module.
+  struct ClassDecl {
+    NameToken name;
+    ScriptNum script_num;
+    ClassSpecies species;
+    std::optional<ClassSpecies> super_species;
+    std::vector<Property> properties;
+    std::vector<NameToken> methods;
+  };
+
+  // A (class) definition exported by the module. Species are not included,
+  // as new classes are assigned species when the class table is built.
+  struct ClassDef {
+    NameToken name;
+    std::optional<NameToken> super_name;
+    std::vector<Property> properties;
+    std::vector<NameToken> methods;
+  };
+
+  struct PublicEntry {
+    NameToken name;
+    PublicIndex index;
+  };
+
+  // Summarizes a parsed module. Fails if the module does not have exactly one
+  // script number.
+  static status::StatusOr<ModuleSummary> Build(ItemIndex const& items);
+
+  // Parses a summary previously written by Serialize(). The source name is
+  // used as the filename of the names in the summary, for diagnostics.
+  static status::StatusOr<ModuleSummary> Deserialize(
+      std::string_view data, util::RefStr const& source_name);
+
+  std::string Serialize() const;
+
+  ScriptNum script_num;
+  // Selectors with explicitly assigned numbers.
+  std::vector<DeclaredSelector> declared_selectors;
+  // Selectors used by classes and objects in the module, in source order.
+  std::vector<NameToken> new_selectors;
+  std::vector<ClassDecl> class_decls;
+  std::vector<ClassDef> class_defs;
+  std::vector<PublicEntry> publics;
+};
+
+}  // namespace sem
+
+#endif
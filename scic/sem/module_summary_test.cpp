@@ -0,0 +1,138 @@
+#include "scic/sem/module_summary.hpp"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/sem/common.hpp"
+#include "scic/sem/item_index.hpp"
+#include "scic/sem/test_helpers.hpp"
+
+namespace sem {
+namespace {
+
+TEST(ModuleSummaryTest, RequiresScriptNum) {
+  auto items = ParseItemsOrDie(R"(
+      (procedure (foo) (return))
+  )");
+  EXPECT_FALSE(ModuleSummary::Build(ItemIndex::Build(items)).ok());
+}
+
+TEST(ModuleSummaryTest, SummarizesExports) {
+  auto items = ParseItemsOrDie(R"(
+      (script# 10)
+      (public
+          Foo 0
+          bar 1)
+      (procedure (bar) (return))
+      (class Foo of Object
+          (properties x 1 y 2)
+          (method (doit) (return)))
+      (instance baz of Foo
+          (properties z 3))
+  )");
+  auto summary = ModuleSummary::Build(ItemIndex::Build(items));
+  ASSERT_TRUE(summary.ok());
+
+  EXPECT_EQ(summary->script_num.value(), 10);
+
+  ASSERT_EQ(summary->class_defs.size(), 1);
+  auto const& foo = summary->class_defs[0];
+  EXPECT_EQ(foo.name.value(), "Foo");
+  ASSERT_TRUE(foo.super_name.has_value());
+  EXPECT_EQ(foo.super_name->value(), "Object");
+  ASSERT_EQ(foo.properties.size(), 2);
+  EXPECT_EQ(foo.properties[1].name.value(), "y");
+  EXPECT_EQ(foo.properties[1].value.as<int>(), 2);
+  ASSERT_EQ(foo.methods.size(), 1);
+  EXPECT_EQ(foo.methods[0].value(), "doit");
+
+  // Selectors from both classes and instances are included, in source order.
+  ASSERT_EQ(summary->new_selectors.size(), 4);
+  EXPECT_EQ(summary->new_selectors[0].value(), "x");
+  EXPECT_EQ(summary->new_selectors[2].value(), "doit");
+  EXPECT_EQ(summary->new_selectors[3].value(), "z");
+
+  ASSERT_EQ(summary->publics.size(), 2);
+  EXPECT_EQ(summary->publics[1].name.value(), "bar");
+  EXPECT_EQ(summary->publics[1].index.value(), 1);
+}
+
+TEST(ModuleSummaryTest, SerializationRoundTrips) {
+  auto items = ParseItemsOrDie(R"(
+      (script# 3)
+      (selectors
+          foo 40)
+      (class Foo of Object
+          (properties x -1)
+          (method (foo) (return)))
+      (class Bar
+          (properties))
+  )");
+  auto summary = ModuleSummary::Build(ItemIndex::Build(items));
+  ASSERT_TRUE(summary.ok());
+
+  auto data = summary->Serialize();
+  auto parsed = ModuleSummary::Deserialize(data, util::RefStr("3.sum"));
+  ASSERT_TRUE(parsed.ok());
+
+  EXPECT_EQ(parsed->script_num.value(), 3);
+  ASSERT_EQ(parsed->declared_selectors.size(), 1);
+  EXPECT_EQ(parsed->declared_selectors[0].name.value(), "foo");
+  EXPECT_EQ(parsed->declared_selectors[0].selector_num.value(), 40);
+  ASSERT_EQ(parsed->class_defs.size(), 2);
+  EXPECT_EQ(parsed->class_defs[0].properties[0].value.as<int>(), -1);
+  EXPECT_FALSE(parsed->class_defs[1].super_name.has_value());
+  EXPECT_EQ(parsed->new_selectors.size(), summary->new_selectors.size());
+
+  // Serializing the parsed summary gives back identical bytes.
+  EXPECT_EQ(parsed->Serialize(), data);
+}
+
+TEST(ModuleSummaryTest, KeepsStringProperties) {
+  auto items = ParseItemsOrDie(R"(
+      (script# 4)
+      (class Foo of Object
+          (properties
+              x 2
+              name "foo"))
+  )");
+  auto summary = ModuleSummary::Build(ItemIndex::Build(items));
+  ASSERT_TRUE(summary.ok());
+
+  ASSERT_EQ(summary->class_defs.size(), 1);
+  auto const& foo = summary->class_defs[0];
+  ASSERT_EQ(foo.properties.size(), 2);
+  EXPECT_EQ(foo.properties[0].value.as<int>(), 2);
+  ASSERT_TRUE(foo.properties[1].value.has<std::string>());
+  EXPECT_EQ(foo.properties[1].value.as<std::string>(), "foo");
+
+  auto data = summary->Serialize();
+  auto parsed = ModuleSummary::Deserialize(data, util::RefStr("4.sum"));
+  ASSERT_TRUE(parsed.ok());
+  ASSERT_EQ(parsed->class_defs.size(), 1);
+  EXPECT_EQ(parsed->class_defs[0].properties[1].value.as<std::string>(), "foo");
+  EXPECT_EQ(parsed->Serialize(), data);
+}
+
+TEST(ModuleSummaryTest, RejectsCorruptData) {
+  auto items = ParseItemsOrDie(R"(
+      (script# 3)
+      (class Foo of Object
+          (properties x 1))
+  )");
+  auto summary = ModuleSummary::Build(ItemIndex::Build(items));
+  ASSERT_TRUE(summary.ok());
+  auto data = summary->Serialize();
+
+  EXPECT_FALSE(
+      ModuleSummary::Deserialize(data.substr(0, data.size() - 1),
+                                 util::RefStr("3.sum"))
+          .ok());
+  EXPECT_FALSE(
+      ModuleSummary::Deserialize("not a summary", util::RefStr("3.sum")).ok());
+}
+
+}  // namespace
+}  // namespace sem
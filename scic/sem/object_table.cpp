@@ -1,7 +1,5 @@
 #include "scic/sem/object_table.hpp"
 
-#include <functional>
-#include <map>
 #include <memory>
 #include <string_view>
 #include <utility>
@@ -90,7 +88,7 @@ class ObjectTableImpl : public ObjectTable {
  public:
   ObjectTableImpl(
       std::vector<std::unique_ptr<ObjectImpl>> objects,
-      std::map<std::string_view, ObjectImpl*, std::less<>> name_table)
+      NameMap<ObjectImpl*> name_table)
       : objects_(std::move(objects)), name_table_(std::move(name_table)) {}
 
   Object const* LookupByName(std::string_view objName) const override {
@@ -107,7 +105,7 @@ class ObjectTableImpl : public ObjectTable {
 
  private:
   std::vector<std::unique_ptr<ObjectImpl>> objects_;
-  std::map<std::string_view, ObjectImpl*, std::less<>> name_table_;
+  NameMap<ObjectImpl*> name_table_;
 };
 
 class ObjectTableBuilderImpl : public ObjectTableBuilder {
@@ -176,7 +174,7 @@ class ObjectTableBuilderImpl : public ObjectTableBuilder {
   SelectorTable const* absl_nonnull selector_;
   ClassTable const* absl_nonnull class_table_;
   std::vector<std::unique_ptr<ObjectImpl>> objects_;
-  std::map<std::string_view, ObjectImpl*, std::less<>> name_table_;
+  NameMap<ObjectImpl*> name_table_;
 };
 }  // namespace
 
@@ -1,7 +1,5 @@
 #include "scic/sem/proc_table.hpp"
 
-#include <functional>
-#include <map>
 #include <memory>
 #include <string_view>
 #include <utility>
@@ -35,7 +33,7 @@ class ProcTableImpl : public ProcTable {
  public:
   explicit ProcTableImpl(
       std::vector<std::unique_ptr<ProcedureImpl>> procedures,
-      std::map<std::string_view, ProcedureImpl*, std::less<>> name_table)
+      NameMap<ProcedureImpl*> name_table)
       : procedures_(std::move(procedures)),
         name_table_(std::move(name_table)) {}
 
@@ -53,7 +51,7 @@ class ProcTableImpl : public ProcTable {
 
  private:
   std::vector<std::unique_ptr<ProcedureImpl>> procedures_;
-  std::map<std::string_view, ProcedureImpl*, std::less<>> name_table_;
+  NameMap<ProcedureImpl*> name_table_;
 };
 
 class ProcTableBuilderImpl : public ProcTableBuilder {
@@ -77,7 +75,7 @@ class ProcTableBuilderImpl : public ProcTableBuilder {
  private:
   codegen::CodeGenerator* absl_nonnull codegen_;
   std::vector<std::unique_ptr<ProcedureImpl>> procedures_;
-  std::map<std::string_view, ProcedureImpl*, std::less<>> name_table_;
+  NameMap<ProcedureImpl*> name_table_;
 };
 }  // namespace
 
@@ -1,6 +1,7 @@
 #include "scic/sem/property_list.hpp"
 
 #include <cstddef>
+#include <deque>
 #include <memory>
 #include <string_view>
 #include <utility>
@@ -15,28 +16,68 @@
 
 namespace sem {
 
+// A layout is a node in a chain: it holds the properties added on top of
+// its parent's layout. Nodes are never modified once shared, so a node can be
+// the parent of the layouts of every subclass and instance of a class.
+class PropertyList::Layout {
+ public:
+  struct Slot {
+    NameToken name;
+    PropIndex index;
+    SelectorTable::Entry const* selector;
+  };
+
+  explicit Layout(std::shared_ptr<Layout const> parent)
+      : parent_(std::move(parent)),
+        base_size_(parent_ ? parent_->size() : 0) {}
+
+  std::size_t size() const { return base_size_ + slots_.size(); }
+
+  Slot const* LookupByName(std::string_view name) const {
+    for (auto const* layout = this; layout; layout = layout->parent_.get()) {
+      auto it = layout->name_table_.find(name);
+      if (it != layout->name_table_.end()) {
+        return it->second;
+      }
+    }
+    return nullptr;
+  }
+
+  Slot const& AddSlot(NameToken name, SelectorTable::Entry const* selector) {
+    // A deque, so that references to existing slots stay valid.
+    auto& slot = slots_.emplace_back(Slot{
+        .name = std::move(name),
+        .index = PropIndex::Create(size()),
+        .selector = selector,
+    });
+    name_table_.emplace(slot.name.value(), &slot);
+    return slot;
+  }
+
+ private:
+  std::shared_ptr<Layout const> parent_;
+  std::size_t base_size_;
+  std::deque<Slot> slots_;
+  NameMap<Slot const*> name_table_;
+};
+
 class PropertyList::PropertyImpl : public Property {
  public:
-  PropertyImpl(NameToken name, PropIndex prop_index,
-               SelectorTable::Entry const* selector,
-               codegen::LiteralValue value)
-      : name_(std::move(name)),
-        prop_index_(prop_index),
-        selector_(selector),
-        value_(value) {}
-
-  NameToken const& token_name() const override { return name_; }
-  PropIndex index() const override { return prop_index_; }
-  util::RefStr const& name() const override { return name_.value(); }
-  SelectorTable::Entry const* selector() const override { return selector_; }
+  PropertyImpl(Layout::Slot const* slot, codegen::LiteralValue value)
+      : slot_(slot), value_(value) {}
+
+  NameToken const& token_name() const override { return slot_->name; }
+  PropIndex index() const override { return slot_->index; }
+  util::RefStr const& name() const override { return slot_->name.value(); }
+  SelectorTable::Entry const* selector() const override {
+    return slot_->selector;
+  }
   codegen::LiteralValue value() const override { return value_; }
 
   void SetValue(codegen::LiteralValue value) { value_ = value; }
 
  private:
-  NameToken name_;
-  PropIndex prop_index_;
-  SelectorTable::Entry const* selector_;
+  Layout::Slot const* slot_;
   codegen::LiteralValue value_;
 };
 
@@ -59,19 +100,22 @@ PropertyList& PropertyList::operator=(PropertyList&&) = default;
 PropIndex PropertyList::UpdatePropertyDef(NameToken name,
                                           SelectorTable::Entry const* selector,
                                           codegen::LiteralValue value) {
-  auto name_it = name_table_.find(name.value());
-  if (name_it != name_table_.end()) {
-    // The property already exists. Update the value, and return the index.
-    name_it->second->SetValue(value);
-    return name_it->second->index();
+  if (layout_) {
+    if (auto const* slot = layout_->LookupByName(name.value())) {
+      // The property already exists. Update the value, and return the index.
+      properties_[slot->index.value()].SetValue(value);
+      return slot->index;
+    }
   }
 
-  auto new_index = PropIndex::Create(properties_.size());
-  auto new_prop = std::make_unique<PropertyImpl>(std::move(name), new_index,
-                                                 selector, std::move(value));
-  AddToIndex(new_prop.get());
-  properties_.push_back(std::move(new_prop));
-  return new_index;
+  // Other lists may share the current layout, so new properties go into a
+  // layout of our own that extends it.
+  if (!layout_ || layout_.use_count() > 1) {
+    layout_ = std::make_shared<Layout>(std::move(layout_));
+  }
+  auto const& slot = layout_->AddSlot(std::move(name), selector);
+  properties_.emplace_back(&slot, std::move(value));
+  return slot.index;
 }
 
 PropIndex PropertyList::UpdatePropertyDef(SelectorTable::Entry const* selector,
@@ -80,46 +124,36 @@ PropIndex PropertyList::UpdatePropertyDef(SelectorTable::Entry const* selector,
 }
 
 PropertyList PropertyList::Clone() const {
-  std::vector<std::unique_ptr<PropertyImpl>> new_properties;
-  for (auto& prop : properties_) {
-    auto new_prop = std::make_unique<PropertyImpl>(
-        prop->token_name(), prop->index(), prop->selector(), prop->value());
+  std::vector<PropertyImpl> new_properties = properties_;
+  for (auto& prop : new_properties) {
     // Text values don't copy between classes/objects because property pointers
     // don't work between different scripts. If the property has
     // a text value, we set it to a default value. Assume that the value will
     // be overwritten later, if necessary.
-    if (new_prop->value().has<codegen::TextRef>()) {
-      new_prop->SetValue(codegen::LiteralValue(0));
+    if (prop.value().has<codegen::TextRef>()) {
+      prop.SetValue(codegen::LiteralValue(0));
     }
-    new_properties.push_back(std::move(new_prop));
   }
-  return PropertyList(std::move(new_properties));
+  return PropertyList(layout_, std::move(new_properties));
 }
 
 util::Seq<Property const&> PropertyList::properties() const {
-  return util::Seq<Property const&>::Deref(properties_);
+  return util::Seq<Property const&>(properties_);
 }
 std::size_t PropertyList::size() const { return properties_.size(); }
 Property const* PropertyList::LookupByName(std::string_view name) const {
-  auto it = name_table_.find(name);
-  if (it == name_table_.end()) {
+  if (!layout_) {
     return nullptr;
   }
-  return it->second;
-}
-
-PropertyList::PropertyList(
-    std::vector<std::unique_ptr<PropertyImpl>> properties)
-    : properties_(std::move(properties)) {
-  for (auto& prop : properties_) {
-    AddToIndex(prop.get());
+  auto const* slot = layout_->LookupByName(name);
+  if (!slot) {
+    return nullptr;
   }
+  return &properties_[slot->index.value()];
 }
 
-void PropertyList::AddToIndex(PropertyImpl* prop) {
-  name_table_.emplace(prop->name(), prop);
-  selector_table_.emplace(prop->selector(), prop);
-  index_table_.emplace(prop->index(), prop);
-}
+PropertyList::PropertyList(std::shared_ptr<Layout> layout,
+                           std::vector<PropertyImpl> properties)
+    : layout_(std::move(layout)), properties_(std::move(properties)) {}
 
 }  // namespace sem
\ No newline at end of file
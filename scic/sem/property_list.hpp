@@ -2,8 +2,6 @@
 #define SEM_PROPERTY_LIST_HPP
 
 #include <cstddef>
-#include <functional>
-#include <map>
 #include <memory>
 #include <string_view>
 #include <vector>
@@ -22,6 +20,11 @@ namespace sem {
 // When an object or class is created, all of its properties are laid out in
 // memory, and are used both for initialization and for memory storage, so all
 // properties must be known at that time.
+//
+// The layout of the list (the names, selectors and indexes of the properties)
+// is shared between a list and its clones. A clone only copies the property
+// values, and any properties it adds are kept in a new layout that extends the
+// original one, so a class hierarchy stores each property's layout once.
 class PropertyList {
  public:
   // Implemented as default, but defined inside cpp file.
@@ -54,17 +57,16 @@ class PropertyList {
   Property const* LookupByName(std::string_view name) const;
 
  private:
+  class Layout;
   class PropertyImpl;
 
-  PropertyList(std::vector<std::unique_ptr<PropertyImpl>> properties);
-
-  void AddToIndex(PropertyImpl* prop);
+  PropertyList(std::shared_ptr<Layout> layout,
+               std::vector<PropertyImpl> properties);
 
-  std::vector<std::unique_ptr<PropertyImpl>> properties_;
-  std::map<std::string_view, PropertyImpl*, std::less<>> name_table_;
-  std::map<SelectorTable::Entry const*, PropertyImpl*, std::less<>>
-      selector_table_;
-  std::map<PropIndex, PropertyImpl*, std::less<>> index_table_;
+  // The layout of the properties. It may be shared with other lists, in which
+  // case it must not be modified.
+  std::shared_ptr<Layout> layout_;
+  std::vector<PropertyImpl> properties_;
 };
 }  // namespace sem
 
@@ -0,0 +1,74 @@
+#include "scic/sem/property_list.hpp"
+
+#include <memory>
+#include <string_view>
+
+#include "gtest/gtest.h"
+#include "scic/sem/selector_table.hpp"
+#include "scic/sem/test_helpers.hpp"
+#include "util/status/status_matchers.hpp"
+
+namespace sem {
+namespace {
+
+class PropertyListTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto builder = SelectorTable::CreateBuilder();
+    for (auto const* name : {"x", "y", "z"}) {
+      ASSERT_OK(builder->AddNewSelector(CreateTestNameToken(name)));
+    }
+    ASSERT_OK_AND_ASSIGN(selectors_, builder->Build());
+  }
+
+  SelectorTable::Entry const* Sel(std::string_view name) const {
+    return selectors_->LookupByName(name);
+  }
+
+  std::unique_ptr<SelectorTable> selectors_;
+};
+
+TEST_F(PropertyListTest, AppendsAndUpdates) {
+  PropertyList list;
+  EXPECT_EQ(list.UpdatePropertyDef(Sel("x"), 1).value(), 0);
+  EXPECT_EQ(list.UpdatePropertyDef(Sel("y"), 2).value(), 1);
+  EXPECT_EQ(list.UpdatePropertyDef(Sel("x"), 3).value(), 0);
+
+  ASSERT_EQ(list.size(), 2);
+  EXPECT_EQ(list.LookupByName("x")->value().as<int>(), 3);
+  EXPECT_EQ(list.properties()[1].name(), "y");
+  EXPECT_EQ(list.LookupByName("z"), nullptr);
+}
+
+TEST_F(PropertyListTest, ClonesDoNotAffectEachOther) {
+  PropertyList parent;
+  parent.UpdatePropertyDef(Sel("x"), 1);
+
+  auto child = parent.Clone();
+  child.UpdatePropertyDef(Sel("x"), 2);
+  EXPECT_EQ(child.UpdatePropertyDef(Sel("y"), 3).value(), 1);
+
+  auto sibling = parent.Clone();
+  EXPECT_EQ(sibling.UpdatePropertyDef(Sel("z"), 4).value(), 1);
+
+  ASSERT_EQ(parent.size(), 1);
+  EXPECT_EQ(parent.LookupByName("x")->value().as<int>(), 1);
+  EXPECT_EQ(parent.LookupByName("y"), nullptr);
+
+  ASSERT_EQ(child.size(), 2);
+  EXPECT_EQ(child.LookupByName("x")->value().as<int>(), 2);
+  EXPECT_EQ(child.LookupByName("y")->index().value(), 1);
+  EXPECT_EQ(child.LookupByName("z"), nullptr);
+
+  ASSERT_EQ(sibling.size(), 2);
+  EXPECT_EQ(sibling.LookupByName("z")->value().as<int>(), 4);
+  EXPECT_EQ(sibling.LookupByName("y"), nullptr);
+
+  // Properties added to the parent after cloning don't show up in clones.
+  parent.UpdatePropertyDef(Sel("y"), 5);
+  EXPECT_EQ(parent.LookupByName("y")->value().as<int>(), 5);
+  EXPECT_EQ(sibling.LookupByName("y"), nullptr);
+}
+
+}  // namespace
+}  // namespace sem
@@ -1,11 +1,11 @@
 #include "scic/sem/public_table.hpp"
 
 #include <cstddef>
-#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "scic/sem/class_table.hpp"
 #include "scic/sem/object_table.hpp"
 #include "scic/sem/proc_table.hpp"
@@ -38,8 +38,9 @@ class PublicTableEntryImpl : public PublicTable::Entry {
 
 class PublicTableImpl : public PublicTable {
  public:
-  PublicTableImpl(std::vector<std::unique_ptr<PublicTableEntryImpl>> entries,
-                  std::map<std::size_t, PublicTableEntryImpl const*> index_map)
+  PublicTableImpl(
+      std::vector<std::unique_ptr<PublicTableEntryImpl>> entries,
+      absl::flat_hash_map<std::size_t, PublicTableEntryImpl const*> index_map)
       : entries_(std::move(entries)), index_map_(std::move(index_map)) {}
 
   util::Seq<Entry const&> entries() const override {
@@ -55,7 +56,7 @@ class PublicTableImpl : public PublicTable {
 
  private:
   std::vector<std::unique_ptr<PublicTableEntryImpl>> entries_;
-  std::map<std::size_t, PublicTableEntryImpl const*> index_map_;
+  absl::flat_hash_map<std::size_t, PublicTableEntryImpl const*> index_map_;
 };
 
 class PublicTableBuilderImpl : public PublicTableBuilder {
@@ -89,7 +90,7 @@ class PublicTableBuilderImpl : public PublicTableBuilder {
     return status::OkStatus();
   }
   std::vector<std::unique_ptr<PublicTableEntryImpl>> entries_;
-  std::map<std::size_t, PublicTableEntryImpl const*> index_map_;
+  absl::flat_hash_map<std::size_t, PublicTableEntryImpl const*> index_map_;
 };
 }  // namespace
 
@@ -2,9 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <limits>
-#include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -12,6 +10,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_format.h"
 #include "scic/parsers/sci/ast.hpp"
 #include "scic/sem/common.hpp"
@@ -51,8 +50,8 @@ class SelectorTableImpl : public SelectorTable {
  public:
   SelectorTableImpl(
       std::vector<std::unique_ptr<EntryImpl>> entries,
-      std::map<SelectorNum, EntryImpl const*> table,
-      std::map<std::string_view, EntryImpl const*, std::less<>> name_map)
+      absl::flat_hash_map<SelectorNum, EntryImpl const*> table,
+      NameMap<EntryImpl const*> name_map)
       : entries_(std::move(entries)),
         table_(std::move(table)),
         name_map_(std::move(name_map)) {}
@@ -80,8 +79,8 @@ class SelectorTableImpl : public SelectorTable {
  private:
   std::vector<std::unique_ptr<EntryImpl>> entries_;
   // Map from selector numbers to selector entries. Owns the entries.
-  std::map<SelectorNum, EntryImpl const*> table_;
-  std::map<std::string_view, EntryImpl const*, std::less<>> name_map_;
+  absl::flat_hash_map<SelectorNum, EntryImpl const*> table_;
+  NameMap<EntryImpl const*> name_map_;
 };
 
 class BuilderImpl : public SelectorTable::Builder {
@@ -160,9 +159,9 @@ class BuilderImpl : public SelectorTable::Builder {
 
  private:
   std::vector<std::unique_ptr<EntryImpl>> entries_;
-  std::map<SelectorNum, EntryImpl const*> num_map_;
+  absl::flat_hash_map<SelectorNum, EntryImpl const*> num_map_;
   std::vector<EntryImpl*> new_selectors_;
-  std::map<std::string_view, EntryImpl const*, std::less<>> name_map_;
+  NameMap<EntryImpl const*> name_map_;
 };
 
 }  // namespace
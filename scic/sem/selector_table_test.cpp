@@ -1,5 +1,7 @@
 #include "scic/sem/selector_table.hpp"
 
+#include <string_view>
+
 #include "gtest/gtest.h"
 #include "scic/sem/common.hpp"
 #include "scic/sem/test_helpers.hpp"
@@ -32,5 +34,19 @@ TEST(SelectorTableTest, RepeatedDeclIsOkay) {
                                      SelectorNum::Create(4096)));
   ASSERT_OK_AND_ASSIGN(auto table, builder->Build());
 }
+
+TEST(SelectorTableTest, LookupAllByName) {
+  auto builder = SelectorTable::CreateBuilder();
+  ASSERT_OK(builder->AddNewSelector(CreateTestNameToken("hello")));
+  ASSERT_OK(builder->AddNewSelector(CreateTestNameToken("goodbye")));
+  ASSERT_OK_AND_ASSIGN(auto table, builder->Build());
+
+  std::string_view const names[] = {"goodbye", "missing", "hello"};
+  auto results = LookupAllByName(*table, names);
+  ASSERT_EQ(results.size(), 3);
+  EXPECT_EQ(results[0]->name(), "goodbye");
+  EXPECT_EQ(results[1], nullptr);
+  EXPECT_EQ(results[2]->name(), "hello");
+}
 }  // namespace
 }  // namespace sem
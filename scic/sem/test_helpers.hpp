@@ -1,9 +1,15 @@
 #ifndef SEM_TEST_HELPERS_HPP
 #define SEM_TEST_HELPERS_HPP
 
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
+#include "scic/parsers/list_tree/parser_test_utils.hpp"
+#include "scic/parsers/sci/ast.hpp"
+#include "scic/parsers/sci/parser.hpp"
 #include "scic/sem/common.hpp"
 #include "scic/text/text_range.hpp"
 #include "util/strings/ref_str.hpp"
@@ -13,5 +19,14 @@ inline NameToken CreateTestNameToken(std::string_view name) {
   return NameToken(util::RefStr(name),
                    text::TextRange::OfString(std::string(name)));
 }
+
+inline std::vector<ast::Item> ParseItemsOrDie(std::string_view text) {
+  auto exprs = parsers::list_tree::ParseExprsOrDie(text);
+  auto result = parsers::sci::ParseItems(exprs);
+  if (!result.ok()) {
+    throw std::runtime_error("Failed to parse items");
+  }
+  return std::move(result).value();
+}
 }  // namespace sem
-#endif
\ No newline at end of file
+#endif
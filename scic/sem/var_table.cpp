@@ -1,13 +1,12 @@
 #include "scic/sem/var_table.hpp"
 
 #include <cstddef>
-#include <functional>
-#include <map>
 #include <memory>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "scic/codegen/code_generator.hpp"
 #include "scic/sem/common.hpp"
 #include "scic/status/status.hpp"
@@ -44,8 +43,8 @@ class VarTableImpl : public VarTable {
  public:
   VarTableImpl(
       std::vector<std::unique_ptr<VariableImpl>> entries,
-      std::map<ModuleVarIndex, VariableImpl const*, std::less<>> index_table,
-      std::map<std::string_view, VariableImpl const*, std::less<>> name_map)
+      absl::flat_hash_map<ModuleVarIndex, VariableImpl const*> index_table,
+      NameMap<VariableImpl const*> name_map)
       : entries_(std::move(entries)),
         index_table_(std::move(index_table)),
         name_map_(std::move(name_map)) {}
@@ -66,8 +65,8 @@ class VarTableImpl : public VarTable {
 
  private:
   std::vector<std::unique_ptr<VariableImpl>> entries_;
-  std::map<ModuleVarIndex, VariableImpl const*, std::less<>> index_table_;
-  std::map<std::string_view, VariableImpl const*, std::less<>> name_map_;
+  absl::flat_hash_map<ModuleVarIndex, VariableImpl const*> index_table_;
+  NameMap<VariableImpl const*> name_map_;
 };
 
 class VarTableBuilderImpl : public VarTableBuilder {
@@ -95,8 +94,8 @@ class VarTableBuilderImpl : public VarTableBuilder {
 
  private:
   std::vector<std::unique_ptr<VariableImpl>> entries_;
-  std::map<ModuleVarIndex, VariableImpl const*, std::less<>> index_table_;
-  std::map<std::string_view, VariableImpl const*, std::less<>> name_map_;
+  absl::flat_hash_map<ModuleVarIndex, VariableImpl const*> index_table_;
+  NameMap<VariableImpl const*> name_map_;
 };
 
 // --------------------------
@@ -121,8 +120,8 @@ class GlobalDeclTableImpl : public VarDeclTable {
  public:
   GlobalDeclTableImpl(
       std::vector<std::unique_ptr<DeclVariableImpl>> entries,
-      std::map<GlobalIndex, DeclVariableImpl const*, std::less<>> index_table,
-      std::map<std::string_view, DeclVariableImpl const*, std::less<>> name_map)
+      absl::flat_hash_map<GlobalIndex, DeclVariableImpl const*> index_table,
+      NameMap<DeclVariableImpl const*> name_map)
       : entries_(std::move(entries)),
         index_table_(std::move(index_table)),
         name_table_(std::move(name_map)) {}
@@ -145,8 +144,8 @@ class GlobalDeclTableImpl : public VarDeclTable {
 
  private:
   std::vector<std::unique_ptr<DeclVariableImpl>> entries_;
-  std::map<GlobalIndex, DeclVariableImpl const*, std::less<>> index_table_;
-  std::map<std::string_view, DeclVariableImpl const*, std::less<>> name_table_;
+  absl::flat_hash_map<GlobalIndex, DeclVariableImpl const*> index_table_;
+  NameMap<DeclVariableImpl const*> name_table_;
 };
 
 class VarDeclTableBuilderImpl : public VarDeclTableBuilder {
@@ -181,8 +180,8 @@ class VarDeclTableBuilderImpl : public VarDeclTableBuilder {
 
  private:
   std::vector<std::unique_ptr<DeclVariableImpl>> entries_;
-  std::map<GlobalIndex, DeclVariableImpl const*, std::less<>> index_table_;
-  std::map<std::string_view, DeclVariableImpl const*, std::less<>> name_table_;
+  absl::flat_hash_map<GlobalIndex, DeclVariableImpl const*> index_table_;
+  NameMap<DeclVariableImpl const*> name_table_;
 };
 
 }  // namespace
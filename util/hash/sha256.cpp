@@ -0,0 +1,147 @@
+#include "util/hash/sha256.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace util {
+namespace {
+
+constexpr std::array<std::uint32_t, 64> kRoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr std::array<std::uint32_t, 8> kInitialState = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+}  // namespace
+
+Sha256::Sha256() : state_(kInitialState) {}
+
+void Sha256::Update(std::string_view data) {
+  total_size_ += data.size();
+  while (!data.empty()) {
+    std::size_t amount = std::min(data.size(), buffer_.size() - buffer_size_);
+    for (std::size_t i = 0; i < amount; ++i) {
+      buffer_[buffer_size_ + i] = std::uint8_t(data[i]);
+    }
+    buffer_size_ += amount;
+    data.remove_prefix(amount);
+    if (buffer_size_ == buffer_.size()) {
+      ProcessBlock(buffer_.data());
+      buffer_size_ = 0;
+    }
+  }
+}
+
+Sha256::Digest Sha256::Finish() && {
+  std::uint64_t total_bits = total_size_ * 8;
+
+  // Pad with a single 1 bit, then zeros until there are 8 bytes left in the
+  // block, then the message length in bits.
+  buffer_[buffer_size_++] = 0x80;
+  if (buffer_size_ > 56) {
+    while (buffer_size_ < 64) {
+      buffer_[buffer_size_++] = 0;
+    }
+    ProcessBlock(buffer_.data());
+    buffer_size_ = 0;
+  }
+  while (buffer_size_ < 56) {
+    buffer_[buffer_size_++] = 0;
+  }
+  for (int i = 7; i >= 0; --i) {
+    buffer_[buffer_size_++] = std::uint8_t(total_bits >> (i * 8));
+  }
+  ProcessBlock(buffer_.data());
+
+  Digest digest;
+  for (std::size_t i = 0; i < state_.size(); ++i) {
+    for (std::size_t j = 0; j < 4; ++j) {
+      digest[i * 4 + j] = std::uint8_t(state_[i] >> (24 - j * 8));
+    }
+  }
+  return digest;
+}
+
+std::string Sha256::FinishHex() && {
+  constexpr std::string_view kHexDigits = "0123456789abcdef";
+  auto digest = std::move(*this).Finish();
+  std::string result;
+  result.reserve(digest.size() * 2);
+  for (auto byte : digest) {
+    result.push_back(kHexDigits[byte >> 4]);
+    result.push_back(kHexDigits[byte & 0xF]);
+  }
+  return result;
+}
+
+void Sha256::ProcessBlock(std::uint8_t const* block) {
+  std::array<std::uint32_t, 64> w;
+  for (std::size_t i = 0; i < 16; ++i) {
+    w[i] = (std::uint32_t(block[i * 4]) << 24) |
+           (std::uint32_t(block[i * 4 + 1]) << 16) |
+           (std::uint32_t(block[i * 4 + 2]) << 8) |
+           std::uint32_t(block[i * 4 + 3]);
+  }
+  for (std::size_t i = 16; i < 64; ++i) {
+    auto s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^
+              (w[i - 15] >> 3);
+    auto s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^
+              (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  auto [a, b, c, d, e, f, g, h] = state_;
+  for (std::size_t i = 0; i < 64; ++i) {
+    auto s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+    auto ch = (e & f) ^ (~e & g);
+    auto temp1 = h + s1 + ch + kRoundConstants[i] + w[i];
+    auto s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+    auto maj = (a & b) ^ (a & c) ^ (b & c);
+    auto temp2 = s0 + maj;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+
+  state_[0] += a;
+  state_[1] += b;
+  state_[2] += c;
+  state_[3] += d;
+  state_[4] += e;
+  state_[5] += f;
+  state_[6] += g;
+  state_[7] += h;
+}
+
+std::string Sha256Hex(std::string_view data) {
+  Sha256 hasher;
+  hasher.Update(data);
+  return std::move(hasher).FinishHex();
+}
+
+}  // namespace util
@@ -0,0 +1,46 @@
+#ifndef UTIL_HASH_SHA256_HPP
+#define UTIL_HASH_SHA256_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// An incremental SHA-256 hasher.
+//
+// Unlike absl::Hash, the result is stable across processes and machines, so
+// it is suitable for content hashes that are written to disk.
+class Sha256 {
+ public:
+  using Digest = std::array<std::uint8_t, 32>;
+
+  Sha256();
+
+  // Appends data to the hashed message.
+  void Update(std::string_view data);
+
+  // Finishes the hash, returning the digest. The hasher must not be used
+  // afterwards.
+  Digest Finish() &&;
+
+  // Finishes the hash, returning the digest as a lowercase hex string.
+  std::string FinishHex() &&;
+
+ private:
+  void ProcessBlock(std::uint8_t const* block);
+
+  std::array<std::uint32_t, 8> state_;
+  std::array<std::uint8_t, 64> buffer_;
+  std::size_t buffer_size_ = 0;
+  std::uint64_t total_size_ = 0;
+};
+
+// Returns the SHA-256 digest of the data as a lowercase hex string.
+std::string Sha256Hex(std::string_view data);
+
+}  // namespace util
+
+#endif
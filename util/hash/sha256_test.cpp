@@ -0,0 +1,39 @@
+#include "util/hash/sha256.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace util {
+namespace {
+
+TEST(Sha256Test, EmptyString) {
+  EXPECT_EQ(Sha256Hex(""),
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+}
+
+TEST(Sha256Test, ShortString) {
+  EXPECT_EQ(Sha256Hex("abc"),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(Sha256Test, MultiBlockString) {
+  EXPECT_EQ(
+      Sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+TEST(Sha256Test, IncrementalUpdatesMatchSingleUpdate) {
+  std::string data(1000, 'x');
+  Sha256 hasher;
+  for (std::size_t i = 0; i < data.size(); i += 7) {
+    hasher.Update(std::string_view(data).substr(i, 7));
+  }
+  EXPECT_EQ(std::move(hasher).FinishHex(), Sha256Hex(data));
+}
+
+}  // namespace
+}  // namespace util